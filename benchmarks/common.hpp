@@ -0,0 +1,45 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
+
+// the timing every benchmark shares, a scenario runs a baseline and a candidate and prints the medians of both
+
+const size_t repetitionCount = 15;
+
+[[nodiscard]] inline double measureMedian(const std::function<void()> &run) {
+	std::vector<double> durations(repetitionCount);
+
+	for (auto &duration : durations) {
+		const auto startTimePoint = std::chrono::steady_clock::now();
+		run();
+		duration = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTimePoint).count();
+	}
+
+	std::nth_element(durations.begin(), durations.begin() + static_cast<std::ptrdiff_t>(durations.size() / 2), durations.end());
+
+	return durations[durations.size() / 2];
+}
+
+inline void printHeader(std::string_view baselineName, std::string_view candidateName) {
+	fmt::print("{:<28} {:>12} {:>12} {:>10}\n", "scenario", fmt::format("{} ms", baselineName), fmt::format("{} ms", candidateName), "speedup");
+}
+
+// the speedup is how many times faster the candidate runs than the baseline
+inline void report(std::string_view name, const std::function<void()> &runBaseline, const std::function<void()> &runCandidate) {
+	const auto baselineDuration = measureMedian(runBaseline);
+	const auto candidateDuration = measureMedian(runCandidate);
+
+	fmt::print("{:<28} {:>12.3f} {:>12.3f} {:>9.2f}x\n", name, baselineDuration, candidateDuration, baselineDuration / candidateDuration);
+}
+
+// for a candidate the machine can not run
+inline void reportBaseline(std::string_view name, const std::function<void()> &runBaseline) {
+	fmt::print("{:<28} {:>12.3f} {:>12} {:>10}\n", name, measureMedian(runBaseline), "-", "-");
+}
@@ -0,0 +1,350 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include <fmt/format.h>
+
+#include <vulkan/vulkan.hpp>
+
+#include "common.hpp"
+
+VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
+
+// compares writing descriptors through vkUpdateDescriptorSets into an update-after-bind set against vkGetDescriptorEXT
+// into a mapped descriptor buffer, one descriptor per call like the descriptor heap of contextVK does,
+// runs on the software ICD when there is one so that the numbers measure the CPU side only
+
+const uint32_t descriptorCount = 4096;
+
+[[nodiscard]] PFN_vkGetInstanceProcAddr loadVulkan() {
+#if defined(_WIN32)
+	auto library = LoadLibraryA("vulkan-1.dll");
+	if ( ! library) {
+		throw std::runtime_error{"Unable to load vulkan-1.dll"};
+	}
+
+	return reinterpret_cast<PFN_vkGetInstanceProcAddr>(GetProcAddress(library, "vkGetInstanceProcAddr"));
+#else
+	auto library = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+	if ( ! library) {
+		throw std::runtime_error{"Unable to load libvulkan.so.1"};
+	}
+
+	return reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(library, "vkGetInstanceProcAddr"));
+#endif
+}
+
+// the CPU device first, it has no GPU work that could hide the cost of the calls
+[[nodiscard]] vk::PhysicalDevice choosePhysicalDevice(vk::Instance instance) {
+	auto physicalDevices = instance.enumeratePhysicalDevices();
+
+	std::erase_if(physicalDevices, [] (vk::PhysicalDevice physicalDevice) {
+		return physicalDevice.getProperties().apiVersion < VK_API_VERSION_1_3;
+	});
+
+	if (physicalDevices.empty()) {
+		throw std::runtime_error{"No Vulkan 1.3 device"};
+	}
+
+	auto cpu = std::find_if(physicalDevices.begin(), physicalDevices.end(), [] (vk::PhysicalDevice physicalDevice) {
+		return physicalDevice.getProperties().deviceType == vk::PhysicalDeviceType::eCpu;
+	});
+
+	return cpu != physicalDevices.end() ? *cpu : physicalDevices.front();
+}
+
+[[nodiscard]] bool supportsDescriptorBuffer(vk::PhysicalDevice physicalDevice) {
+	const auto extensions = physicalDevice.enumerateDeviceExtensionProperties();
+
+	const bool hasExtension = std::any_of(extensions.begin(), extensions.end(), [] (const vk::ExtensionProperties &extension) {
+		return std::string_view{extension.extensionName} == "VK_EXT_descriptor_buffer";
+	});
+
+	return hasExtension && physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorBufferFeaturesEXT>().get<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>().descriptorBuffer;
+}
+
+[[nodiscard]] vk::UniqueDevice createDevice(vk::PhysicalDevice physicalDevice, bool descriptorBuffer) {
+	const float priority = 1.0f;
+	const vk::DeviceQueueCreateInfo queueCreateInfo{
+		.queueFamilyIndex = 0,
+		.queueCount = 1,
+		.pQueuePriorities = &priority,
+	};
+
+	std::vector<const char *> extensions{};
+	if (descriptorBuffer) {
+		extensions.push_back("VK_EXT_descriptor_buffer");
+	}
+
+	vk::StructureChain deviceCreateInfo{
+		vk::DeviceCreateInfo{
+			.queueCreateInfoCount = 1,
+			.pQueueCreateInfos = &queueCreateInfo,
+			.enabledExtensionCount = static_cast<uint32_t>(extensions.size()),
+			.ppEnabledExtensionNames = extensions.data(),
+		},
+		vk::PhysicalDeviceVulkan12Features{
+			.descriptorBindingSampledImageUpdateAfterBind = true,
+			.descriptorBindingUpdateUnusedWhilePending = true,
+			.descriptorBindingPartiallyBound = true,
+			.runtimeDescriptorArray = true,
+			.bufferDeviceAddress = true,
+		},
+		vk::PhysicalDeviceDescriptorBufferFeaturesEXT{
+			.descriptorBuffer = true,
+		},
+	};
+
+	if ( ! descriptorBuffer) {
+		deviceCreateInfo.unlink<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+	}
+
+	auto device = physicalDevice.createDeviceUnique(deviceCreateInfo.get());
+
+	VULKAN_HPP_DEFAULT_DISPATCHER.init(device.get());
+
+	return device;
+}
+
+[[nodiscard]] uint32_t findMemoryType(vk::PhysicalDevice physicalDevice, uint32_t memoryTypeBits, vk::MemoryPropertyFlags flags) {
+	const auto memoryProperties = physicalDevice.getMemoryProperties();
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((memoryTypeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags) {
+			return i;
+		}
+	}
+
+	throw std::runtime_error{fmt::format("No memory type with {}", vk::to_string(flags))};
+}
+
+// the same two bindings as the heap of contextVK uses for sampled images and samplers
+[[nodiscard]] vk::UniqueDescriptorSetLayout createSetLayout(vk::Device device, bool descriptorBuffer) {
+	const std::array bindings{
+		vk::DescriptorSetLayoutBinding{
+			.binding = 0,
+			.descriptorType = vk::DescriptorType::eSampledImage,
+			.descriptorCount = descriptorCount,
+			.stageFlags = vk::ShaderStageFlagBits::eAll,
+		},
+		vk::DescriptorSetLayoutBinding{
+			.binding = 1,
+			.descriptorType = vk::DescriptorType::eSampler,
+			.descriptorCount = descriptorCount,
+			.stageFlags = vk::ShaderStageFlagBits::eAll,
+		},
+	};
+
+	const std::array<vk::DescriptorBindingFlags, bindings.size()> bindingFlags{
+		vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending,
+		vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending,
+	};
+
+	vk::StructureChain setLayoutCreateInfo{
+		vk::DescriptorSetLayoutCreateInfo{
+			.flags = descriptorBuffer ? vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT : vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+			.bindingCount = static_cast<uint32_t>(bindings.size()),
+			.pBindings = bindings.data(),
+		},
+		vk::DescriptorSetLayoutBindingFlagsCreateInfo{
+			.bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+			.pBindingFlags = bindingFlags.data(),
+		},
+	};
+
+	if (descriptorBuffer) {
+		setLayoutCreateInfo.unlink<vk::DescriptorSetLayoutBindingFlagsCreateInfo>();
+	}
+
+	return device.createDescriptorSetLayoutUnique(setLayoutCreateInfo.get());
+}
+
+int main() {
+	VULKAN_HPP_DEFAULT_DISPATCHER.init(loadVulkan());
+
+	const vk::ApplicationInfo applicationInfo{
+		.pApplicationName = "descriptorUpdate",
+		.apiVersion = VK_API_VERSION_1_3,
+	};
+	auto instance = vk::createInstanceUnique({
+		.pApplicationInfo = &applicationInfo,
+	});
+
+	VULKAN_HPP_DEFAULT_DISPATCHER.init(instance.get());
+
+	const auto physicalDevice = choosePhysicalDevice(instance.get());
+	const bool descriptorBuffer = supportsDescriptorBuffer(physicalDevice);
+
+	auto device = createDevice(physicalDevice, descriptorBuffer);
+
+	// one image and one sampler written into every slot, the cost is in encoding and writing the descriptors
+	auto image = device->createImageUnique({
+		.imageType = vk::ImageType::e2D,
+		.format = vk::Format::eR8G8B8A8Unorm,
+		.extent = { 1, 1, 1 },
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.samples = vk::SampleCountFlagBits::e1,
+		.tiling = vk::ImageTiling::eOptimal,
+		.usage = vk::ImageUsageFlagBits::eSampled,
+		.sharingMode = vk::SharingMode::eExclusive,
+		.initialLayout = vk::ImageLayout::eUndefined,
+	});
+	const auto imageMemoryRequirements = device->getImageMemoryRequirements(image.get());
+	auto imageMemory = device->allocateMemoryUnique({
+		.allocationSize = imageMemoryRequirements.size,
+		.memoryTypeIndex = findMemoryType(physicalDevice, imageMemoryRequirements.memoryTypeBits, {}),
+	});
+	device->bindImageMemory(image.get(), imageMemory.get(), 0);
+
+	auto imageView = device->createImageViewUnique({
+		.image = image.get(),
+		.viewType = vk::ImageViewType::e2D,
+		.format = vk::Format::eR8G8B8A8Unorm,
+		.subresourceRange = {
+			.aspectMask = vk::ImageAspectFlagBits::eColor,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+	});
+
+	auto sampler = device->createSamplerUnique({
+		.magFilter = vk::Filter::eLinear,
+		.minFilter = vk::Filter::eLinear,
+	});
+
+	const vk::DescriptorImageInfo imageInfo{
+		.imageView = imageView.get(),
+		.imageLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+	};
+	const vk::DescriptorImageInfo samplerInfo{
+		.sampler = sampler.get(),
+	};
+
+	// pool path
+	auto poolSetLayout = createSetLayout(device.get(), false);
+
+	const std::array poolSizes{
+		vk::DescriptorPoolSize{ .type = vk::DescriptorType::eSampledImage, .descriptorCount = descriptorCount },
+		vk::DescriptorPoolSize{ .type = vk::DescriptorType::eSampler, .descriptorCount = descriptorCount },
+	};
+	auto descriptorPool = device->createDescriptorPoolUnique({
+		.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+		.maxSets = 1,
+		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+		.pPoolSizes = poolSizes.data(),
+	});
+
+	const auto poolSetLayoutHandle = poolSetLayout.get();
+	const auto descriptorSet = device->allocateDescriptorSets({
+		.descriptorPool = descriptorPool.get(),
+		.descriptorSetCount = 1,
+		.pSetLayouts = &poolSetLayoutHandle,
+	})[0];
+
+	const auto updateDescriptorSets = [&] (uint32_t binding, vk::DescriptorType descriptorType, const vk::DescriptorImageInfo &info) {
+		for (uint32_t index = 0; index < descriptorCount; index++) {
+			device->updateDescriptorSets({
+				vk::WriteDescriptorSet{
+					.dstSet = descriptorSet,
+					.dstBinding = binding,
+					.dstArrayElement = index,
+					.descriptorCount = 1,
+					.descriptorType = descriptorType,
+					.pImageInfo = &info,
+				},
+			}, {});
+		}
+	};
+
+	// descriptor buffer path, host visible like the heap of contextVK
+	vk::UniqueDescriptorSetLayout bufferSetLayout{};
+	vk::UniqueBuffer buffer{};
+	vk::UniqueDeviceMemory bufferMemory{};
+	std::byte *mappedData = nullptr;
+	std::array<vk::DeviceSize, 2> bindingOffsets{};
+	vk::PhysicalDeviceDescriptorBufferPropertiesEXT descriptorBufferProperties{};
+
+	if (descriptorBuffer) {
+		descriptorBufferProperties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorBufferPropertiesEXT>().get<vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+
+		bufferSetLayout = createSetLayout(device.get(), true);
+
+		for (uint32_t binding = 0; binding < bindingOffsets.size(); binding++) {
+			bindingOffsets[binding] = device->getDescriptorSetLayoutBindingOffsetEXT(bufferSetLayout.get(), binding);
+		}
+
+		buffer = device->createBufferUnique({
+			.size = device->getDescriptorSetLayoutSizeEXT(bufferSetLayout.get()),
+			.usage = vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+			.sharingMode = vk::SharingMode::eExclusive,
+		});
+
+		const auto bufferMemoryRequirements = device->getBufferMemoryRequirements(buffer.get());
+		vk::StructureChain memoryAllocateInfo{
+			vk::MemoryAllocateInfo{
+				.allocationSize = bufferMemoryRequirements.size,
+				.memoryTypeIndex = findMemoryType(physicalDevice, bufferMemoryRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent),
+			},
+			vk::MemoryAllocateFlagsInfo{
+				.flags = vk::MemoryAllocateFlagBits::eDeviceAddress,
+			},
+		};
+		bufferMemory = device->allocateMemoryUnique(memoryAllocateInfo.get());
+		device->bindBufferMemory(buffer.get(), bufferMemory.get(), 0);
+
+		mappedData = static_cast<std::byte *>(device->mapMemory(bufferMemory.get(), 0, VK_WHOLE_SIZE));
+	}
+
+	const auto getDescriptors = [&] (uint32_t binding, vk::DescriptorType descriptorType, vk::DescriptorDataEXT data, size_t descriptorSize) {
+		for (uint32_t index = 0; index < descriptorCount; index++) {
+			device->getDescriptorEXT({
+				.type = descriptorType,
+				.data = data,
+			}, descriptorSize, mappedData + bindingOffsets[binding] + index * descriptorSize);
+		}
+	};
+
+	const auto reportScenario = [&] (std::string_view name, const std::function<void()> &runPool, const std::function<void()> &runBuffer) {
+		if (descriptorBuffer) {
+			report(name, runPool, runBuffer);
+		} else {
+			reportBaseline(name, runPool);
+		}
+	};
+
+	fmt::print("{} ({}), {} descriptor(s) per run, median of {} runs\n", std::string_view{physicalDevice.getProperties().deviceName}, vk::to_string(physicalDevice.getProperties().deviceType), descriptorCount, repetitionCount);
+	if ( ! descriptorBuffer) {
+		fmt::print("VK_EXT_descriptor_buffer is not supported, only the pool path runs\n");
+	}
+	printHeader("pool", "buffer");
+
+	reportScenario("sampled images", [&] {
+		updateDescriptorSets(0, vk::DescriptorType::eSampledImage, imageInfo);
+	}, [&] {
+		getDescriptors(0, vk::DescriptorType::eSampledImage, { .pSampledImage = &imageInfo }, descriptorBufferProperties.sampledImageDescriptorSize);
+	});
+
+	reportScenario("samplers", [&] {
+		updateDescriptorSets(1, vk::DescriptorType::eSampler, samplerInfo);
+	}, [&] {
+		getDescriptors(1, vk::DescriptorType::eSampler, { .pSampler = &samplerInfo.sampler }, descriptorBufferProperties.samplerDescriptorSize);
+	});
+
+	device->waitIdle();
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <tracy/Tracy.hpp>
+
+#include <util/jobSystem.hpp>
+#include <util/streamCopy.hpp>
+
+#include "common.hpp"
+
+// compares the serial std::copy_n of every draw list the imgui pass used to do against util::streamCopyParallel,
+// the destination is plain memory here, on write-combined mappings the streaming stores matter more
+
+const size_t minCopyJobSize = 64 * 1024;
+
+// the layout of ImDrawVert and a 16 bit ImDrawIdx
+struct Vertex {
+	float position[2];
+	float uv[2];
+	uint32_t color;
+};
+
+using Index = uint16_t;
+
+struct DrawList {
+	std::vector<Vertex> vertices;
+	std::vector<Index> indices;
+};
+
+// quads like imgui emits them, four vertices and six indices each
+[[nodiscard]] std::vector<DrawList> createDrawLists(size_t listCount, size_t quadCount) {
+	std::vector<DrawList> drawLists(listCount);
+
+	for (auto &drawList : drawLists) {
+		drawList.vertices.resize(quadCount * 4);
+		drawList.indices.resize(quadCount * 6);
+
+		for (size_t i = 0; i < drawList.vertices.size(); i++) {
+			drawList.vertices[i] = Vertex{
+				.position = { static_cast<float>(i), static_cast<float>(i / 4) },
+				.uv = { 0.0f, 0.0f },
+				.color = static_cast<uint32_t>(i),
+			};
+		}
+
+		for (size_t i = 0; i < drawList.indices.size(); i++) {
+			drawList.indices[i] = static_cast<Index>(i / 6 * 4 + std::array{ 0, 1, 2, 0, 2, 3 }[i % 6]);
+		}
+	}
+
+	return drawLists;
+}
+
+void benchmarkUpload(util::JobSystem &jobs, std::string_view name, size_t listCount, size_t quadCount) {
+	const auto drawLists = createDrawLists(listCount, quadCount);
+
+	const size_t vertexCount = listCount * quadCount * 4;
+	const size_t indexCount = listCount * quadCount * 6;
+
+	// vertices first and indices 16 byte aligned after them, like in the geometry ring
+	const size_t indexStart = (vertexCount * sizeof(Vertex) + 15) / 16 * 16;
+	std::vector<std::byte> serialDestination(indexStart + indexCount * sizeof(Index));
+	std::vector<std::byte> parallelDestination(serialDestination.size());
+
+	report(fmt::format("{} {}x{} quads", name, listCount, quadCount), [&] {
+		auto *vertexMappedData = reinterpret_cast<Vertex *>(serialDestination.data());
+		auto *indexMappedData = reinterpret_cast<Index *>(serialDestination.data() + indexStart);
+
+		for (const auto &drawList : drawLists) {
+			vertexMappedData = std::copy_n(drawList.vertices.data(), drawList.vertices.size(), vertexMappedData);
+			indexMappedData = std::copy_n(drawList.indices.data(), drawList.indices.size(), indexMappedData);
+		}
+	}, [&] {
+		std::vector<util::CopySegment> segments{};
+		segments.reserve(drawLists.size() * 2);
+
+		auto *vertexDestination = parallelDestination.data();
+		auto *indexDestination = parallelDestination.data() + indexStart;
+
+		for (const auto &drawList : drawLists) {
+			const auto vertexSize = drawList.vertices.size() * sizeof(Vertex);
+			const auto indexSize = drawList.indices.size() * sizeof(Index);
+
+			segments.push_back(util::CopySegment{
+				.destination = vertexDestination,
+				.source = reinterpret_cast<const std::byte *>(drawList.vertices.data()),
+				.size = vertexSize,
+			});
+			segments.push_back(util::CopySegment{
+				.destination = indexDestination,
+				.source = reinterpret_cast<const std::byte *>(drawList.indices.data()),
+				.size = indexSize,
+			});
+
+			vertexDestination += vertexSize;
+			indexDestination += indexSize;
+		}
+
+		util::streamCopyParallel(jobs, segments, minCopyJobSize);
+	});
+
+	if (serialDestination != parallelDestination) {
+		fmt::print("{} uploads differ\n", name);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	const size_t workerCount = argc > 1 ? std::stoul(argv[1]) : std::max(std::thread::hardware_concurrency(), 1u) - 1;
+
+	util::JobSystem jobs{workerCount};
+
+	fmt::print("{} worker(s) and the main thread, median of {} runs\n", jobs.size(), repetitionCount);
+	printHeader("serial", "parallel");
+
+	// a few small windows, stays below the job size and runs on the calling thread
+	benchmarkUpload(jobs, "windows", 8, 500);
+	// the demo window and the statistics
+	benchmarkUpload(jobs, "demo", 32, 4'000);
+	// a table with tens of thousands of rows, nearly everything in one list
+	benchmarkUpload(jobs, "table", 1, 400'000);
+	benchmarkUpload(jobs, "tables", 4, 200'000);
+
+	return EXIT_SUCCESS;
+}
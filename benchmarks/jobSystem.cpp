@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <numeric>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <tracy/Tracy.hpp>
+
+#include <util/jobSystem.hpp>
+
+#include "common.hpp"
+
+// compares util::JobSystem against one std::async task per job for the shapes of work the renderer hands out
+
+[[nodiscard]] double busyWork(size_t iterations) {
+	double value = 0.0;
+
+	for (size_t i = 0; i < iterations; i++) {
+		value += std::sqrt(static_cast<double>(i));
+	}
+
+	return value;
+}
+
+// many tiny independent jobs, the overhead of a job dominates
+void benchmarkFanOut(util::JobSystem &jobs, size_t jobCount, size_t iterations) {
+	std::vector<double> results(jobCount);
+
+	report(fmt::format("fan-out {}x{}", jobCount, iterations), [&] {
+		std::vector<std::future<void>> futures{};
+		futures.reserve(jobCount);
+
+		for (size_t i = 0; i < jobCount; i++) {
+			futures.push_back(std::async(std::launch::async, [&results, i, iterations] {
+				results[i] = busyWork(iterations);
+			}));
+		}
+
+		for (auto &future : futures) {
+			future.get();
+		}
+	}, [&] {
+		util::JobCounter counter{};
+
+		for (size_t i = 0; i < jobCount; i++) {
+			jobs.run("fan-out", counter, [&results, i, iterations] {
+				results[i] = busyWork(iterations);
+			});
+		}
+
+		jobs.wait(counter);
+	});
+}
+
+[[nodiscard]] double sumJobs(util::JobSystem &jobs, std::span<const double> values, size_t leafSize) {
+	if (values.size() <= leafSize) {
+		return std::accumulate(values.begin(), values.end(), 0.0);
+	}
+
+	const auto half = values.size() / 2;
+	double left = 0.0;
+	util::JobCounter counter{};
+
+	jobs.run("fork-join", counter, [&] {
+		left = sumJobs(jobs, values.first(half), leafSize);
+	});
+
+	// the right half runs inline, waiting executes other jobs instead of blocking the worker
+	const double right = sumJobs(jobs, values.subspan(half), leafSize);
+	jobs.wait(counter);
+
+	return left + right;
+}
+
+[[nodiscard]] double sumAsync(std::span<const double> values, size_t leafSize) {
+	if (values.size() <= leafSize) {
+		return std::accumulate(values.begin(), values.end(), 0.0);
+	}
+
+	const auto half = values.size() / 2;
+	auto left = std::async(std::launch::async, [=] {
+		return sumAsync(values.first(half), leafSize);
+	});
+	const double right = sumAsync(values.subspan(half), leafSize);
+
+	return left.get() + right;
+}
+
+// recursive splitting with nested waits, std::async blocks a thread per pending split
+void benchmarkForkJoin(util::JobSystem &jobs, size_t valueCount, size_t leafSize) {
+	std::vector<double> values(valueCount);
+	std::iota(values.begin(), values.end(), 0.0);
+
+	double jobsSum = 0.0;
+	double asyncSum = 0.0;
+
+	report(fmt::format("fork-join {}/{}", valueCount, leafSize), [&] {
+		asyncSum = sumAsync(values, leafSize);
+	}, [&] {
+		jobsSum = sumJobs(jobs, values, leafSize);
+	});
+
+	if (jobsSum != asyncSum) {
+		fmt::print("fork-join sums differ: {} != {}\n", jobsSum, asyncSum);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	const size_t workerCount = argc > 1 ? std::stoul(argv[1]) : std::max(std::thread::hardware_concurrency(), 1u) - 1;
+
+	util::JobSystem jobs{workerCount};
+
+	fmt::print("{} worker(s) and the main thread, median of {} runs\n", jobs.size(), repetitionCount);
+	printHeader("async", "jobs");
+
+	// per-frame pass recording: a handful of coarse jobs
+	benchmarkFanOut(jobs, 4, 200'000);
+	// setup work such as shader loading: tens of medium jobs
+	benchmarkFanOut(jobs, 64, 20'000);
+	// fine grained work, where the cost of a thread per task shows
+	benchmarkFanOut(jobs, 4096, 200);
+	benchmarkForkJoin(jobs, 1 << 22, 1 << 14);
+
+	return EXIT_SUCCESS;
+}
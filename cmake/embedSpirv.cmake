@@ -0,0 +1,57 @@
+# writes OUTPUT, a header with every file of SPIRV_FILES as a constexpr uint32_t array and a table to find them by
+# file name, run as a script: cmake -DOUTPUT=<header> -DSPIRV_FILES=<a.spv;b.spv> -P embedSpirv.cmake
+
+set(ARRAYS "")
+set(ENTRIES "")
+list(LENGTH SPIRV_FILES FILE_COUNT)
+
+# eight words per line
+string(REPEAT "[0-9a-f]" 64 LINE_PATTERN)
+
+foreach(SPIRV ${SPIRV_FILES})
+	get_filename_component(FILE_NAME ${SPIRV} NAME)
+	string(MAKE_C_IDENTIFIER ${FILE_NAME} IDENTIFIER)
+
+	file(READ ${SPIRV} HEX HEX)
+	string(LENGTH "${HEX}" HEX_LENGTH)
+	math(EXPR REMAINDER "${HEX_LENGTH} % 8")
+	if (HEX_LENGTH EQUAL 0 OR NOT REMAINDER EQUAL 0)
+		message(FATAL_ERROR "SPIR-V file \"${SPIRV}\" is empty or corrupted (size: ${HEX_LENGTH} hex digits)")
+	endif ()
+
+	# glslc writes the words little endian, as the hosts we build for store them
+	string(REGEX REPLACE "(${LINE_PATTERN})" "\\1\n\t" HEX "${HEX}")
+	string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1, " WORDS "${HEX}")
+	string(REGEX REPLACE "[ \t]+\n" "\n" WORDS "${WORDS}")
+	string(STRIP "${WORDS}" WORDS)
+
+	string(APPEND ARRAYS "alignas(16) inline constexpr uint32_t ${IDENTIFIER}[] = {\n\t${WORDS}\n};\n\n")
+	string(APPEND ENTRIES "\tFile{ \"${FILE_NAME}\", ${IDENTIFIER} },\n")
+endforeach()
+
+file(WRITE ${OUTPUT}.tmp "#pragma once
+
+// generated by cmake/embedSpirv.cmake from the compiled shaders, do not edit
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace embeddedShaders {
+
+${ARRAYS}struct File {
+	std::string_view name;
+	std::span<const uint32_t> code;
+};
+
+inline constexpr std::array<File, ${FILE_COUNT}> files{
+${ENTRIES}};
+
+} // embeddedShaders
+")
+
+# only touches the header when a shader actually changed, everything including it is rebuilt otherwise, the build
+# tracks the stamp CMakeLists.txt touches after this script
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different ${OUTPUT}.tmp ${OUTPUT})
+file(REMOVE ${OUTPUT}.tmp)
@@ -0,0 +1,24 @@
+#version 450
+
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_samplerless_texture_functions : require
+
+// the descriptor heap, both layers are fetched texel by texel so no sampler is needed
+layout (set = 0, binding = 0) uniform texture2D sampledImages[];
+
+layout (push_constant) uniform PushConstant {
+	uint sceneColorIndex;
+	uint uiLayerIndex;
+} pushConstant;
+
+layout (location = 0) out vec4 outColor;
+
+void main() {
+	ivec2 texel = ivec2(gl_FragCoord.xy);
+
+	vec3 scene = texelFetch(sampledImages[pushConstant.sceneColorIndex], texel, 0).rgb;
+	// premultiplied, the layer is cleared to transparent black before imgui blends into it
+	vec4 ui = texelFetch(sampledImages[pushConstant.uiLayerIndex], texel, 0);
+
+	outColor = vec4(scene * (1.0 - ui.a) + ui.rgb, 1.0);
+}
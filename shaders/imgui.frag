@@ -1,7 +1,17 @@
 #version 450
 
-layout (set = 0, binding = 0) uniform texture2D fontTex;
-layout (set = 1, binding = 0) uniform sampler fontSampler;
+#extension GL_EXT_nonuniform_qualifier : require
+
+// the descriptor heap
+layout (set = 0, binding = 0) uniform texture2D sampledImages[];
+layout (set = 0, binding = 2) uniform sampler samplers[];
+
+layout (push_constant) uniform PushConstants {
+	vec2 scale;
+	vec2 translate;
+	uint imageIndex;
+	uint samplerIndex;
+} pushConstants;
 
 layout (location = 0) in vec2 inUV;
 layout (location = 1) in vec4 inColor;
@@ -9,5 +19,5 @@ layout (location = 1) in vec4 inColor;
 layout (location = 0) out vec4 outColor;
 
 void main() {
-	outColor = inColor * texture(sampler2D(fontTex, fontSampler), inUV);
+	outColor = inColor * texture(sampler2D(sampledImages[pushConstants.imageIndex], samplers[pushConstants.samplerIndex]), inUV);
 }
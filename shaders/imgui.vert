@@ -3,6 +3,8 @@
 layout (push_constant) uniform PushConstants {
 	vec2 scale;
 	vec2 translate;
+	uint imageIndex;
+	uint samplerIndex;
 } pushConstants;
 
 layout (location = 0) in vec2 inPos;
@@ -1,5 +1,16 @@
 #version 450
 
+#extension GL_EXT_nonuniform_qualifier : require
+
+// the descriptor heap
+layout (set = 0, binding = 0) uniform texture2D sampledImages[];
+layout (set = 0, binding = 2) uniform sampler samplers[];
+
+layout (push_constant) uniform PushConstant {
+	uint plasmaImageIndex;
+	uint samplerIndex;
+} pushConstant;
+
 layout (location = 0) in vec2 inUV;
 
 layout (location = 0) out vec4 outColor;
@@ -21,5 +32,7 @@ void main() {
 
 	float result = circle(screen / 2, r, uv);
 
-	outColor = vec4(1.0, 1.0 - aastep(0.5, result).xx, 1.0);
+	vec3 plasma = texture(sampler2D(sampledImages[pushConstant.plasmaImageIndex], samplers[pushConstant.samplerIndex]), inUV).rgb;
+
+	outColor = vec4(mix(plasma, vec3(1.0, 0.0, 0.0), aastep(0.5, result)), 1.0);
 }
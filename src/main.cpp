@@ -1,18 +1,25 @@
+#include <algorithm>
+#include <chrono>
 #include <thread>
 #include <filesystem>
 
+#include <fmt/format.h>
 #include <spdlog/spdlog.h>
 #include <tracy/Tracy.hpp>
 
+#include <util/jobSystem.hpp>
+
+#include "ware/benchmark/benchmark.hpp"
 #include "ware/config/config.hpp"
 #include "ware/contextGLFW/contextGLFW.hpp"
 #include "ware/windowGLFW/windowGLFW.hpp"
 #include "ware/contextVK/contextVK.hpp"
 #include "ware/contextImgui/contextImgui.hpp"
 #include "ware/swapchainVK/swapchainVK.hpp"
+#include "ware/uploadVK/uploadVK.hpp"
 #include "ware/rendererVK/rendererVK.hpp"
 
-int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
+int main(int argc, char *argv[]) {
 	try {
 		spdlog::info("started");
 
@@ -20,32 +27,65 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
 
 		spdlog::set_level(spdlog::level::debug);
 
-		auto config = ware::config::setup();
-		auto glfw = ware::contextGLFW::setup();
-		auto window = ware::windowGLFW::setup(config, glfw);
-		auto context = ware::contextVK::setup(config, glfw, window);
-		auto imgui = ware::contextImgui::setup(glfw, window);
-		auto swapchain = ware::swapchainVK::setup(config, window, context);
-		auto renderer = ware::rendererVK::setup(window, context, imgui, swapchain);
+		const auto startupTimePoint = std::chrono::steady_clock::now();
+
+		auto config = ware::config::setup(argc, argv);
+		auto benchmark = ware::benchmark::setup(config, startupTimePoint);
+		// the main thread executes jobs as well while it waits for them
+		util::JobSystem jobs{config.jobs.workerCount >= 0 ? static_cast<size_t>(config.jobs.workerCount) : std::max(std::thread::hardware_concurrency(), 1u) - 1};
+		spdlog::info("running jobs on the main thread and {} worker(s)", jobs.size());
+		auto glfw = ware::benchmark::traceStartup(benchmark, "contextGLFW::setup", [&] { return ware::contextGLFW::setup(config); });
+
+		// the instance is created on a worker while the main thread, which GLFW windows are bound to, creates the window and the imgui context
+		ware::contextVK::Instance instance{};
+		util::JobScope instanceSetup{jobs};
+		instanceSetup.run("ware::contextVK::setupInstance()", [&] {
+			instance = ware::benchmark::traceStartup(benchmark, "contextVK::setupInstance", [&] { return ware::contextVK::setupInstance(config, glfw); });
+		});
+
+		auto window = ware::benchmark::traceStartup(benchmark, "windowGLFW::setup", [&] { return ware::windowGLFW::setup(config, glfw); });
+		auto imgui = ware::benchmark::traceStartup(benchmark, "contextImgui::setup", [&] { return ware::contextImgui::setup(glfw, window); });
+
+		instanceSetup.wait();
+
+		auto context = ware::benchmark::traceStartup(benchmark, "contextVK::setup", [&] { return ware::contextVK::setup(config, glfw, window, std::move(instance), jobs); });
+		auto upload = ware::benchmark::traceStartup(benchmark, "uploadVK::setup", [&] { return ware::uploadVK::setup(config, context); });
+		auto swapchain = ware::benchmark::traceStartup(benchmark, "swapchainVK::setup", [&] { return ware::swapchainVK::setup(config, window, context); });
+		auto renderer = ware::benchmark::traceStartup(benchmark, "rendererVK::setup", [&] { return ware::rendererVK::setup(window, context, upload, imgui, swapchain, jobs); });
 
-		for (size_t i = 0; /** / i < 1 /*/true/**/; i++) {
+		{
+			// pipeline creation dominates startup, so this is the number that moves with a warm or cold pipeline cache
+			const std::chrono::duration<double, std::milli> startupDuration = std::chrono::steady_clock::now() - startupTimePoint;
+			auto message = fmt::format("startup took {:.3f}ms (pipeline cache: {})", startupDuration.count(), context.pipelineCacheLoaded ? "warm" : "cold");
+			spdlog::info(message);
+			TracyMessage(message.data(), message.size());
+		}
+
+		while ( ! ware::benchmark::isFinished(benchmark)) {
 			ZoneScopedN("loop");
 
-			ware::config::refresh(config);
-			ware::contextGLFW::refresh(glfw);
-			ware::windowGLFW::refresh(window);
-			ware::contextVK::refresh(context);
-			ware::contextImgui::refresh(imgui);
-			ware::swapchainVK::refresh(swapchain);
-			ware::rendererVK::refresh(renderer);
-
-			ware::rendererVK::process(renderer);
-			ware::swapchainVK::process(swapchain);
-			ware::contextImgui::process(imgui);
-			ware::contextVK::process(context);
-			ware::windowGLFW::process(window);
-			ware::contextGLFW::process(glfw);
-			ware::config::process(config);
+			ware::benchmark::refresh(benchmark);
+
+			ware::benchmark::measure(benchmark, "jobs::runMainThreadJobs", [&] { jobs.runMainThreadJobs(); });
+			ware::benchmark::measure(benchmark, "config::refresh", [&] { ware::config::refresh(config); });
+			ware::benchmark::measure(benchmark, "contextGLFW::refresh", [&] { ware::contextGLFW::refresh(glfw); });
+			ware::benchmark::measure(benchmark, "windowGLFW::refresh", [&] { ware::windowGLFW::refresh(window); });
+			ware::benchmark::measure(benchmark, "contextVK::refresh", [&] { ware::contextVK::refresh(context); });
+			ware::benchmark::measure(benchmark, "uploadVK::refresh", [&] { ware::uploadVK::refresh(upload); });
+			ware::benchmark::measure(benchmark, "contextImgui::refresh", [&] { ware::contextImgui::refresh(imgui); });
+			ware::benchmark::measure(benchmark, "swapchainVK::refresh", [&] { ware::swapchainVK::refresh(swapchain); });
+			ware::benchmark::measure(benchmark, "rendererVK::refresh", [&] { ware::rendererVK::refresh(renderer); });
+
+			ware::benchmark::measure(benchmark, "rendererVK::process", [&] { ware::rendererVK::process(renderer); });
+			ware::benchmark::measure(benchmark, "swapchainVK::process", [&] { ware::swapchainVK::process(swapchain); });
+			ware::benchmark::measure(benchmark, "contextImgui::process", [&] { ware::contextImgui::process(imgui); });
+			ware::benchmark::measure(benchmark, "uploadVK::process", [&] { ware::uploadVK::process(upload); });
+			ware::benchmark::measure(benchmark, "contextVK::process", [&] { ware::contextVK::process(context); });
+			ware::benchmark::measure(benchmark, "windowGLFW::process", [&] { ware::windowGLFW::process(window); });
+			ware::benchmark::measure(benchmark, "contextGLFW::process", [&] { ware::contextGLFW::process(glfw); });
+			ware::benchmark::measure(benchmark, "config::process", [&] { ware::config::process(config); });
+
+			ware::benchmark::process(benchmark);
 
 			if (window.shouldClose) {
 				break;
@@ -54,6 +94,8 @@ int main([[maybe_unused]] int argc, [[maybe_unused]] char *argv[]) {
 			FrameMark;
 		}
 
+		ware::benchmark::writeReport(benchmark);
+
 		spdlog::info("exiting");
 
 		return EXIT_SUCCESS;
@@ -2,6 +2,10 @@
 
 #include <fstream>
 #include <filesystem>
+#include <optional>
+#include <span>
+#include <system_error>
+#include <vector>
 
 namespace util {
 
@@ -27,4 +31,34 @@ inline std::optional<std::vector<std::byte>> fsReadBytes(const std::filesystem::
 	return storage;
 }
 
+// writes into a temporary sibling file first and renames it over the target, so readers never observe a partial file
+inline bool fsWriteBytesAtomic(const std::filesystem::path &filePath, std::span<const std::byte> contents) {
+	std::filesystem::path temporaryPath{filePath};
+	temporaryPath += ".tmp";
+
+	{
+		std::ofstream out{temporaryPath, std::ios::out | std::ios::binary | std::ios::trunc};
+
+		if ( ! out || ! out.good()) {
+			return false;
+		}
+
+		out.write(reinterpret_cast<const char *>(contents.data()), static_cast<std::streamsize>(contents.size()));
+		out.flush();
+
+		if ( ! out.good()) {
+			return false;
+		}
+	}
+
+	std::error_code error{};
+	std::filesystem::rename(temporaryPath, filePath, error);
+	if (error) {
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	return true;
+}
+
 } // util
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace util {
+
+inline constexpr uint64_t hashSeed = 0xcbf29ce484222325ull;
+
+// FNV-1a, good enough for change detection and cache keys
+inline uint64_t hashBytes(std::span<const std::byte> bytes, uint64_t hash = hashSeed) {
+	for (auto byte : bytes) {
+		hash ^= static_cast<uint64_t>(byte);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+inline uint64_t hashBytes(const void *data, size_t size, uint64_t hash = hashSeed) {
+	return hashBytes(std::span{reinterpret_cast<const std::byte *>(data), size}, hash);
+}
+
+// eight bytes per step, for change detection over buffers large enough that FNV-1a would cost more than copying them
+inline uint64_t hashBytesWide(std::span<const std::byte> bytes, uint64_t hash = hashSeed) {
+	size_t i = 0;
+
+	for (; i + sizeof(uint64_t) <= bytes.size(); i += sizeof(uint64_t)) {
+		uint64_t word;
+		std::memcpy(&word, bytes.data() + i, sizeof(uint64_t));
+
+		hash = (hash ^ word) * 0x9e3779b97f4a7c15ull;
+		hash ^= hash >> 32;
+	}
+
+	return hashBytes(bytes.subspan(i), hash);
+}
+
+template<typename T>
+inline uint64_t hashValue(const T &value, uint64_t hash = hashSeed) {
+	return hashBytes(&value, sizeof(T), hash);
+}
+
+} // util
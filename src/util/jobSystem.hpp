@@ -0,0 +1,410 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <tracy/Tracy.hpp>
+
+namespace util {
+
+// fork-join point, counts the jobs run against it that have not finished yet
+class JobCounter {
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter &other) = delete;
+	JobCounter & operator=(const JobCounter &other) = delete;
+
+	[[nodiscard]] bool done() const {
+		return pending.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	friend class JobSystem;
+
+	std::atomic<uint32_t> pending{0};
+	// the first exception a job threw, rethrown by JobSystem::wait()
+	std::mutex exceptionMutex;
+	std::exception_ptr exception;
+};
+
+// workers with a deque each, a worker takes its own newest job first and steals the oldest jobs of the others,
+// a waiting thread executes jobs until its counter is done, so jobs may run and wait for child jobs themselves
+class JobSystem {
+public:
+	explicit JobSystem(size_t workerCount) : mainThreadId{std::this_thread::get_id()} {
+		// the main thread owns the first queue, threads outside the system push into it as well
+		queues.reserve(workerCount + 1);
+		for (size_t i = 0; i < workerCount + 1; i++) {
+			queues.push_back(std::make_unique<Queue>());
+		}
+
+		currentThread = ThreadSlot{
+			.system = this,
+			.queueIndex = 0,
+		};
+
+		workers.reserve(workerCount);
+		for (size_t i = 0; i < workerCount; i++) {
+			workers.emplace_back([this, queueIndex = i + 1] (std::stop_token stopToken) {
+				work(stopToken, queueIndex);
+			});
+		}
+	}
+
+	JobSystem(const JobSystem &other) = delete;
+	JobSystem & operator=(const JobSystem &other) = delete;
+
+	// jobs still queued are dropped, wait for their counters before
+	~JobSystem() {
+		for (auto &worker : workers) {
+			worker.request_stop();
+		}
+
+		sleepCondition.notify_all();
+
+		if (currentThread.system == this) {
+			currentThread = ThreadSlot{};
+		}
+	}
+
+	[[nodiscard]] size_t size() const {
+		return workers.size();
+	}
+
+	[[nodiscard]] bool isMainThread() const {
+		return std::this_thread::get_id() == mainThreadId;
+	}
+
+	// the name shows up as the Tracy zone of the job and has to outlive it, usually a literal
+	void run(const char *name, JobCounter &counter, std::move_only_function<void()> &&function) {
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+		// counted ahead of the push, a thief taking the job right away must not see the count drop below zero
+		queuedCount.fetch_add(1);
+
+		push(*queues[ownQueueIndex().value_or(0)], Job{
+			.name = name,
+			.counter = &counter,
+			.function = std::move(function),
+		});
+
+		if (sleepingCount.load() > 0) {
+			// taking the lock orders the notification after a worker that is about to sleep has started waiting
+			{
+				std::scoped_lock lock{sleepMutex};
+			}
+
+			sleepCondition.notify_one();
+		}
+	}
+
+	// for work that has to happen on the main thread, e.g. everything touching GLFW
+	void runOnMainThread(const char *name, JobCounter &counter, std::move_only_function<void()> &&function) {
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+
+		push(mainThreadQueue, Job{
+			.name = name,
+			.counter = &counter,
+			.function = std::move(function),
+		});
+	}
+
+	// for long work nobody waits for within a frame, e.g. compiling a pipeline, only idle workers take these jobs,
+	// so that a thread waiting for its own jobs never ends up running one, without workers runMainThreadJobs() does
+	void runInBackground(const char *name, JobCounter &counter, std::move_only_function<void()> &&function) {
+		counter.pending.fetch_add(1, std::memory_order_relaxed);
+		backgroundCount.fetch_add(1);
+
+		push(backgroundQueue, Job{
+			.name = name,
+			.counter = &counter,
+			.function = std::move(function),
+		});
+
+		if (sleepingCount.load() > 0) {
+			{
+				std::scoped_lock lock{sleepMutex};
+			}
+
+			sleepCondition.notify_one();
+		}
+	}
+
+	// executes jobs until the counter is done, rethrows the first exception of its jobs
+	void wait(JobCounter &counter) {
+		join(counter);
+
+		std::scoped_lock lock{counter.exceptionMutex};
+
+		if (counter.exception) {
+			std::rethrow_exception(std::exchange(counter.exception, nullptr));
+		}
+	}
+
+	// called once per frame by the main loop, main-thread jobs nobody waits for run here
+	void runMainThreadJobs() {
+		while (auto job = pop(mainThreadQueue)) {
+			execute(std::move(*job));
+		}
+
+		if (workers.empty()) {
+			while (auto job = takeBackgroundJob()) {
+				execute(std::move(*job));
+			}
+		}
+	}
+
+private:
+	friend class JobScope;
+
+	struct Job {
+		const char *name;
+		JobCounter *counter;
+		std::move_only_function<void()> function;
+	};
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	struct ThreadSlot {
+		const JobSystem *system;
+		size_t queueIndex;
+	};
+
+	static inline thread_local ThreadSlot currentThread{};
+
+	// wait() without rethrowing, exceptions stay with the counter
+	void join(JobCounter &counter) {
+		const bool mainThread = isMainThread();
+		const auto queueIndex = ownQueueIndex();
+
+		while ( ! counter.done()) {
+			std::optional<Job> job{};
+
+			if (mainThread) {
+				job = pop(mainThreadQueue);
+			}
+
+			if ( ! job) {
+				job = findJob(queueIndex);
+			}
+
+			// nobody else would ever run them
+			if ( ! job && workers.empty()) {
+				job = takeBackgroundJob();
+			}
+
+			if (job) {
+				execute(std::move(*job));
+			} else {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	[[nodiscard]] std::optional<size_t> ownQueueIndex() const {
+		if (currentThread.system != this) {
+			return std::nullopt;
+		}
+
+		return currentThread.queueIndex;
+	}
+
+	static void push(Queue &queue, Job &&job) {
+		std::scoped_lock lock{queue.mutex};
+
+		queue.jobs.push_back(std::move(job));
+	}
+
+	// newest first, the owner likely still has its data in cache
+	static std::optional<Job> pop(Queue &queue) {
+		std::scoped_lock lock{queue.mutex};
+
+		if (queue.jobs.empty()) {
+			return std::nullopt;
+		}
+
+		auto job = std::move(queue.jobs.back());
+		queue.jobs.pop_back();
+
+		return job;
+	}
+
+	// oldest first, in fork-join these are the biggest chunks of work
+	static std::optional<Job> steal(Queue &queue) {
+		std::scoped_lock lock{queue.mutex};
+
+		if (queue.jobs.empty()) {
+			return std::nullopt;
+		}
+
+		auto job = std::move(queue.jobs.front());
+		queue.jobs.pop_front();
+
+		return job;
+	}
+
+	std::optional<Job> findJob(std::optional<size_t> queueIndex) {
+		if (queuedCount.load(std::memory_order_relaxed) == 0) {
+			return std::nullopt;
+		}
+
+		std::optional<Job> job{};
+
+		if (queueIndex) {
+			job = pop(*queues[*queueIndex]);
+		}
+
+		// victims are visited starting after the own queue, so that thieves spread over the queues
+		const size_t start = queueIndex.value_or(0) + 1;
+		for (size_t i = 0; i < queues.size() && ! job; i++) {
+			const size_t victim = (start + i) % queues.size();
+
+			if (victim != queueIndex) {
+				job = steal(*queues[victim]);
+			}
+		}
+
+		if (job) {
+			queuedCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		return job;
+	}
+
+	// in submission order, only idle workers get here
+	std::optional<Job> takeBackgroundJob() {
+		if (backgroundCount.load(std::memory_order_relaxed) == 0) {
+			return std::nullopt;
+		}
+
+		auto job = steal(backgroundQueue);
+
+		if (job) {
+			backgroundCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		return job;
+	}
+
+	static void execute(Job &&job) {
+		auto &counter = *job.counter;
+
+		{
+			ZoneScoped;
+			ZoneName(job.name, std::strlen(job.name));
+
+			try {
+				job.function();
+			} catch (...) {
+				std::scoped_lock lock{counter.exceptionMutex};
+
+				if ( ! counter.exception) {
+					counter.exception = std::current_exception();
+				}
+			}
+
+			// whatever the job captured goes before the waiter is released
+			job.function = nullptr;
+		}
+
+		counter.pending.fetch_sub(1, std::memory_order_release);
+	}
+
+	void work(std::stop_token stopToken, size_t queueIndex) {
+		currentThread = ThreadSlot{
+			.system = this,
+			.queueIndex = queueIndex,
+		};
+
+		const auto threadName = "job worker " + std::to_string(queueIndex);
+		tracy::SetThreadName(threadName.c_str());
+
+		while ( ! stopToken.stop_requested()) {
+			if (auto job = findJob(queueIndex)) {
+				execute(std::move(*job));
+
+				continue;
+			}
+
+			if (auto job = takeBackgroundJob()) {
+				execute(std::move(*job));
+
+				continue;
+			}
+
+			std::unique_lock lock{sleepMutex};
+
+			sleepingCount.fetch_add(1);
+			sleepCondition.wait(lock, stopToken, [this] { return queuedCount.load() > 0 || backgroundCount.load() > 0; });
+			sleepingCount.fetch_sub(1);
+		}
+	}
+
+	const std::thread::id mainThreadId;
+	std::vector<std::unique_ptr<Queue>> queues;
+	Queue mainThreadQueue;
+	// never popped or stolen by a waiting thread, see runInBackground()
+	Queue backgroundQueue;
+	std::atomic<size_t> backgroundCount{0};
+	// jobs in the worker queues, lets idle workers sleep instead of scanning every queue
+	std::atomic<size_t> queuedCount{0};
+	std::atomic<size_t> sleepingCount{0};
+	std::mutex sleepMutex;
+	std::condition_variable_any sleepCondition;
+	// declared last so that the workers are joined before the queues go away
+	std::vector<std::jthread> workers;
+};
+
+// a counter joined when it goes out of scope, so that an exception unwinding the scope never leaves jobs behind
+// that reference its locals, only wait() rethrows what the jobs threw
+class JobScope {
+public:
+	explicit JobScope(JobSystem &jobs) : jobs{jobs} {}
+
+	JobScope(const JobScope &other) = delete;
+	JobScope & operator=(const JobScope &other) = delete;
+
+	~JobScope() {
+		jobs.join(counter);
+	}
+
+	void run(const char *name, std::move_only_function<void()> &&function) {
+		jobs.run(name, counter, std::move(function));
+	}
+
+	void runOnMainThread(const char *name, std::move_only_function<void()> &&function) {
+		jobs.runOnMainThread(name, counter, std::move(function));
+	}
+
+	void runInBackground(const char *name, std::move_only_function<void()> &&function) {
+		jobs.runInBackground(name, counter, std::move(function));
+	}
+
+	void wait() {
+		jobs.wait(counter);
+	}
+
+	[[nodiscard]] bool done() const {
+		return counter.done();
+	}
+
+private:
+	JobSystem &jobs;
+	JobCounter counter;
+};
+
+} // util
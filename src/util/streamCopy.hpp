@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define UTIL_STREAM_COPY_SSE2
+#endif
+
+#include "jobSystem.hpp"
+
+namespace util {
+
+// non-temporal stores go around the cache instead of reading the destination lines in first, which suits memory the CPU
+// only ever writes such as write-combined mappings, they are weakly ordered so streamFence() has to follow before publishing
+inline void streamCopy(std::byte *destination, const std::byte *source, size_t size) {
+#if defined(UTIL_STREAM_COPY_SSE2)
+	// plain stores up to the first 16 byte boundary of the destination, the source may stay unaligned
+	const auto headSize = std::min(size, static_cast<size_t>((16 - reinterpret_cast<uintptr_t>(destination) % 16) % 16));
+	std::memcpy(destination, source, headSize);
+	destination += headSize;
+	source += headSize;
+	size -= headSize;
+
+	// a whole cache line per iteration, so that the write-combining buffers are filled completely
+	for (; size >= 64; size -= 64, destination += 64, source += 64) {
+		const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source));
+		const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 16));
+		const auto c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 32));
+		const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + 48));
+		_mm_stream_si128(reinterpret_cast<__m128i *>(destination), a);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(destination + 16), b);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(destination + 32), c);
+		_mm_stream_si128(reinterpret_cast<__m128i *>(destination + 48), d);
+	}
+
+	for (; size >= 16; size -= 16, destination += 16, source += 16) {
+		_mm_stream_si128(reinterpret_cast<__m128i *>(destination), _mm_loadu_si128(reinterpret_cast<const __m128i *>(source)));
+	}
+#endif
+
+	std::memcpy(destination, source, size);
+}
+
+inline void streamFence() {
+#if defined(UTIL_STREAM_COPY_SSE2)
+	_mm_sfence();
+#endif
+}
+
+struct CopySegment {
+	std::byte *destination;
+	const std::byte *source;
+	size_t size;
+};
+
+// the segments are laid end to end and cut into one even share per thread, so a single huge segment is split as well,
+// below minJobSize per share fewer threads take part, returns once everything is copied and fenced
+inline void streamCopyParallel(JobSystem &jobs, std::span<const CopySegment> segments, size_t minJobSize) {
+	// where each segment starts in the concatenation of all of them, the total size last
+	std::vector<size_t> starts(segments.size() + 1, 0);
+	std::transform_inclusive_scan(segments.begin(), segments.end(), starts.begin() + 1, std::plus<>{}, [] (const CopySegment &segment) {
+		return segment.size;
+	});
+
+	const size_t totalSize = starts.back();
+	const size_t jobCount = std::clamp<size_t>(totalSize / std::max<size_t>(minJobSize, 1), 1, jobs.size() + 1);
+	const size_t shareSize = (totalSize + jobCount - 1) / jobCount;
+
+	const auto copyRange = [&segments, &starts] (size_t begin, size_t end) {
+		// the last segment starting at or before begin
+		auto index = static_cast<size_t>(std::upper_bound(starts.begin(), starts.end() - 1, begin) - starts.begin()) - 1;
+
+		for (; index < segments.size() && starts[index] < end; index++) {
+			const auto &segment = segments[index];
+			const auto from = std::max(begin, starts[index]) - starts[index];
+			const auto to = std::min(end, starts[index + 1]) - starts[index];
+
+			streamCopy(segment.destination + from, segment.source + from, to - from);
+		}
+
+		// every thread fences its own stores before the join publishes them
+		streamFence();
+	};
+
+	if (jobCount == 1) {
+		copyRange(0, totalSize);
+		return;
+	}
+
+	JobScope copies{jobs};
+
+	for (size_t i = 1; i < jobCount; i++) {
+		copies.run("util::streamCopyParallel()", [&copyRange, begin = std::min(totalSize, i * shareSize), end = std::min(totalSize, (i + 1) * shareSize)] {
+			copyRange(begin, end);
+		});
+	}
+
+	// the first share runs on the calling thread
+	copyRange(0, std::min(totalSize, shareSize));
+
+	copies.wait();
+}
+
+} // util
@@ -0,0 +1,254 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <util/fs.hpp>
+#include <util/map.hpp>
+
+namespace ware::benchmark {
+
+// nearest rank on sorted samples
+double percentile(const std::vector<double> &sortedSamples, double fraction) {
+	const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sortedSamples.size())));
+
+	return sortedSamples[std::clamp<size_t>(rank, 1, sortedSamples.size()) - 1];
+}
+
+Summary summarize(const Stage &stage) {
+	if (stage.samples.empty()) {
+		return Summary{
+			.mean = 0.0,
+			.min = 0.0,
+			.p50 = 0.0,
+			.p90 = 0.0,
+			.p95 = 0.0,
+			.p99 = 0.0,
+			.max = 0.0,
+		};
+	}
+
+	auto sortedSamples = stage.samples;
+	std::sort(sortedSamples.begin(), sortedSamples.end());
+
+	return Summary{
+		.mean = std::accumulate(sortedSamples.begin(), sortedSamples.end(), 0.0) / static_cast<double>(sortedSamples.size()),
+		.min = sortedSamples.front(),
+		.p50 = percentile(sortedSamples, 0.50),
+		.p90 = percentile(sortedSamples, 0.90),
+		.p95 = percentile(sortedSamples, 0.95),
+		.p99 = percentile(sortedSamples, 0.99),
+		.max = sortedSamples.back(),
+	};
+}
+
+std::string buildJsonReport(const State &state) {
+	const auto &config = state.config;
+
+	auto stages = nlohmann::ordered_json::array();
+	const auto appendStage = [&] (const Stage &stage) {
+		const auto summary = summarize(stage);
+
+		stages.push_back({
+			{ "name", stage.name },
+			{ "mean", summary.mean },
+			{ "min", summary.min },
+			{ "p50", summary.p50 },
+			{ "p90", summary.p90 },
+			{ "p95", summary.p95 },
+			{ "p99", summary.p99 },
+			{ "max", summary.max },
+			{ "samples", stage.samples },
+		});
+	};
+
+	for (const auto &stage : state.stages) {
+		appendStage(stage);
+	}
+	appendStage(state.frameStage);
+
+	auto startup = nlohmann::ordered_json::array();
+	for (const auto &span : state.startupSpans) {
+		startup.push_back({
+			{ "name", span.name },
+			{ "begin", span.begin },
+			{ "end", span.end },
+		});
+	}
+
+	nlohmann::ordered_json report{
+		{ "unit", "ms" },
+		{ "frames", state.frameStage.samples.size() },
+		{ "warmupFrames", config.benchmark.warmupFrames },
+		{ "width", config.window.width },
+		{ "height", config.window.height },
+		{ "headless", config.window.headless },
+		{ "timeToFirstPresent", state.timeToFirstPresent },
+		{ "startup", std::move(startup) },
+		{ "stages", std::move(stages) },
+	};
+
+	return report.dump(1, '\t');
+}
+
+std::string buildCsvReport(const State &state) {
+	std::vector<const Stage *> stages{};
+	for (const auto &stage : state.stages) {
+		stages.push_back(&stage);
+	}
+	stages.push_back(&state.frameStage);
+
+	std::string report{"frame"};
+	for (const auto *stage : stages) {
+		report += fmt::format(",{}", stage->name);
+	}
+	report += "\n";
+
+	// per frame rows first, then one row per statistic; all values in milliseconds
+	for (size_t frame = 0; frame < state.frameStage.samples.size(); frame++) {
+		report += fmt::format("{}", frame);
+		for (const auto *stage : stages) {
+			report += frame < stage->samples.size() ? fmt::format(",{:.6f}", stage->samples[frame]) : ",";
+		}
+		report += "\n";
+	}
+
+	const auto summaries = util::map(stages, [] (const Stage *stage) {
+		return summarize(*stage);
+	});
+	const std::array<std::pair<std::string_view, double Summary::*>, 7> statistics{{
+		{ "mean", &Summary::mean },
+		{ "min", &Summary::min },
+		{ "p50", &Summary::p50 },
+		{ "p90", &Summary::p90 },
+		{ "p95", &Summary::p95 },
+		{ "p99", &Summary::p99 },
+		{ "max", &Summary::max },
+	}};
+
+	for (const auto &[name, member] : statistics) {
+		report += name;
+		for (const auto &summary : summaries) {
+			report += fmt::format(",{:.6f}", summary.*member);
+		}
+		report += "\n";
+	}
+
+	return report;
+}
+
+void writeReport(State &state) {
+	const std::filesystem::path reportPath{state.config.benchmark.reportPath};
+
+	if (reportPath.empty()) {
+		return;
+	}
+
+	const auto extension = reportPath.extension();
+	if (extension != ".json" && extension != ".csv") {
+		throw std::runtime_error{fmt::format("Unsupported benchmark report format \"{}\", expected .json or .csv", reportPath.string())};
+	}
+
+	const auto report = extension == ".json" ? buildJsonReport(state) : buildCsvReport(state);
+
+	if ( ! util::fsWriteBytesAtomic(reportPath, std::as_bytes(std::span{report.data(), report.size()}))) {
+		throw std::runtime_error{fmt::format("Unable to write benchmark report \"{}\"", reportPath.string())};
+	}
+
+	const auto summary = summarize(state.frameStage);
+	spdlog::info("ware::benchmark::writeReport() => wrote \"{}\" ({} frames, frame p50: {:.3f}ms, p99: {:.3f}ms)", reportPath.string(), state.frameStage.samples.size(), summary.p50, summary.p99);
+}
+
+void recordStartupSpan(State &state, std::string_view name, std::chrono::steady_clock::time_point beginTimePoint, std::chrono::steady_clock::time_point endTimePoint) {
+	std::scoped_lock lock{state.startupMutex};
+
+	state.startupSpans.push_back(StartupSpan{
+		.name = std::string{name},
+		.begin = Duration{beginTimePoint - state.startupTimePoint}.count(),
+		.end = Duration{endTimePoint - state.startupTimePoint}.count(),
+	});
+}
+
+// spans overlap where setup() calls ran side by side
+void logStartupTrace(State &state) {
+	std::scoped_lock lock{state.startupMutex};
+
+	std::sort(state.startupSpans.begin(), state.startupSpans.end(), [] (const auto &left, const auto &right) {
+		return left.begin < right.begin;
+	});
+
+	for (const auto &span : state.startupSpans) {
+		spdlog::info("ware::benchmark::logStartupTrace() => {:<32} {:>9.3f}ms .. {:>9.3f}ms ({:.3f}ms)", span.name, span.begin, span.end, span.end - span.begin);
+	}
+
+	const auto message = fmt::format("time to first present: {:.3f}ms", state.timeToFirstPresent);
+	spdlog::info("ware::benchmark::logStartupTrace() => {}", message);
+	TracyMessage(message.data(), message.size());
+}
+
+bool isFinished(const State &state) {
+	const auto &benchmark = state.config.benchmark;
+
+	return benchmark.frameCount > 0 && state.frame >= benchmark.warmupFrames + benchmark.frameCount;
+}
+
+State setup(ware::config::State &config, std::chrono::steady_clock::time_point startupTimePoint) {
+	if (config.benchmark.frameCount > 0) {
+		spdlog::info("ware::benchmark::setup() => running {} frame(s) after {} warm-up frame(s)", config.benchmark.frameCount, config.benchmark.warmupFrames);
+	}
+
+	return State{
+		.config = config,
+		.frame = 0,
+		.stageIndex = 0,
+		.stages = {},
+		.frameStage = {
+			.name = "frame",
+			.samples = {},
+		},
+		.frameTimePoint = std::chrono::steady_clock::now(),
+		.startupTimePoint = startupTimePoint,
+		.startupMutex = {},
+		.startupSpans = {},
+		.timeToFirstPresent = -1.0,
+	};
+}
+
+void refresh(State &state) {
+	ZoneScopedN("ware::benchmark::refresh()");
+
+	state.stageIndex = 0;
+	state.frameTimePoint = std::chrono::steady_clock::now();
+}
+
+void process(State &state) {
+	ZoneScopedN("ware::benchmark::process()");
+
+	const Duration duration = std::chrono::steady_clock::now() - state.frameTimePoint;
+
+	if (isMeasuring(state)) {
+		state.frameStage.samples.push_back(duration.count());
+	}
+
+	// called after swapchainVK::process(), so the first frame has just been presented
+	if (state.frame == 0) {
+		state.timeToFirstPresent = Duration{std::chrono::steady_clock::now() - state.startupTimePoint}.count();
+
+		logStartupTrace(state);
+	}
+
+	state.frame++;
+}
+
+} // ware::benchmark
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "../config/config.hpp"
+
+namespace ware::benchmark {
+
+using Duration = std::chrono::duration<double, std::milli>;
+
+struct Stage {
+	std::string name;
+	// one sample per measured frame
+	std::vector<double> samples;
+};
+
+// a setup() call on the way to the first frame, in milliseconds since main() started
+struct StartupSpan {
+	std::string name;
+	double begin;
+	double end;
+};
+
+struct Summary {
+	double mean;
+	double min;
+	double p50;
+	double p90;
+	double p95;
+	double p99;
+	double max;
+};
+
+struct State {
+	ware::config::State &config;
+	uint64_t frame;
+	// stages register themselves in call order during the first frame, later frames address them by position
+	size_t stageIndex;
+	std::vector<Stage> stages;
+	Stage frameStage;
+	std::chrono::steady_clock::time_point frameTimePoint;
+	std::chrono::steady_clock::time_point startupTimePoint;
+	// setup() calls running as jobs record their spans from the workers
+	std::mutex startupMutex;
+	std::vector<StartupSpan> startupSpans;
+	// from the start of main() until the first frame has been handed to the presentation engine, negative before
+	double timeToFirstPresent;
+};
+
+[[nodiscard]] inline bool isMeasuring(const State &state) {
+	return state.frame >= state.config.benchmark.warmupFrames;
+}
+
+// times a single refresh() or process() call of the main loop
+template<class F>
+void measure(State &state, std::string_view name, F &&callback) {
+	const auto startTimePoint = std::chrono::steady_clock::now();
+
+	std::forward<F>(callback)();
+
+	const Duration duration = std::chrono::steady_clock::now() - startTimePoint;
+
+	if (state.stageIndex == state.stages.size()) {
+		state.stages.push_back(Stage{
+			.name = std::string{name},
+			.samples = {},
+		});
+	}
+
+	if (isMeasuring(state)) {
+		state.stages[state.stageIndex].samples.push_back(duration.count());
+	}
+
+	state.stageIndex++;
+}
+
+void recordStartupSpan(State &state, std::string_view name, std::chrono::steady_clock::time_point beginTimePoint, std::chrono::steady_clock::time_point endTimePoint);
+
+// times a setup() call for the startup trace, the result is returned as is so that states are still constructed in place
+template<class F>
+decltype(auto) traceStartup(State &state, std::string_view name, F &&callback) {
+	struct Span {
+		State &state;
+		std::string_view name;
+		std::chrono::steady_clock::time_point beginTimePoint;
+
+		~Span() {
+			recordStartupSpan(state, name, beginTimePoint, std::chrono::steady_clock::now());
+		}
+	} span{state, name, std::chrono::steady_clock::now()};
+
+	return std::forward<F>(callback)();
+}
+
+[[nodiscard]] bool isFinished(const State &state);
+
+Summary summarize(const Stage &stage);
+
+// the extension of config.benchmark.reportPath picks the format, .csv or .json
+void writeReport(State &state);
+
+// startupTimePoint is taken first thing in main(), the startup trace is relative to it
+State setup(ware::config::State &config, std::chrono::steady_clock::time_point startupTimePoint);
+
+void refresh(State &state);
+
+void process(State &state);
+
+} // ware::benchmark
@@ -1,17 +1,88 @@
 #include "config.hpp"
 
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <fmt/format.h>
 #include <tracy/Tracy.hpp>
 
 namespace ware::config {
 
-State setup() {
-	return State{
+template<class T>
+T parseNumber(std::string_view option, std::string_view value) {
+	T number{};
+	const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+
+	if (error != std::errc{} || end != value.data() + value.size()) {
+		throw std::runtime_error{fmt::format("Invalid value \"{}\" for option {}", value, option)};
+	}
+
+	return number;
+}
+
+void parseArguments(State &state, int argc, char *argv[]) {
+	const std::vector<std::string_view> arguments(argv + std::min(argc, 1), argv + argc);
+
+	for (size_t i = 0; i < arguments.size(); i++) {
+		const auto option = arguments[i];
+
+		const auto value = [&] () {
+			if (i + 1 >= arguments.size()) {
+				throw std::runtime_error{fmt::format("Missing value for option {}", option)};
+			}
+
+			return arguments[++i];
+		};
+
+		if (option == "--frames") {
+			state.benchmark.frameCount = parseNumber<uint64_t>(option, value());
+		} else if (option == "--warmup") {
+			state.benchmark.warmupFrames = parseNumber<uint64_t>(option, value());
+		} else if (option == "--size") {
+			const auto size = value();
+			const auto separator = size.find('x');
+
+			if (separator == std::string_view::npos) {
+				throw std::runtime_error{fmt::format("Invalid value \"{}\" for option {}, expected <width>x<height>", size, option)};
+			}
+
+			state.window.width = parseNumber<int32_t>(option, size.substr(0, separator));
+			state.window.height = parseNumber<int32_t>(option, size.substr(separator + 1));
+			// a fixed size keeps runs comparable, the user can not resize it away
+			state.window.resizable = false;
+		} else if (option == "--report") {
+			state.benchmark.reportPath = std::string{value()};
+		} else if (option == "--headless") {
+			state.window.headless = true;
+		} else if (option == "--workers") {
+			state.jobs.workerCount = parseNumber<int32_t>(option, value());
+		} else if (option == "--resize-churn") {
+			state.benchmark.resizeChurnInterval = parseNumber<uint32_t>(option, value());
+		} else if (option == "--descriptor-pool") {
+			state.vk.enableDescriptorBuffer = false;
+		} else {
+			throw std::runtime_error{fmt::format("Unknown option {}", option)};
+		}
+	}
+
+	if (state.window.width <= 0 || state.window.height <= 0) {
+		throw std::runtime_error{fmt::format("Invalid window size {}x{}", state.window.width, state.window.height)};
+	}
+}
+
+State setup(int argc, char *argv[]) {
+	auto state = State{
 		.window = {
 			.width = 1600,
 			.height = 900,
 			.monitor = -1,
 			.title = "pr0-vk",
 			.mode = WindowMode::Windowed,
+			.resizable = true,
+			.headless = false,
 		},
 		.vk = {
 			.enableValidation = true,
@@ -31,8 +102,29 @@ State setup() {
 			.surfaceColorSpace = vk::ColorSpaceKHR::eSrgbNonlinear,
 			.swapchainPresentMode = vk::PresentModeKHR::eImmediate,
 			.swapchainImageCount = -1,
+			.framesInFlight = -1,
+			.pipelineCachePath = "pipeline.cache",
+			.pipelineCacheSaveInterval = 60,
+			.uploadStagingSize = 16 * 1024 * 1024,
+			.descriptorHeapSampledImages = 4096,
+			.descriptorHeapStorageImages = 1024,
+			.descriptorHeapSamplers = 256,
+			.enableDescriptorBuffer = true,
+		},
+		.jobs = {
+			.workerCount = -1,
+		},
+		.benchmark = {
+			.resizeChurnInterval = 0,
+			.frameCount = 0,
+			.warmupFrames = 0,
+			.reportPath = "",
 		},
 	};
+
+	parseArguments(state, argc, argv);
+
+	return state;
 }
 
 void refresh([[maybe_unused]] State &state) {
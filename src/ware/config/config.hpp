@@ -20,6 +20,9 @@ struct State {
 		int32_t monitor;
 		std::string title;
 		WindowMode mode;
+		bool resizable;
+		// renders into offscreen images without a surface or swapchain, for build agents and software drivers
+		bool headless;
 	} window;
 
 	struct VK {
@@ -40,10 +43,36 @@ struct State {
 		vk::ColorSpaceKHR surfaceColorSpace;
 		vk::PresentModeKHR swapchainPresentMode;
 		int32_t swapchainImageCount;
+		int32_t framesInFlight;
+		std::string pipelineCachePath;
+		uint32_t pipelineCacheSaveInterval;
+		uint32_t uploadStagingSize;
+		// slots of the bindless descriptor heap, clamped to what the device supports
+		uint32_t descriptorHeapSampledImages;
+		uint32_t descriptorHeapStorageImages;
+		uint32_t descriptorHeapSamplers;
+		// VK_EXT_descriptor_buffer where available, false keeps the heap in a descriptor pool
+		bool enableDescriptorBuffer;
 	} vk;
+
+	struct Jobs {
+		// -1 keeps every other hardware thread busy, 0 runs all jobs on the main thread while it waits for them
+		int32_t workerCount;
+	} jobs;
+
+	struct Benchmark {
+		// resizes the window every that many frames to stress swapchain recreation, 0 keeps the size
+		uint32_t resizeChurnInterval;
+		// measured frames after warm-up, 0 runs until the window closes
+		uint64_t frameCount;
+		uint64_t warmupFrames;
+		// .json or .csv, empty writes no report
+		std::string reportPath;
+	} benchmark;
 };
 
-State setup();
+// command line: --frames <count> --warmup <count> --size <width>x<height> --report <path.json|path.csv> --headless --workers <count> --resize-churn <frames> --descriptor-pool
+State setup(int argc, char *argv[]);
 
 void refresh(State &state);
 
@@ -1,7 +1,13 @@
 #include "contextGLFW.hpp"
 
+#include <stdexcept>
+#include <string_view>
+
 #include <spdlog/spdlog.h>
 
+// headless mode runs on the null platform, GLFW has it since 3.4
+static_assert(GLFW_VERSION_MAJOR > 3 || (GLFW_VERSION_MAJOR == 3 && GLFW_VERSION_MINOR >= 4), "GLFW 3.4 or newer is required");
+
 namespace ware::contextGLFW {
 
 void errorCallback(int code, const char *message) {
@@ -23,18 +29,40 @@ std::span<const char *> getVulkanRequiredInstanceExtensions([[maybe_unused]] Sta
 	return { extensions, count };
 }
 
+[[nodiscard]] std::string_view platformName(int platform) {
+	switch (platform) {
+		case GLFW_PLATFORM_WIN32: return "Win32";
+		case GLFW_PLATFORM_COCOA: return "Cocoa";
+		case GLFW_PLATFORM_WAYLAND: return "Wayland";
+		case GLFW_PLATFORM_X11: return "X11";
+		case GLFW_PLATFORM_NULL: return "null";
+		default: return "unknown";
+	}
+}
+
 State::~State() {
 	glfwPollEvents();
 	glfwTerminate();
 }
 
-State setup() {
+State setup(ware::config::State &config) {
 	glfwSetErrorCallback(errorCallback);
 
+	// the null platform needs no display server, windows and cursors still exist as plain objects
+	if (config.window.headless) {
+		if (glfwPlatformSupported(GLFW_PLATFORM_NULL) != GLFW_TRUE) {
+			throw std::runtime_error{"Headless mode needs the GLFW null platform, this GLFW was built without it"};
+		}
+
+		glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+	}
+
 	if (glfwInit() != GLFW_TRUE) {
 		throw std::runtime_error{"Failed to initialize GLFW"};
 	}
 
+	spdlog::info("ware::contextGLFW::setup() => platform: {}", platformName(glfwGetPlatform()));
+
 	return State{};
 }
 
@@ -5,6 +5,8 @@
 #include <vulkan/vulkan.hpp> // vulkan.h needs to be included before glfw3
 #include <GLFW/glfw3.h>
 
+#include "../config/config.hpp"
+
 namespace ware::contextGLFW {
 
 struct State {
@@ -17,7 +19,7 @@ PFN_vkGetInstanceProcAddr loadVulkanGetInstanceProcAddr(State &state);
 
 std::span<const char *> getVulkanRequiredInstanceExtensions(State &state);
 
-State setup();
+State setup(ware::config::State &config);
 
 void refresh(State &state);
 
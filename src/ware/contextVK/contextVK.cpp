@@ -1,9 +1,14 @@
 #include "contextVK.hpp"
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
 #include <iterator>
+#include <limits>
 #include <locale>
 #include <numeric>
+#include <optional>
 #include <string_view>
 #include <tuple>
 #include <vector>
@@ -13,6 +18,8 @@
 #include <tracy/Tracy.hpp>
 
 #include <util/contains.hpp>
+#include <util/fs.hpp>
+#include <util/hash.hpp>
 #include <util/map.hpp>
 
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
@@ -210,6 +217,19 @@ bool hasFeatures(const vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::Physi
 	#undef X
 }
 
+// optional features never reject a device, they are enabled when the selected device supports them
+void enableOptionalFeatures(vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features> &features, vk::PhysicalDevice physicalDevice) {
+	const auto availableFeatures = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features>();
+	const auto &availableFeatures10 = availableFeatures.get<vk::PhysicalDeviceFeatures2>().features;
+
+	auto &features10 = features.get<vk::PhysicalDeviceFeatures2>().features;
+	// for per pass pipeline statistics, queries stay active across vkCmdExecuteCommands only with inherited queries
+	if (availableFeatures10.pipelineStatisticsQuery && availableFeatures10.inheritedQueries) {
+		features10.pipelineStatisticsQuery = true;
+		features10.inheritedQueries = true;
+	}
+}
+
 [[nodiscard]] std::tuple<vk::UniqueInstance, bool> createInstance(const ware::config::State &config, [[maybe_unused]] ware::contextGLFW::State &glfw) {
 	using namespace std::literals;
 
@@ -245,8 +265,8 @@ bool hasFeatures(const vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::Physi
 	// select extensions
 	std::vector<const char *> enabledExtensions{};
 
-	// select surface extensions
-	{
+	// select surface extensions, headless rendering creates no surface
+	if ( ! config.window.headless) {
 		auto extensions = ware::contextGLFW::getVulkanRequiredInstanceExtensions(glfw);
 		enabledExtensions.assign(std::begin(extensions), std::end(extensions));
 	}
@@ -388,6 +408,8 @@ std::string decodeVulkanDriverVersion(uint32_t vendorID, uint32_t driverVersion)
 				.independentBlend = true, // for separate color blending
 				.sampleRateShading = true, // for multisampling
 				.samplerAnisotropy = true, // for anisotropy
+				.pipelineStatisticsQuery = false, // optional, for per pass pipeline statistics, see enableOptionalFeatures()
+				.inheritedQueries = false, // optional, for per pass pipeline statistics, see enableOptionalFeatures()
 			},
 		},
 		vk::PhysicalDeviceVulkan12Features{
@@ -433,8 +455,9 @@ std::string decodeVulkanDriverVersion(uint32_t vendorID, uint32_t driverVersion)
 		}
 
 		std::vector<vk::QueueFamilyProperties2> queueFamilyProperties2 = physicalDevice.getQueueFamilyProperties2();
-		bool hasSurfaceSupport = false;
-		for (uint32_t i = 0; i < queueFamilyProperties2.size(); i++) {
+		// without a surface there is nothing to present to, headless rendering only needs a graphic queue
+		bool hasSurfaceSupport = ! surface;
+		for (uint32_t i = 0; surface && i < queueFamilyProperties2.size(); i++) {
 			if (physicalDevice.getSurfaceSupportKHR(static_cast<uint32_t>(i), surface)) {
 				hasSurfaceSupport = true;
 				break;
@@ -469,6 +492,8 @@ std::string decodeVulkanDriverVersion(uint32_t vendorID, uint32_t driverVersion)
 		if ((config.vk.vendorId < 0 || static_cast<uint32_t>(config.vk.vendorId) == properties.vendorID) && (config.vk.deviceId < 0 || static_cast<uint32_t>(config.vk.deviceId) == properties.deviceID)) {
 			spdlog::debug("ware::contextVK::selectPhysicalDevice() => selected device: {}, vendor ID: {}, device ID: {}, Vulkan driver: {}, device driver: {} {} ({})", properties.deviceName, properties.vendorID, properties.deviceID, decodeVulkanDriverVersion(properties.vendorID, properties.driverVersion), vk::to_string(driverProperties.driverID), driverProperties.driverInfo, driverProperties.driverName);
 
+			enableOptionalFeatures(requiredFeatures, std::get<vk::PhysicalDevice>(candidate));
+
 			return std::tuple_cat(std::make_tuple(requiredFeatures), candidate);
 		}
 	}
@@ -479,6 +504,8 @@ std::string decodeVulkanDriverVersion(uint32_t vendorID, uint32_t driverVersion)
 
 		spdlog::debug("ware::contextVK::selectPhysicalDevice() => selected device: {}, vendor ID: {}, device ID: {}, Vulkan driver: {}, device driver: {} {} ({})", properties.deviceName, properties.vendorID, properties.deviceID, decodeVulkanDriverVersion(properties.vendorID, properties.driverVersion), vk::to_string(driverProperties.driverID), driverProperties.driverInfo, driverProperties.driverName);
 
+		enableOptionalFeatures(requiredFeatures, std::get<vk::PhysicalDevice>(physicalDeviceCandidates[0]));
+
 		return std::tuple_cat(std::make_tuple(requiredFeatures), physicalDeviceCandidates[0]);
 	}
 
@@ -527,7 +554,8 @@ int32_t findMatchingPresentationQueueFamily(vk::SurfaceKHR surface, vk::Physical
 		for (int32_t family = 0; family < static_cast<int32_t>(queueFamilyProperties2.size()); family++) {
 			const auto &properties = queueFamilyProperties2[family].queueFamilyProperties;
 
-			if (matchQueueFlags(properties.queueFlags, requirement.requiredFlags, requirement.notAllowedFlags) && physicalDevice.getSurfaceSupportKHR(family, surface)) {
+			// without a surface any family qualifies, headless frames end on the queue that renders them
+			if (matchQueueFlags(properties.queueFlags, requirement.requiredFlags, requirement.notAllowedFlags) && ( ! surface || physicalDevice.getSurfaceSupportKHR(family, surface))) {
 				return family;
 			}
 		}
@@ -733,7 +761,7 @@ void distributeQueueCreateInfoPriorities(std::vector<vk::DeviceQueueCreateInfo>
 	return { std::move(queueCreateInfos), std::move(priorities) };
 }
 
-[[nodiscard]] std::tuple<vk::UniqueDevice, bool, bool, bool> createDevice(const vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features> &features, vk::PhysicalDevice physicalDevice, const QueueSources &queueSources) {
+[[nodiscard]] std::tuple<vk::UniqueDevice, bool, bool, bool, bool> createDevice(const vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features> &features, vk::PhysicalDevice physicalDevice, const QueueSources &queueSources, bool headless, bool enableDescriptorBuffer) {
 	using namespace std::literals;
 
 	const auto infoTuple = buildQueueCreateInfos(queueSources);
@@ -744,9 +772,12 @@ void distributeQueueCreateInfoPriorities(std::vector<vk::DeviceQueueCreateInfo>
 		return std::string{properties.extensionName};
 	});
 
-	std::vector<const char *> enabledExtensions{
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME
-	};
+	std::vector<const char *> enabledExtensions{};
+
+	// for presentation
+	if ( ! headless) {
+		enabledExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+	}
 
 	// for VMA
 	bool hasMemoryBudgetExtension = false;
@@ -769,6 +800,17 @@ void distributeQueueCreateInfoPriorities(std::vector<vk::DeviceQueueCreateInfo>
 		hasAmdDeviceCoherentMemoryExtension = true;
 	}
 
+	// for the descriptor heap, the pool backend stays as the fallback
+	bool hasDescriptorBufferExtension = false;
+	if (enableDescriptorBuffer && util::contains(availableExtensions, "VK_EXT_descriptor_buffer"sv)) {
+		const auto availableFeatures = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+
+		if (availableFeatures.get<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>().descriptorBuffer) {
+			enabledExtensions.push_back("VK_EXT_descriptor_buffer");
+			hasDescriptorBufferExtension = true;
+		}
+	}
+
 	spdlog::debug("ware::contextVK::createDevice() => enabling {} extension(s): {}", enabledExtensions.size(), fmt::join(enabledExtensions, ", "));
 
 	vk::StructureChain deviceCreateInfoChain{
@@ -782,14 +824,21 @@ void distributeQueueCreateInfoPriorities(std::vector<vk::DeviceQueueCreateInfo>
 			.ppEnabledExtensionNames = enabledExtensions.data(),
 			.pEnabledFeatures = nullptr,
 		},
+		vk::PhysicalDeviceDescriptorBufferFeaturesEXT{
+			.descriptorBuffer = true,
+		},
 		features.get<vk::PhysicalDeviceFeatures2>()
 	};
 
+	if ( ! hasDescriptorBufferExtension) {
+		deviceCreateInfoChain.unlink<vk::PhysicalDeviceDescriptorBufferFeaturesEXT>();
+	}
+
 	auto device = physicalDevice.createDeviceUnique(deviceCreateInfoChain.get());
 
 	VULKAN_HPP_DEFAULT_DISPATCHER.init(device.get());
 
-	return { std::move(device), hasMemoryBudgetExtension, hasMemoryPriorityExtension, hasAmdDeviceCoherentMemoryExtension };
+	return { std::move(device), hasMemoryBudgetExtension, hasMemoryPriorityExtension, hasAmdDeviceCoherentMemoryExtension, hasDescriptorBufferExtension };
 }
 
 vk::Queue retrievQueue(vk::Device device, std::vector<std::tuple<QueueSource, vk::Queue>> &retrievedQueues, QueueSource queueSource) {
@@ -878,34 +927,245 @@ vk::Queue retrievQueue(vk::Device device, std::vector<std::tuple<QueueSource, vk
 	return util::UniqueResource<VmaAllocator>{std::move(allocator), vmaDestroyAllocator};
 }
 
-vk::UniquePipelineCache createPipelineCache(vk::Device device) {
-	return device.createPipelineCacheUnique({
+// prepended to the driver blob, so that a cache from another device, driver build or a truncated write is never fed to the driver
+struct PipelineCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint32_t driverVersion;
+	uint32_t driverID;
+	uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+	char driverInfo[VK_MAX_DRIVER_INFO_SIZE];
+	uint64_t dataSize;
+	uint64_t dataHash;
+};
+
+const uint32_t pipelineCacheMagic = 0x50435650; // "PVCP"
+const uint32_t pipelineCacheVersion = 1;
+
+[[nodiscard]] PipelineCacheHeader buildPipelineCacheHeader(const vk::PhysicalDeviceProperties2 &physicalDeviceProperties2, const vk::PhysicalDeviceDriverProperties &physicalDeviceDriverProperties) {
+	const auto &properties = physicalDeviceProperties2.properties;
+
+	PipelineCacheHeader header{
+		.magic = pipelineCacheMagic,
+		.version = pipelineCacheVersion,
+		.vendorID = properties.vendorID,
+		.deviceID = properties.deviceID,
+		.driverVersion = properties.driverVersion,
+		.driverID = static_cast<uint32_t>(physicalDeviceDriverProperties.driverID),
+		.pipelineCacheUUID = {},
+		.driverInfo = {},
+		.dataSize = 0,
+		.dataHash = 0,
+	};
+
+	std::copy_n(properties.pipelineCacheUUID.data(), VK_UUID_SIZE, header.pipelineCacheUUID);
+	std::copy_n(physicalDeviceDriverProperties.driverInfo.data(), VK_MAX_DRIVER_INFO_SIZE, header.driverInfo);
+
+	return header;
+}
+
+[[nodiscard]] std::vector<std::byte> loadPipelineCacheData(const std::filesystem::path &filePath, const std::optional<std::vector<std::byte>> &contentsO, const PipelineCacheHeader &expectedHeader) {
+	if ( ! contentsO) {
+		spdlog::debug("ware::contextVK::loadPipelineCacheData() => no pipeline cache found at \"{}\"", filePath.string());
+		return {};
+	}
+
+	if (contentsO->size() < sizeof(PipelineCacheHeader)) {
+		spdlog::warn("ware::contextVK::loadPipelineCacheData() => pipeline cache \"{}\" is truncated (size: {})", filePath.string(), contentsO->size());
+		return {};
+	}
+
+	PipelineCacheHeader header{};
+	std::memcpy(&header, contentsO->data(), sizeof(PipelineCacheHeader));
+
+	const bool deviceMatches = header.magic == expectedHeader.magic
+		&& header.version == expectedHeader.version
+		&& header.vendorID == expectedHeader.vendorID
+		&& header.deviceID == expectedHeader.deviceID
+		&& header.driverVersion == expectedHeader.driverVersion
+		&& header.driverID == expectedHeader.driverID
+		&& std::memcmp(header.pipelineCacheUUID, expectedHeader.pipelineCacheUUID, VK_UUID_SIZE) == 0
+		&& std::memcmp(header.driverInfo, expectedHeader.driverInfo, VK_MAX_DRIVER_INFO_SIZE) == 0;
+
+	if ( ! deviceMatches) {
+		spdlog::info("ware::contextVK::loadPipelineCacheData() => pipeline cache \"{}\" belongs to another device or driver, ignoring", filePath.string());
+		return {};
+	}
+
+	auto data = std::span<const std::byte>{*contentsO}.subspan(sizeof(PipelineCacheHeader));
+
+	if (header.dataSize != data.size() || header.dataHash != util::hashBytes(data)) {
+		spdlog::warn("ware::contextVK::loadPipelineCacheData() => pipeline cache \"{}\" is corrupted, ignoring", filePath.string());
+		return {};
+	}
+
+	return std::vector<std::byte>(std::begin(data), std::end(data));
+}
+
+[[nodiscard]] std::tuple<vk::UniquePipelineCache, bool> createPipelineCache(vk::Device device, const std::vector<std::byte> &initialData) {
+	if ( ! initialData.empty()) {
+		try {
+			auto pipelineCache = device.createPipelineCacheUnique({
+				.initialDataSize = initialData.size(),
+				.pInitialData = initialData.data(),
+			});
+
+			return { std::move(pipelineCache), true };
+		}
+		catch (vk::SystemError const &e) {
+			spdlog::warn("ware::contextVK::createPipelineCache() => rejected stored pipeline cache: {}", e.what());
+		}
+	}
+
+	auto pipelineCache = device.createPipelineCacheUnique({
 		.initialDataSize = 0,
 		.pInitialData = nullptr,
 	});
+
+	return { std::move(pipelineCache), false };
 }
 
-void requestWaitIdle(State &context) {
-	if (context.requestedWaitIdle) {
-		return;
+bool savePipelineCache(State &context) {
+	ZoneScopedN("ware::contextVK::savePipelineCache()");
+
+	if ( ! context.device || ! context.pipelineCache || context.pipelineCachePath.empty()) {
+		return false;
 	}
 
-	spdlog::debug("ware::contextVK::requestWaitIdle() => waiting");
-	context.device->waitIdle();
-	context.presentationQueue.waitIdle();
-	context.requestedWaitIdle = true;
+	std::vector<uint8_t> data = context.device->getPipelineCacheData(context.pipelineCache.get());
+
+	context.pipelineCacheSaveTimePoint = std::chrono::steady_clock::now();
+
+	if (data.empty()) {
+		return false;
+	}
+
+	auto header = buildPipelineCacheHeader(context.physicalDeviceProperties2, context.physicalDeviceDriverProperties);
+	header.dataSize = data.size();
+	header.dataHash = util::hashBytes(data.data(), data.size());
+
+	// the driver may rewrite entries without the size changing, only identical contents skip the write
+	if (header.dataHash == context.pipelineCacheSavedHash) {
+		return false;
+	}
+
+	std::vector<std::byte> contents(sizeof(PipelineCacheHeader) + data.size());
+	std::memcpy(contents.data(), &header, sizeof(PipelineCacheHeader));
+	std::memcpy(contents.data() + sizeof(PipelineCacheHeader), data.data(), data.size());
+
+	if ( ! util::fsWriteBytesAtomic(context.pipelineCachePath, contents)) {
+		spdlog::warn("ware::contextVK::savePipelineCache() => unable to write pipeline cache \"{}\"", context.pipelineCachePath.string());
+		return false;
+	}
+
+	spdlog::debug("ware::contextVK::savePipelineCache() => saved pipeline cache \"{}\" (size: {})", context.pipelineCachePath.string(), data.size());
+
+	context.pipelineCacheSavedHash = header.dataHash;
+
+	return true;
+}
+
+[[nodiscard]] std::tuple<vk::UniqueDescriptorSetLayout, vk::UniqueDescriptorPool, vk::DescriptorSet, std::array<DescriptorHeapSlots, heapDescriptorTypes.size()>> createDescriptorHeap(const ware::config::State &config, vk::PhysicalDevice physicalDevice, vk::Device device, bool descriptorBuffer) {
+	const auto properties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+	const auto &limits = properties.get<vk::PhysicalDeviceProperties2>().properties.limits;
+	const auto &properties12 = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+
+	// every stage sees the whole heap, so both the per stage and the per set limits apply,
+	// descriptor buffers are always written while in use and come with the plain limits
+	const std::array<uint32_t, heapDescriptorTypes.size()> capacities = descriptorBuffer
+		? std::array<uint32_t, heapDescriptorTypes.size()>{
+			std::min({ config.vk.descriptorHeapSampledImages, limits.maxPerStageDescriptorSampledImages, limits.maxDescriptorSetSampledImages }),
+			std::min({ config.vk.descriptorHeapStorageImages, limits.maxPerStageDescriptorStorageImages, limits.maxDescriptorSetStorageImages }),
+			std::min({ config.vk.descriptorHeapSamplers, limits.maxPerStageDescriptorSamplers, limits.maxDescriptorSetSamplers }),
+		}
+		: std::array<uint32_t, heapDescriptorTypes.size()>{
+			std::min({ config.vk.descriptorHeapSampledImages, properties12.maxPerStageDescriptorUpdateAfterBindSampledImages, properties12.maxDescriptorSetUpdateAfterBindSampledImages }),
+			std::min({ config.vk.descriptorHeapStorageImages, properties12.maxPerStageDescriptorUpdateAfterBindStorageImages, properties12.maxDescriptorSetUpdateAfterBindStorageImages }),
+			std::min({ config.vk.descriptorHeapSamplers, properties12.maxPerStageDescriptorUpdateAfterBindSamplers, properties12.maxDescriptorSetUpdateAfterBindSamplers }),
+		};
+
+	std::vector<vk::DescriptorSetLayoutBinding> bindings{};
+	std::vector<vk::DescriptorBindingFlags> bindingFlags{};
+	std::vector<vk::DescriptorPoolSize> poolSizes{};
+
+	for (uint32_t binding = 0; binding < heapDescriptorTypes.size(); binding++) {
+		bindings.push_back(vk::DescriptorSetLayoutBinding{
+			.binding = binding,
+			.descriptorType = heapDescriptorTypes[binding],
+			.descriptorCount = capacities[binding],
+			.stageFlags = vk::ShaderStageFlagBits::eAll,
+			.pImmutableSamplers = nullptr,
+		});
+		// slots are written while frames that never touch them are still in flight
+		bindingFlags.push_back(vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eUpdateAfterBind | vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending);
+		poolSizes.push_back(vk::DescriptorPoolSize{
+			.type = heapDescriptorTypes[binding],
+			.descriptorCount = capacities[binding],
+		});
+	}
+
+	vk::StructureChain setLayoutCreateInfo{
+		vk::DescriptorSetLayoutCreateInfo{
+			.flags = descriptorBuffer ? vk::DescriptorSetLayoutCreateFlagBits::eDescriptorBufferEXT : vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+			.bindingCount = static_cast<uint32_t>(bindings.size()),
+			.pBindings = bindings.data(),
+		},
+		vk::DescriptorSetLayoutBindingFlagsCreateInfo{
+			.bindingCount = static_cast<uint32_t>(bindingFlags.size()),
+			.pBindingFlags = bindingFlags.data(),
+		},
+	};
+
+	// update-after-bind is not allowed for descriptor buffer layouts, they behave like it anyway
+	if (descriptorBuffer) {
+		setLayoutCreateInfo.unlink<vk::DescriptorSetLayoutBindingFlagsCreateInfo>();
+	}
+
+	auto setLayout = device.createDescriptorSetLayoutUnique(setLayoutCreateInfo.get());
+
+	spdlog::debug("ware::contextVK::createDescriptorHeap() => {} backend, {} sampled image(s), {} storage image(s), {} sampler(s)", descriptorBuffer ? "descriptor buffer" : "descriptor pool", capacities[0], capacities[1], capacities[2]);
+
+	std::array<DescriptorHeapSlots, heapDescriptorTypes.size()> slots{};
+	for (size_t binding = 0; binding < slots.size(); binding++) {
+		slots[binding].capacity = capacities[binding];
+	}
+
+	if (descriptorBuffer) {
+		return { std::move(setLayout), vk::UniqueDescriptorPool{}, vk::DescriptorSet{}, std::move(slots) };
+	}
+
+	auto descriptorPool = device.createDescriptorPoolUnique({
+		.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
+		.maxSets = 1,
+		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+		.pPoolSizes = poolSizes.data(),
+	});
+
+	const std::array setLayouts{
+		setLayout.get(),
+	};
+	std::vector<vk::DescriptorSet> descriptorSets = device.allocateDescriptorSets({
+		.descriptorPool = descriptorPool.get(),
+		.descriptorSetCount = static_cast<uint32_t>(setLayouts.size()),
+		.pSetLayouts = setLayouts.data(),
+	});
+
+	return { std::move(setLayout), std::move(descriptorPool), descriptorSets[0], std::move(slots) };
 }
 
 void destroyBuffer(BufferState &state) {
-	vmaDestroyBuffer(*state.allocator, static_cast<VkBuffer>(state.buffer), state.allocation);
+	vmaDestroyBuffer(state.allocator, static_cast<VkBuffer>(state.buffer), state.allocation);
 }
 
-UniqueBuffer createBuffer(State &context, vk::BufferCreateInfo &bufferCreateInfo, vma::AllocationCreateInfo &allocationCreateInfo) {
+// the context is still being set up while the descriptor heap allocates its buffer, that only has the allocator yet
+[[nodiscard]] UniqueBuffer createBuffer(VmaAllocator allocator, vk::BufferCreateInfo &bufferCreateInfo, vma::AllocationCreateInfo &allocationCreateInfo) {
 	vk::Buffer buffer{};
 	VmaAllocation allocation{};
 	VmaAllocationInfo allocationInfo{};
 
-	vmaCreateBuffer(context.allocator.get(), reinterpret_cast<VkBufferCreateInfo *>(&bufferCreateInfo), reinterpret_cast<VmaAllocationCreateInfo *>(&allocationCreateInfo), reinterpret_cast<VkBuffer *>(&buffer), &allocation, &allocationInfo);
+	vmaCreateBuffer(allocator, reinterpret_cast<VkBufferCreateInfo *>(&bufferCreateInfo), reinterpret_cast<VmaAllocationCreateInfo *>(&allocationCreateInfo), reinterpret_cast<VkBuffer *>(&buffer), &allocation, &allocationInfo);
 
 	return UniqueBuffer{
 		BufferState{
@@ -915,14 +1175,216 @@ UniqueBuffer createBuffer(State &context, vk::BufferCreateInfo &bufferCreateInfo
 			.size = allocationInfo.size,
 			.mappedData = allocationInfo.pMappedData,
 			.allocation = allocation,
-			.allocator = &context.allocator.get()
+			.allocator = allocator
 		},
 		destroyBuffer
 	};
 }
 
+// empty for the pool backend, the buffer holds the heap set laid out as the driver reports for setLayout
+[[nodiscard]] std::tuple<UniqueBuffer, vk::DeviceAddress, std::byte *, std::array<vk::DeviceSize, heapDescriptorTypes.size()>, std::array<size_t, heapDescriptorTypes.size()>> createDescriptorHeapBuffer(vk::PhysicalDevice physicalDevice, vk::Device device, VmaAllocator allocator, vk::DescriptorSetLayout setLayout, bool descriptorBuffer) {
+	if ( ! descriptorBuffer) {
+		return {};
+	}
+
+	const auto descriptorBufferProperties = physicalDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceDescriptorBufferPropertiesEXT>().get<vk::PhysicalDeviceDescriptorBufferPropertiesEXT>();
+
+	// in the order of heapDescriptorTypes
+	const std::array<size_t, heapDescriptorTypes.size()> descriptorSizes{
+		descriptorBufferProperties.sampledImageDescriptorSize,
+		descriptorBufferProperties.storageImageDescriptorSize,
+		descriptorBufferProperties.samplerDescriptorSize,
+	};
+
+	std::array<vk::DeviceSize, heapDescriptorTypes.size()> bindingOffsets{};
+	for (uint32_t binding = 0; binding < bindingOffsets.size(); binding++) {
+		bindingOffsets[binding] = device.getDescriptorSetLayoutBindingOffsetEXT(setLayout, binding);
+	}
+
+	const auto size = device.getDescriptorSetLayoutSizeEXT(setLayout);
+
+	vk::BufferCreateInfo bufferCreateInfo{
+		.size = size,
+		.usage = vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT | vk::BufferUsageFlagBits::eShaderDeviceAddress,
+		.sharingMode = vk::SharingMode::eExclusive,
+	};
+
+	// descriptors are written without flushing, device local when the host can write it directly (resizable BAR, integrated GPUs)
+	vma::AllocationCreateInfo allocationCreateInfo{
+		.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
+		.usage = vma::MemoryUsage::eAuto,
+		.requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent,
+		.preferredFlags = vk::MemoryPropertyFlagBits::eDeviceLocal,
+	};
+
+	// stays mapped for the lifetime of the heap
+	auto buffer = createBuffer(allocator, bufferCreateInfo, allocationCreateInfo);
+	auto mappedData = static_cast<std::byte *>(buffer->mappedData);
+
+	const auto bufferAddress = device.getBufferAddress({
+		.buffer = buffer->buffer,
+	});
+
+	spdlog::debug("ware::contextVK::createDescriptorHeapBuffer() => {} byte(s), descriptor sizes: {}", size, fmt::join(descriptorSizes, ", "));
+
+	return { std::move(buffer), bufferAddress, mappedData, bindingOffsets, descriptorSizes };
+}
+
+vk::UniqueSemaphore createTimelineSemaphore(vk::Device device) {
+	vk::StructureChain semaphoreCreateInfo{
+		vk::SemaphoreCreateInfo{},
+		vk::SemaphoreTypeCreateInfo{
+			.semaphoreType = vk::SemaphoreType::eTimeline,
+			.initialValue = 0,
+		},
+	};
+
+	return device.createSemaphoreUnique(semaphoreCreateInfo.get());
+}
+
+vk::SemaphoreSubmitInfo frameSignalInfo(const State &context) {
+	return vk::SemaphoreSubmitInfo{
+		.semaphore = context.frameTimeline.get(),
+		.value = context.frameValue,
+		.stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+	};
+}
+
+bool isFrameRetired(State &context, uint64_t frameValue) {
+	if (frameValue <= context.retiredFrameValue) {
+		return true;
+	}
+
+	context.retiredFrameValue = context.device->getSemaphoreCounterValue(context.frameTimeline.get());
+
+	return frameValue <= context.retiredFrameValue;
+}
+
+void waitForFrame(State &context, uint64_t frameValue) {
+	if (isFrameRetired(context, frameValue)) {
+		return;
+	}
+
+	ZoneScopedN("ware::contextVK::waitForFrame()");
+
+	const auto frameTimeline = context.frameTimeline.get();
+
+	vk::Result waitResult;
+	while ((waitResult = context.device->waitSemaphores({ .semaphoreCount = 1, .pSemaphores = &frameTimeline, .pValues = &frameValue }, std::numeric_limits<uint64_t>::max())) != vk::Result::eSuccess) {
+		spdlog::debug("ware::contextVK::waitForFrame() => retrying wait for frame timeline (result: {}, frame value: {})", vk::to_string(waitResult), frameValue);
+	}
+
+	context.retiredFrameValue = std::max(context.retiredFrameValue, frameValue);
+}
+
+void requestWaitIdle(State &context) {
+	if (context.requestedWaitIdle) {
+		return;
+	}
+
+	spdlog::debug("ware::contextVK::requestWaitIdle() => waiting");
+	context.device->waitIdle();
+	context.presentationQueue.waitIdle();
+	context.requestedWaitIdle = true;
+}
+
+template<class Description, class UniqueHandle, class Create>
+[[nodiscard]] auto getCached(std::mutex &mutex, ObjectCache<Description, UniqueHandle> &cache, const Description &description, uint64_t hash, Create &&create) {
+	std::scoped_lock lock{mutex};
+
+	auto &entries = cache.entries[hash];
+
+	auto cached = std::find_if(entries.begin(), entries.end(), [&] (const auto &entry) {
+		return entry.description == description;
+	});
+
+	if (cached != entries.end()) {
+		return cached->handle.get();
+	}
+
+	entries.push_back({
+		.description = description,
+		.handle = create(),
+	});
+	cache.size++;
+
+	return entries.back().handle.get();
+}
+
+vk::Sampler getSampler(State &context, const vk::SamplerCreateInfo &createInfo) {
+	if (createInfo.pNext) {
+		throw std::runtime_error{"Cached samplers do not support pNext chains"};
+	}
+
+	// everything after pNext is tightly packed 32 bit fields
+	const auto fields = reinterpret_cast<const std::byte *>(&createInfo.flags);
+	const auto hash = util::hashBytes(fields, sizeof(vk::SamplerCreateInfo) - offsetof(vk::SamplerCreateInfo, flags));
+
+	return getCached(context.objectCacheMutex, context.samplerCache, createInfo, hash, [&] {
+		return context.device->createSamplerUnique(createInfo);
+	});
+}
+
+vk::DescriptorSetLayout getDescriptorSetLayout(State &context, const DescriptorSetLayoutDescription &description) {
+	auto hash = util::hashValue(description.flags);
+	hash = util::hashBytes(description.bindings.data(), description.bindings.size() * sizeof(vk::DescriptorSetLayoutBinding), hash);
+	hash = util::hashBytes(description.bindingFlags.data(), description.bindingFlags.size() * sizeof(vk::DescriptorBindingFlags), hash);
+
+	return getCached(context.objectCacheMutex, context.descriptorSetLayoutCache, description, hash, [&] {
+		vk::StructureChain setLayoutCreateInfo{
+			vk::DescriptorSetLayoutCreateInfo{
+				.flags = description.flags,
+				.bindingCount = static_cast<uint32_t>(description.bindings.size()),
+				.pBindings = description.bindings.data(),
+			},
+			vk::DescriptorSetLayoutBindingFlagsCreateInfo{
+				.bindingCount = static_cast<uint32_t>(description.bindingFlags.size()),
+				.pBindingFlags = description.bindingFlags.data(),
+			},
+		};
+
+		return context.device->createDescriptorSetLayoutUnique(setLayoutCreateInfo.get());
+	});
+}
+
+vk::PipelineLayout getPipelineLayout(State &context, const PipelineLayoutDescription &description) {
+	auto hash = util::hashBytes(description.setLayouts.data(), description.setLayouts.size() * sizeof(vk::DescriptorSetLayout));
+	hash = util::hashBytes(description.pushConstantRanges.data(), description.pushConstantRanges.size() * sizeof(vk::PushConstantRange), hash);
+
+	return getCached(context.objectCacheMutex, context.pipelineLayoutCache, description, hash, [&] {
+		return context.device->createPipelineLayoutUnique({
+			.setLayoutCount = static_cast<uint32_t>(description.setLayouts.size()),
+			.pSetLayouts = description.setLayouts.data(),
+			.pushConstantRangeCount = static_cast<uint32_t>(description.pushConstantRanges.size()),
+			.pPushConstantRanges = description.pushConstantRanges.data(),
+		});
+	});
+}
+
+void destroyRetiredResources(State &context) {
+	if (context.deferredDestructions.empty()) {
+		return;
+	}
+
+	ZoneScopedN("ware::contextVK::destroyRetiredResources()");
+
+	std::erase_if(context.deferredDestructions, [&] (auto &deferredDestruction) {
+		if ( ! isFrameRetired(context, deferredDestruction.frameValue)) {
+			return false;
+		}
+
+		deferredDestruction.destroy();
+
+		return true;
+	});
+}
+
+UniqueBuffer createBuffer(State &context, vk::BufferCreateInfo &bufferCreateInfo, vma::AllocationCreateInfo &allocationCreateInfo) {
+	return createBuffer(context.allocator.get(), bufferCreateInfo, allocationCreateInfo);
+}
+
 void destroyImage(ImageState &state) {
-	vmaDestroyImage(*state.allocator, static_cast<VkImage>(state.image), state.allocation);
+	vmaDestroyImage(state.allocator, static_cast<VkImage>(state.image), state.allocation);
 }
 
 UniqueImage createImage(State &context, vk::ImageCreateInfo &imageCreateInfo, vma::AllocationCreateInfo &allocationCreateInfo) {
@@ -942,18 +1404,51 @@ UniqueImage createImage(State &context, vk::ImageCreateInfo &imageCreateInfo, vm
 			.size = allocationInfo.size,
 			.mappedData = allocationInfo.pMappedData,
 			.allocation = allocation,
-			.allocator = &context.allocator.get()
+			.allocator = context.allocator.get()
 		},
 		destroyImage
 	};
 }
 
+void freeMemory(MemoryState &state) {
+	vmaFreeMemory(state.allocator, state.allocation);
+}
+
+UniqueMemory allocateMemory(State &context, const vk::MemoryRequirements &memoryRequirements, vma::AllocationCreateInfo &allocationCreateInfo) {
+	VmaAllocation allocation{};
+	VmaAllocationInfo allocationInfo{};
+
+	vk::Result result = static_cast<vk::Result>(vmaAllocateMemory(context.allocator.get(), reinterpret_cast<const VkMemoryRequirements *>(&memoryRequirements), reinterpret_cast<VmaAllocationCreateInfo *>(&allocationCreateInfo), &allocation, &allocationInfo));
+	if (result != vk::Result::eSuccess) {
+		throw std::runtime_error{fmt::format("Unable to allocate memory (size: {}, result: {})", memoryRequirements.size, vk::to_string(result))};
+	}
+
+	return UniqueMemory{
+		MemoryState{
+			.memory = static_cast<vk::DeviceMemory>(allocationInfo.deviceMemory),
+			.offset = allocationInfo.offset,
+			.size = allocationInfo.size,
+			.memoryType = allocationInfo.memoryType,
+			.allocation = allocation,
+			.allocator = context.allocator.get()
+		},
+		freeMemory
+	};
+}
+
+void bindImageMemory(UniqueMemory &memory, vk::DeviceSize offset, vk::Image image) {
+	vk::Result result = static_cast<vk::Result>(vmaBindImageMemory2(memory->allocator, memory->allocation, offset, static_cast<VkImage>(image), nullptr));
+	if (result != vk::Result::eSuccess) {
+		throw std::runtime_error{fmt::format("Unable to bind image memory (offset: {}, result: {})", offset, vk::to_string(result))};
+	}
+}
+
 void flushMappedData(UniqueBuffer &buffer, vk::DeviceSize offset, vk::DeviceSize size) {
 	if (size == VK_WHOLE_SIZE) {
 		size = buffer->size - std::min(buffer->size, offset);
 	}
 
-	vmaFlushAllocation(*buffer->allocator, buffer->allocation, offset, size);
+	vmaFlushAllocation(buffer->allocator, buffer->allocation, offset, size);
 }
 
 void flushMappedData(UniqueImage &image, vk::DeviceSize offset, vk::DeviceSize size) {
@@ -961,10 +1456,164 @@ void flushMappedData(UniqueImage &image, vk::DeviceSize offset, vk::DeviceSize s
 		size = image->size - std::min(image->size, offset);
 	}
 
-	vmaFlushAllocation(*image->allocator, image->allocation, offset, size);
+	vmaFlushAllocation(image->allocator, image->allocation, offset, size);
 }
 
-State setup(ware::config::State &config, [[maybe_unused]] ware::contextGLFW::State &glfw, ware::windowGLFW::State &window) {
+void destroyDescriptor(DescriptorState &state) {
+	auto &heap = *state.heap;
+
+	std::scoped_lock lock{heap.mutex};
+
+	// the stale descriptor stays in the slot, partially bound heaps never read slots that are not in use
+	heap.slots[static_cast<size_t>(state.binding)].freeIndices.push_back(state.index);
+}
+
+// the caller holds the heap mutex
+void writeDescriptor(State &context, HeapBinding binding, uint32_t index, const vk::DescriptorImageInfo &imageInfo) {
+	auto &heap = context.descriptorHeap;
+	const auto bindingIndex = static_cast<uint32_t>(binding);
+
+	if ( ! heap.descriptorBuffer) {
+		context.device->updateDescriptorSets({
+			vk::WriteDescriptorSet{
+				.dstSet = heap.descriptorSet,
+				.dstBinding = bindingIndex,
+				.dstArrayElement = index,
+				.descriptorCount = 1,
+				.descriptorType = heapDescriptorTypes[bindingIndex],
+				.pImageInfo = &imageInfo,
+			},
+		}, {});
+
+		return;
+	}
+
+	vk::DescriptorDataEXT data{};
+	switch (binding) {
+		case HeapBinding::eSampledImages:
+			data.pSampledImage = &imageInfo;
+			break;
+		case HeapBinding::eStorageImages:
+			data.pStorageImage = &imageInfo;
+			break;
+		case HeapBinding::eSamplers:
+			data.pSampler = &imageInfo.sampler;
+			break;
+	}
+
+	// no staging and no command buffer, the driver encodes the descriptor right into the mapped heap
+	const auto descriptorSize = heap.descriptorSizes[bindingIndex];
+	context.device->getDescriptorEXT({
+		.type = heapDescriptorTypes[bindingIndex],
+		.data = data,
+	}, descriptorSize, heap.mappedData + heap.bindingOffsets[bindingIndex] + index * descriptorSize);
+}
+
+[[nodiscard]] UniqueDescriptor createDescriptor(State &context, HeapBinding binding, const vk::DescriptorImageInfo &imageInfo) {
+	auto &heap = context.descriptorHeap;
+	const auto bindingIndex = static_cast<uint32_t>(binding);
+
+	std::scoped_lock lock{heap.mutex};
+
+	auto &slots = heap.slots[bindingIndex];
+
+	uint32_t index = 0;
+	if ( ! slots.freeIndices.empty()) {
+		index = slots.freeIndices.back();
+		slots.freeIndices.pop_back();
+	} else if (slots.nextIndex < slots.capacity) {
+		index = slots.nextIndex++;
+	} else {
+		throw std::runtime_error{fmt::format("The descriptor heap has no free {} slot left (capacity: {})", vk::to_string(heapDescriptorTypes[bindingIndex]), slots.capacity)};
+	}
+
+	writeDescriptor(context, binding, index, imageInfo);
+
+	return UniqueDescriptor{
+		DescriptorState{
+			.heap = &heap,
+			.binding = binding,
+			.index = index,
+		},
+		destroyDescriptor
+	};
+}
+
+UniqueDescriptor createSampledImageDescriptor(State &context, vk::ImageView imageView, vk::ImageLayout imageLayout) {
+	return createDescriptor(context, HeapBinding::eSampledImages, {
+		.imageView = imageView,
+		.imageLayout = imageLayout,
+	});
+}
+
+UniqueDescriptor createStorageImageDescriptor(State &context, vk::ImageView imageView) {
+	return createDescriptor(context, HeapBinding::eStorageImages, {
+		.imageView = imageView,
+		.imageLayout = vk::ImageLayout::eGeneral,
+	});
+}
+
+UniqueDescriptor createSamplerDescriptor(State &context, vk::Sampler sampler) {
+	return createDescriptor(context, HeapBinding::eSamplers, {
+		.sampler = sampler,
+	});
+}
+
+void updateSampledImageDescriptor(State &context, UniqueDescriptor &descriptor, vk::ImageView imageView, vk::ImageLayout imageLayout) {
+	if (descriptor->binding != HeapBinding::eSampledImages) {
+		throw std::runtime_error{"Only sampled image descriptors can be updated with a sampled image"};
+	}
+
+	std::scoped_lock lock{context.descriptorHeap.mutex};
+
+	writeDescriptor(context, HeapBinding::eSampledImages, descriptor->index, {
+		.imageView = imageView,
+		.imageLayout = imageLayout,
+	});
+}
+
+vk::PipelineCreateFlags descriptorHeapPipelineFlags(const State &context) {
+	return context.descriptorHeap.descriptorBuffer ? vk::PipelineCreateFlags{vk::PipelineCreateFlagBits::eDescriptorBufferEXT} : vk::PipelineCreateFlags{};
+}
+
+void bindDescriptorHeap(const State &context, vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout, uint32_t set) {
+	const auto &heap = context.descriptorHeap;
+
+	if ( ! heap.descriptorBuffer) {
+		commandBuffer.bindDescriptorSets(bindPoint, layout, set, 1, &heap.descriptorSet, 0, nullptr);
+		return;
+	}
+
+	// the heap is the only descriptor buffer, so it is always buffer 0 at offset 0
+	const vk::DescriptorBufferBindingInfoEXT bindingInfo{
+		.address = heap.bufferAddress,
+		.usage = vk::BufferUsageFlagBits::eResourceDescriptorBufferEXT | vk::BufferUsageFlagBits::eSamplerDescriptorBufferEXT,
+	};
+	commandBuffer.bindDescriptorBuffersEXT(1, &bindingInfo);
+
+	const uint32_t bufferIndex = 0;
+	const vk::DeviceSize offset = 0;
+	commandBuffer.setDescriptorBufferOffsetsEXT(bindPoint, layout, set, 1, &bufferIndex, &offset);
+}
+
+State::~State() {
+	if ( ! deferredDestructions.empty()) {
+		spdlog::debug("ware::contextVK::~State() => destroying {} deferred resource group(s)", deferredDestructions.size());
+
+		requestWaitIdle(*this);
+
+		for (auto &deferredDestruction : deferredDestructions) {
+			deferredDestruction.destroy();
+		}
+		deferredDestructions.clear();
+	}
+
+	savePipelineCache(*this);
+
+	spdlog::debug("ware::contextVK::~State() => cached {} sampler(s), {} descriptor set layout(s), {} pipeline layout(s)", samplerCache.size, descriptorSetLayoutCache.size, pipelineLayoutCache.size);
+}
+
+Instance setupInstance(ware::config::State &config, ware::contextGLFW::State &glfw) {
 	auto [instance, hasDebugUtilsExtension] = createInstance(config, glfw);
 
 	vk::UniqueDebugUtilsMessengerEXT debugUtilsMessanger{};
@@ -972,25 +1621,57 @@ State setup(ware::config::State &config, [[maybe_unused]] ware::contextGLFW::Sta
 		debugUtilsMessanger = createDebugUtilsMessanger(config, instance.get());
 	}
 
-	auto surface = createSurface(window, instance.get());
+	return Instance{
+		.instance = std::move(instance),
+		.debugUtilsMessanger = std::move(debugUtilsMessanger),
+	};
+}
 
-	auto [features, physicalDevice, physicalDeviceProperties2, physicalDeviceMemoryProperties2, queueFamilyProperties2] = selectPhysicalDevice(config, instance.get(), surface.get());
+State setup(ware::config::State &config, [[maybe_unused]] ware::contextGLFW::State &glfw, ware::windowGLFW::State &window, Instance &&instance, util::JobSystem &jobs) {
+	std::filesystem::path pipelineCachePath{config.vk.pipelineCachePath};
+
+	// the cache file is read while the device is selected and created, it is only validated against the device afterwards
+	std::optional<std::vector<std::byte>> pipelineCacheContents{};
+	util::JobScope pipelineCacheRead{jobs};
+	if ( ! pipelineCachePath.empty()) {
+		pipelineCacheRead.run("ware::contextVK::setup()#read pipeline cache", [&] {
+			pipelineCacheContents = util::fsReadBytes(pipelineCachePath);
+		});
+	}
+
+	auto surface = config.window.headless ? vk::UniqueSurfaceKHR{} : createSurface(window, instance.instance.get());
+
+	auto [features, physicalDevice, physicalDeviceProperties2, physicalDeviceMemoryProperties2, queueFamilyProperties2] = selectPhysicalDevice(config, instance.instance.get(), surface.get());
 
 	auto queueSources = chooseQueueSources(config, surface.get(), physicalDevice, queueFamilyProperties2);
 
-	auto [device, hasMemoryBudgetExtension, hasMemoryPriorityExtension, hasAmdDeviceCoherentMemoryExtension] = createDevice(features, physicalDevice, queueSources);
+	auto [device, hasMemoryBudgetExtension, hasMemoryPriorityExtension, hasAmdDeviceCoherentMemoryExtension, hasDescriptorBufferExtension] = createDevice(features, physicalDevice, queueSources, config.window.headless, config.vk.enableDescriptorBuffer);
 
 	auto [presentation, graphic, compute, transfer] = selectQueues(device.get(), queueSources);
 
-	auto allocator = createAllocator(instance.get(), physicalDevice, device.get(), hasMemoryBudgetExtension, hasMemoryPriorityExtension, hasAmdDeviceCoherentMemoryExtension);
+	auto allocator = createAllocator(instance.instance.get(), physicalDevice, device.get(), hasMemoryBudgetExtension, hasMemoryPriorityExtension, hasAmdDeviceCoherentMemoryExtension);
+
+	pipelineCacheRead.wait();
+
+	auto pipelineCacheData = pipelineCachePath.empty()
+		? std::vector<std::byte>{}
+		: loadPipelineCacheData(pipelineCachePath, pipelineCacheContents, buildPipelineCacheHeader(physicalDeviceProperties2.get<vk::PhysicalDeviceProperties2>(), physicalDeviceProperties2.get<vk::PhysicalDeviceDriverProperties>()));
+
+	auto [pipelineCache, pipelineCacheLoaded] = createPipelineCache(device.get(), pipelineCacheData);
+
+	spdlog::debug("ware::contextVK::setup() => pipeline cache {} (size: {})", pipelineCacheLoaded ? "loaded" : "created empty", pipelineCacheData.size());
 
-	auto pipelineCache = createPipelineCache(device.get());
+	auto [heapSetLayout, heapDescriptorPool, heapDescriptorSet, heapSlots] = createDescriptorHeap(config, physicalDevice, device.get(), hasDescriptorBufferExtension);
+	auto [heapBuffer, heapBufferAddress, heapMappedData, heapBindingOffsets, heapDescriptorSizes] = createDescriptorHeapBuffer(physicalDevice, device.get(), allocator.get(), heapSetLayout.get(), hasDescriptorBufferExtension);
+
+	auto frameTimeline = createTimelineSemaphore(device.get());
 
 	return State{
-		.instance = std::move(instance),
-		.debugUtilsMessanger = std::move(debugUtilsMessanger),
+		.instance = std::move(instance.instance),
+		.debugUtilsMessanger = std::move(instance.debugUtilsMessanger),
 		.surface = std::move(surface),
 		.features = features,
+		.hasPipelineStatisticsQuery = features.get<vk::PhysicalDeviceFeatures2>().features.pipelineStatisticsQuery == VK_TRUE,
 		.physicalDevice = std::move(physicalDevice),
 		.physicalDeviceProperties2 = physicalDeviceProperties2.get<vk::PhysicalDeviceProperties2>(),
 		.physicalDeviceDriverProperties = physicalDeviceProperties2.get<vk::PhysicalDeviceDriverProperties>(),
@@ -1011,7 +1692,33 @@ State setup(ware::config::State &config, [[maybe_unused]] ware::contextGLFW::Sta
 		.transferQueueIndex = static_cast<uint32_t>(queueSources.transfer.index),
 		.allocator = std::move(allocator),
 		.pipelineCache = std::move(pipelineCache),
+		.pipelineCachePath = std::move(pipelineCachePath),
+		.pipelineCacheLoaded = pipelineCacheLoaded,
+		.pipelineCacheSavedHash = pipelineCacheLoaded ? std::optional{util::hashBytes(pipelineCacheData)} : std::nullopt,
+		.pipelineCacheSaveInterval = std::chrono::seconds{config.vk.pipelineCacheSaveInterval},
+		.pipelineCacheSaveTimePoint = std::chrono::steady_clock::now(),
+		.objectCacheMutex = {},
+		.samplerCache = {},
+		.descriptorSetLayoutCache = {},
+		.pipelineLayoutCache = {},
+		.descriptorHeap = {
+			.descriptorBuffer = hasDescriptorBufferExtension,
+			.setLayout = std::move(heapSetLayout),
+			.descriptorPool = std::move(heapDescriptorPool),
+			.descriptorSet = heapDescriptorSet,
+			.buffer = std::move(heapBuffer),
+			.bufferAddress = heapBufferAddress,
+			.mappedData = heapMappedData,
+			.bindingOffsets = heapBindingOffsets,
+			.descriptorSizes = heapDescriptorSizes,
+			.mutex = {},
+			.slots = std::move(heapSlots),
+		},
+		.frameTimeline = std::move(frameTimeline),
+		.frameValue = 0,
+		.retiredFrameValue = 0,
 		.requestedWaitIdle = false,
+		.deferredDestructions = {},
 	};
 }
 
@@ -1021,6 +1728,11 @@ void refresh([[maybe_unused]] State &state) {
 	if (state.requestedWaitIdle) {
 		state.requestedWaitIdle = false;
 	}
+
+	state.frameValue++;
+	state.retiredFrameValue = state.device->getSemaphoreCounterValue(state.frameTimeline.get());
+
+	destroyRetiredResources(state);
 }
 
 void process([[maybe_unused]] State &state) {
@@ -1029,6 +1741,10 @@ void process([[maybe_unused]] State &state) {
 	if (state.requestedWaitIdle) {
 		state.requestedWaitIdle = false;
 	}
+
+	if (state.pipelineCacheSaveInterval.count() > 0 && std::chrono::steady_clock::now() - state.pipelineCacheSaveTimePoint >= state.pipelineCacheSaveInterval) {
+		savePipelineCache(state);
+	}
 }
 
 } // ware::contextVK
@@ -1,7 +1,20 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
 #include <vulkan/vulkan.hpp>
 
+#include <util/jobSystem.hpp>
 #include <util/uniqueResource.hpp>
 
 #include "../config/config.hpp"
@@ -11,11 +24,102 @@
 
 namespace ware::contextVK {
 
+struct DeferredDestruction {
+	uint64_t frameValue;
+	std::move_only_function<void()> destroy;
+};
+
+// needs neither the window nor a device, so it can be created while the window is
+struct Instance {
+	vk::UniqueInstance instance;
+	vk::UniqueDebugUtilsMessengerEXT debugUtilsMessanger;
+};
+
+// identical descriptions share one handle, which lives as long as the context
+struct DescriptorSetLayoutDescription {
+	vk::DescriptorSetLayoutCreateFlags flags;
+	// without immutable samplers
+	std::vector<vk::DescriptorSetLayoutBinding> bindings;
+	// empty or one per binding
+	std::vector<vk::DescriptorBindingFlags> bindingFlags;
+
+	bool operator==(const DescriptorSetLayoutDescription &other) const = default;
+};
+
+struct PipelineLayoutDescription {
+	std::vector<vk::DescriptorSetLayout> setLayouts;
+	std::vector<vk::PushConstantRange> pushConstantRanges;
+
+	bool operator==(const PipelineLayoutDescription &other) const = default;
+};
+
+// hash-consed objects, looked up by the hash of their description
+template<class Description, class UniqueHandle>
+struct ObjectCache {
+	struct Entry {
+		Description description;
+		UniqueHandle handle;
+	};
+
+	// more than one entry per hash only on collisions
+	std::unordered_map<uint64_t, std::vector<Entry>> entries;
+	size_t size;
+};
+
+// the bindings of the bindless descriptor heap, each one a runtime array of a single descriptor type
+enum class HeapBinding : uint32_t {
+	eSampledImages = 0,
+	eStorageImages = 1,
+	eSamplers = 2,
+};
+
+const std::array<vk::DescriptorType, 3> heapDescriptorTypes{ vk::DescriptorType::eSampledImage, vk::DescriptorType::eStorageImage, vk::DescriptorType::eSampler };
+
+struct DescriptorHeapSlots {
+	uint32_t capacity;
+	// indices from here on have never been handed out
+	uint32_t nextIndex;
+	std::vector<uint32_t> freeIndices;
+};
+
+struct BufferState {
+	vk::Buffer buffer;
+	vk::DeviceMemory memory;
+	vk::DeviceSize offset;
+	vk::DeviceSize size;
+	void *mappedData;
+	VmaAllocation allocation;
+	VmaAllocator allocator;
+};
+
+using UniqueBuffer = util::UniqueResource<BufferState, void (*)(BufferState &)>;
+
+// one set shared by every pipeline, shaders index it with what the passes push as constants
+struct DescriptorHeap {
+	// with VK_EXT_descriptor_buffer descriptors are written straight into a mapped buffer,
+	// otherwise into an update-after-bind set allocated from a pool
+	bool descriptorBuffer;
+	vk::UniqueDescriptorSetLayout setLayout;
+	vk::UniqueDescriptorPool descriptorPool;
+	vk::DescriptorSet descriptorSet;
+	UniqueBuffer buffer;
+	vk::DeviceAddress bufferAddress;
+	// host visible and coherent
+	std::byte *mappedData;
+	// by binding
+	std::array<vk::DeviceSize, heapDescriptorTypes.size()> bindingOffsets;
+	std::array<size_t, heapDescriptorTypes.size()> descriptorSizes;
+	// descriptors are created from setup jobs, writes into the set have to be synchronized as well
+	std::mutex mutex;
+	std::array<DescriptorHeapSlots, heapDescriptorTypes.size()> slots;
+};
+
 struct State {
 	vk::UniqueInstance instance;
 	vk::UniqueDebugUtilsMessengerEXT debugUtilsMessanger;
 	vk::UniqueSurfaceKHR surface;
 	vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features> &features;
+	bool hasPipelineStatisticsQuery;
 	vk::PhysicalDevice physicalDevice;
 	vk::PhysicalDeviceProperties2 physicalDeviceProperties2;
 	vk::PhysicalDeviceDriverProperties physicalDeviceDriverProperties;
@@ -36,43 +140,123 @@ struct State {
 	uint32_t transferQueueIndex;
 	util::UniqueResource<VmaAllocator> allocator;
 	vk::UniquePipelineCache pipelineCache;
+	std::filesystem::path pipelineCachePath;
+	bool pipelineCacheLoaded;
+	// of the data last written or loaded, none before
+	std::optional<uint64_t> pipelineCacheSavedHash;
+	std::chrono::seconds pipelineCacheSaveInterval;
+	std::chrono::steady_clock::time_point pipelineCacheSaveTimePoint;
+	// passes are set up from several jobs at once
+	std::mutex objectCacheMutex;
+	ObjectCache<vk::SamplerCreateInfo, vk::UniqueSampler> samplerCache;
+	ObjectCache<DescriptorSetLayoutDescription, vk::UniqueDescriptorSetLayout> descriptorSetLayoutCache;
+	ObjectCache<PipelineLayoutDescription, vk::UniquePipelineLayout> pipelineLayoutCache;
+	// outlives the deferred destructions, they return descriptors into it
+	DescriptorHeap descriptorHeap;
+	vk::UniqueSemaphore frameTimeline;
+	uint64_t frameValue;
+	uint64_t retiredFrameValue;
 	bool requestedWaitIdle;
+	// declared last so that pending destructions run before the allocator and the device go away
+	std::vector<DeferredDestruction> deferredDestructions;
+
+	~State();
 };
 
-struct BufferState {
-	vk::Buffer buffer;
+struct ImageState {
+	vk::Image image;
+	vk::Format format;
+	vk::Extent3D extent;
 	vk::DeviceMemory memory;
 	vk::DeviceSize offset;
 	vk::DeviceSize size;
 	void *mappedData;
 	VmaAllocation allocation;
-	VmaAllocator *allocator;
+	VmaAllocator allocator;
 };
 
-struct ImageState {
-	vk::Image image;
-	vk::Format format;
-	vk::Extent3D extent;
+// memory without a resource of its own, resources are bound into it at an offset
+struct MemoryState {
 	vk::DeviceMemory memory;
 	vk::DeviceSize offset;
 	vk::DeviceSize size;
-	void *mappedData;
+	uint32_t memoryType;
 	VmaAllocation allocation;
-	VmaAllocator *allocator;
+	VmaAllocator allocator;
+};
+
+// a slot of the descriptor heap
+struct DescriptorState {
+	DescriptorHeap *heap;
+	HeapBinding binding;
+	uint32_t index;
 };
 
-using UniqueBuffer = util::UniqueResource<BufferState, void (*)(BufferState &)>;
 using UniqueImage = util::UniqueResource<ImageState, void (*)(ImageState &)>;
+using UniqueMemory = util::UniqueResource<MemoryState, void (*)(MemoryState &)>;
+using UniqueDescriptor = util::UniqueResource<DescriptorState, void (*)(DescriptorState &)>;
 
 void requestWaitIdle(State &context);
 
+[[nodiscard]] vk::UniqueSemaphore createTimelineSemaphore(vk::Device device);
+
+// frame N signals frameTimeline with value N once all of its GPU work is done
+vk::SemaphoreSubmitInfo frameSignalInfo(const State &context);
+bool isFrameRetired(State &context, uint64_t frameValue);
+void waitForFrame(State &context, uint64_t frameValue);
+
+// resources are destroyed in argument order once frameValue has retired, resources last used by the current frame pass context.frameValue
+template<class... T>
+void deferDestroy(State &context, uint64_t frameValue, T &&...resources) {
+	static_assert((! std::is_lvalue_reference_v<T> && ...), "deferDestroy() takes ownership, resources have to be moved in");
+
+	context.deferredDestructions.push_back(DeferredDestruction{
+		.frameValue = frameValue,
+		.destroy = [resources = std::make_tuple(std::move(resources)...)] () mutable {
+			std::apply([] (auto &...resource) {
+				([] (auto &destroyed) { [[maybe_unused]] auto released = std::move(destroyed); }(resource), ...);
+			}, resources);
+		},
+	});
+}
+
+void destroyRetiredResources(State &context);
+
+bool savePipelineCache(State &context);
+
+// shared handles for identical create infos, owned by the context and never destroyed before it, pNext chains are not supported
+[[nodiscard]] vk::Sampler getSampler(State &context, const vk::SamplerCreateInfo &createInfo);
+[[nodiscard]] vk::DescriptorSetLayout getDescriptorSetLayout(State &context, const DescriptorSetLayoutDescription &description);
+[[nodiscard]] vk::PipelineLayout getPipelineLayout(State &context, const PipelineLayoutDescription &description);
+
+// the index stays valid while the descriptor lives and is handed out again afterwards,
+// so the descriptor goes through deferDestroy() together with the resource it describes
+[[nodiscard]] UniqueDescriptor createSampledImageDescriptor(State &context, vk::ImageView imageView, vk::ImageLayout imageLayout);
+[[nodiscard]] UniqueDescriptor createStorageImageDescriptor(State &context, vk::ImageView imageView);
+[[nodiscard]] UniqueDescriptor createSamplerDescriptor(State &context, vk::Sampler sampler);
+
+// rewrites the slot in place, only while no frame in flight reads it
+void updateSampledImageDescriptor(State &context, UniqueDescriptor &descriptor, vk::ImageView imageView, vk::ImageLayout imageLayout);
+
+// pipelines indexing the heap are created with these flags
+[[nodiscard]] vk::PipelineCreateFlags descriptorHeapPipelineFlags(const State &context);
+
+// binds the heap at set of layout, either as a set or as a descriptor buffer
+void bindDescriptorHeap(const State &context, vk::CommandBuffer commandBuffer, vk::PipelineBindPoint bindPoint, vk::PipelineLayout layout, uint32_t set);
+
 UniqueBuffer createBuffer(State &context, vk::BufferCreateInfo &bufferCreateInfo, vma::AllocationCreateInfo &allocationCreateInfo);
 UniqueImage createImage(State &context, vk::ImageCreateInfo &imageCreateInfo, vma::AllocationCreateInfo &allocationCreateInfo);
+UniqueMemory allocateMemory(State &context, const vk::MemoryRequirements &memoryRequirements, vma::AllocationCreateInfo &allocationCreateInfo);
+
+void bindImageMemory(UniqueMemory &memory, vk::DeviceSize offset, vk::Image image);
 
 void flushMappedData(UniqueBuffer &buffer, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
 void flushMappedData(UniqueImage &image, vk::DeviceSize offset = 0, vk::DeviceSize size = VK_WHOLE_SIZE);
 
-State setup(ware::config::State &config, ware::contextGLFW::State &glfw, ware::windowGLFW::State &window);
+// safe to call from a job, GLFW allows querying the Vulkan loader and extensions from any thread
+[[nodiscard]] Instance setupInstance(ware::config::State &config, ware::contextGLFW::State &glfw);
+
+State setup(ware::config::State &config, ware::contextGLFW::State &glfw, ware::windowGLFW::State &window, Instance &&instance, util::JobSystem &jobs);
 
 void refresh(State &state);
 
@@ -0,0 +1,331 @@
+#include "graph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <util/map.hpp>
+
+namespace ware::rendererVK::graph {
+
+const vk::AccessFlags2 writeAccessMask = vk::AccessFlagBits2::eShaderWrite
+	| vk::AccessFlagBits2::eShaderStorageWrite
+	| vk::AccessFlagBits2::eColorAttachmentWrite
+	| vk::AccessFlagBits2::eDepthStencilAttachmentWrite
+	| vk::AccessFlagBits2::eTransferWrite
+	| vk::AccessFlagBits2::eHostWrite
+	| vk::AccessFlagBits2::eMemoryWrite;
+
+// what has happened to an image since its last write, enough to decide whether the next use needs a barrier
+struct Tracking {
+	vk::ImageLayout layout;
+	vk::PipelineStageFlags2 writeStageMask;
+	vk::AccessFlags2 writeAccessMask;
+	// reads since the last write, a later write has to wait for them
+	vk::PipelineStageFlags2 readStageMask;
+	// stages and accesses the last write has already been made visible to
+	vk::PipelineStageFlags2 visibleStageMask;
+	vk::AccessFlags2 visibleAccessMask;
+	bool touched;
+};
+
+ResourceId addImage(State &state, Image &&image) {
+	state.images.push_back(std::move(image));
+
+	return static_cast<ResourceId>(state.images.size() - 1);
+}
+
+PassId addPass(State &state, Pass &&pass) {
+	for (const auto &use : pass.uses) {
+		if (use.resource >= state.images.size()) {
+			throw std::runtime_error{fmt::format("Render graph pass \"{}\" uses unknown resource {}", pass.name, use.resource)};
+		}
+	}
+
+	state.passes.push_back(std::move(pass));
+
+	return static_cast<PassId>(state.passes.size() - 1);
+}
+
+void bindImage(State &state, ResourceId resource, vk::Image image) {
+	state.images[resource].image = image;
+}
+
+void aliasImage(State &state, ResourceId resource, std::optional<ResourceId> aliasedResource) {
+	state.images[resource].aliasedResource = aliasedResource;
+}
+
+bool isCulled(const State &state, PassId pass) {
+	return state.culled[pass];
+}
+
+std::optional<Lifetime> findLifetime(const State &state, ResourceId resource) {
+	std::optional<Lifetime> lifetime{};
+
+	for (uint32_t position = 0; position < state.order.size(); position++) {
+		const auto &uses = state.passes[state.order[position]].uses;
+		const bool used = std::any_of(uses.begin(), uses.end(), [&] (const auto &use) {
+			return use.resource == resource;
+		});
+
+		if ( ! used) {
+			continue;
+		}
+
+		if (lifetime) {
+			lifetime->last = position;
+		} else {
+			lifetime = Lifetime{
+				.first = position,
+				.last = position,
+			};
+		}
+	}
+
+	return lifetime;
+}
+
+std::vector<std::vector<PassId>> buildDependencies(const State &state) {
+	// a use depends on the previous write of its resource, a write also on every read since that write
+	std::vector<std::vector<PassId>> dependencies(state.passes.size());
+	std::vector<std::vector<PassId>> readers(state.images.size());
+	std::vector<int64_t> writers(state.images.size(), -1);
+
+	for (PassId pass = 0; pass < state.passes.size(); pass++) {
+		for (const auto &use : state.passes[pass].uses) {
+			if (writers[use.resource] >= 0) {
+				dependencies[pass].push_back(static_cast<PassId>(writers[use.resource]));
+			}
+
+			if (use.write) {
+				dependencies[pass].insert(dependencies[pass].end(), readers[use.resource].begin(), readers[use.resource].end());
+				readers[use.resource].clear();
+				writers[use.resource] = pass;
+			} else {
+				readers[use.resource].push_back(pass);
+			}
+		}
+	}
+
+	return dependencies;
+}
+
+std::vector<bool> cullPasses(const State &state, const std::vector<std::vector<PassId>> &dependencies) {
+	std::vector<bool> culled(state.passes.size(), true);
+	std::vector<PassId> pending{};
+
+	// live passes are the writers of outputs and everything they depend on
+	for (PassId pass = 0; pass < state.passes.size(); pass++) {
+		const bool writesOutput = std::any_of(state.passes[pass].uses.begin(), state.passes[pass].uses.end(), [&] (const auto &use) {
+			return use.write && state.images[use.resource].output;
+		});
+
+		if (writesOutput) {
+			culled[pass] = false;
+			pending.push_back(pass);
+		}
+	}
+
+	while ( ! pending.empty()) {
+		const auto pass = pending.back();
+		pending.pop_back();
+
+		for (const auto dependency : dependencies[pass]) {
+			if (culled[dependency]) {
+				culled[dependency] = false;
+				pending.push_back(dependency);
+			}
+		}
+	}
+
+	return culled;
+}
+
+std::vector<PassId> orderPasses(const State &state, const std::vector<std::vector<PassId>> &dependencies, const std::vector<bool> &culled) {
+	std::vector<uint32_t> remaining = util::map(dependencies, [] (const auto &passDependencies) {
+		return static_cast<uint32_t>(passDependencies.size());
+	});
+	std::vector<std::vector<PassId>> dependents(state.passes.size());
+	for (PassId pass = 0; pass < state.passes.size(); pass++) {
+		for (const auto dependency : dependencies[pass]) {
+			dependents[dependency].push_back(pass);
+		}
+	}
+
+	// Kahn's algorithm, always taking the earliest declared ready pass keeps the order stable
+	std::vector<PassId> order{};
+	std::vector<bool> done(state.passes.size(), false);
+	while (order.size() < state.passes.size()) {
+		PassId pass = 0;
+		while (pass < state.passes.size() && (done[pass] || remaining[pass] > 0)) {
+			pass++;
+		}
+
+		if (pass == state.passes.size()) {
+			throw std::runtime_error{"Render graph has a dependency cycle"};
+		}
+
+		done[pass] = true;
+		order.push_back(pass);
+
+		for (const auto dependent : dependents[pass]) {
+			remaining[dependent]--;
+		}
+	}
+
+	std::erase_if(order, [&] (const auto pass) {
+		return culled[pass];
+	});
+
+	return order;
+}
+
+void compile(State &state) {
+	const auto dependencies = buildDependencies(state);
+
+	state.culled = cullPasses(state, dependencies);
+	state.order = orderPasses(state, dependencies, state.culled);
+
+	for (PassId pass = 0; pass < state.passes.size(); pass++) {
+		spdlog::debug("ware::rendererVK::graph::compile() => pass \"{}\" {}", state.passes[pass].name, state.culled[pass] ? "culled" : fmt::format("at position {}", std::distance(state.order.begin(), std::find(state.order.begin(), state.order.end(), pass))));
+	}
+}
+
+bool needsBarrier(const Tracking &tracking, const Access &access, bool write) {
+	if (tracking.layout != access.layout) {
+		return true;
+	}
+
+	// write after write or write after read
+	if (write) {
+		return tracking.writeStageMask != vk::PipelineStageFlags2{} || tracking.readStageMask != vk::PipelineStageFlags2{};
+	}
+
+	// read after write, unless an earlier barrier already made the write visible to this use
+	if (tracking.writeStageMask == vk::PipelineStageFlags2{}) {
+		return false;
+	}
+
+	return (access.stageMask & ~tracking.visibleStageMask) != vk::PipelineStageFlags2{} || (access.accessMask & ~tracking.visibleAccessMask) != vk::AccessFlags2{};
+}
+
+vk::ImageMemoryBarrier2 createBarrier(const Image &image, const Tracking &tracking, const Access &access) {
+	return vk::ImageMemoryBarrier2{
+		.srcStageMask = tracking.writeStageMask | tracking.readStageMask,
+		// reads need no availability, only the last write is made available
+		.srcAccessMask = tracking.writeAccessMask,
+		.dstStageMask = access.stageMask,
+		.dstAccessMask = access.accessMask,
+		.oldLayout = tracking.layout,
+		.newLayout = access.layout,
+		// images shared between queue families are created concurrent, no ownership transfers
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = image.image,
+		.subresourceRange = image.subresourceRange,
+	};
+}
+
+void track(Tracking &tracking, const Access &access, bool write, bool barrier) {
+	if (write) {
+		tracking.writeStageMask = access.stageMask;
+		tracking.writeAccessMask = access.accessMask & writeAccessMask;
+		tracking.readStageMask = vk::PipelineStageFlags2{};
+	} else if (barrier && tracking.layout != access.layout) {
+		// a layout transition acts as a write that is complete before the stages of this use
+		tracking.writeStageMask = access.stageMask;
+		tracking.writeAccessMask = vk::AccessFlags2{};
+		tracking.readStageMask = access.stageMask;
+	} else {
+		tracking.readStageMask |= access.stageMask;
+	}
+
+	if (write || barrier) {
+		tracking.visibleStageMask = access.stageMask;
+		tracking.visibleAccessMask = access.accessMask;
+	} else {
+		tracking.visibleStageMask |= access.stageMask;
+		tracking.visibleAccessMask |= access.accessMask;
+	}
+
+	tracking.layout = access.layout;
+	tracking.touched = true;
+}
+
+void build(State &state) {
+	ZoneScopedN("ware::rendererVK::graph::build()");
+
+	std::vector<Tracking> trackings = util::map(state.images, [] (const auto &image) {
+		return Tracking{
+			.layout = image.initialAccess.layout,
+			.writeStageMask = image.initialAccess.stageMask,
+			.writeAccessMask = image.initialAccess.accessMask & writeAccessMask,
+			.readStageMask = {},
+			.visibleStageMask = {},
+			.visibleAccessMask = {},
+			.touched = false,
+		};
+	});
+
+	state.steps.resize(state.order.size());
+	state.barrierCount = 0;
+
+	for (size_t i = 0; i < state.order.size(); i++) {
+		auto &step = state.steps[i];
+		step.pass = state.order[i];
+		step.imageMemoryBarriers.clear();
+
+		for (const auto &use : state.passes[step.pass].uses) {
+			auto &tracking = trackings[use.resource];
+			const auto &aliasedResource = state.images[use.resource].aliasedResource;
+
+			// the first use of an aliasing image waits for the uses of the image that had the memory before
+			if ( ! tracking.touched && aliasedResource) {
+				const auto &aliasedTracking = trackings[*aliasedResource];
+
+				tracking.writeStageMask = aliasedTracking.writeStageMask;
+				tracking.writeAccessMask = aliasedTracking.writeAccessMask;
+				tracking.readStageMask = aliasedTracking.readStageMask;
+			}
+
+			const bool barrier = needsBarrier(tracking, use.access, use.write);
+			if (barrier) {
+				step.imageMemoryBarriers.push_back(createBarrier(state.images[use.resource], tracking, use.access));
+			}
+
+			track(tracking, use.access, use.write, barrier);
+		}
+
+		state.barrierCount += static_cast<uint32_t>(step.imageMemoryBarriers.size());
+	}
+
+	state.finalImageMemoryBarriers.clear();
+	for (ResourceId resource = 0; resource < state.images.size(); resource++) {
+		const auto &image = state.images[resource];
+		const auto &tracking = trackings[resource];
+
+		// images no pass touched stay as they are, transient images are discarded
+		if (tracking.touched && ! image.transient && needsBarrier(tracking, image.finalAccess, false)) {
+			state.finalImageMemoryBarriers.push_back(createBarrier(image, tracking, image.finalAccess));
+		}
+	}
+
+	state.barrierCount += static_cast<uint32_t>(state.finalImageMemoryBarriers.size());
+}
+
+State setup() {
+	return State{
+		.images = {},
+		.passes = {},
+		.order = {},
+		.culled = {},
+		.steps = {},
+		.finalImageMemoryBarriers = {},
+		.barrierCount = 0,
+	};
+}
+
+} // ware::rendererVK::graph
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../contextVK/contextVK.hpp"
+
+namespace ware::rendererVK::graph {
+
+using ResourceId = uint32_t;
+using PassId = uint32_t;
+
+struct Access {
+	vk::PipelineStageFlags2 stageMask;
+	vk::AccessFlags2 accessMask;
+	vk::ImageLayout layout;
+};
+
+struct Image {
+	std::string name;
+	// bound per frame with bindImage(), e.g. the current swapchain image
+	vk::Image image;
+	vk::ImageSubresourceRange subresourceRange;
+	// state the image is in before the first pass, an undefined layout discards the contents
+	Access initialAccess;
+	// state the image is left in after the last pass
+	Access finalAccess;
+	// outputs keep the passes that write them alive, everything else is culled unless an output depends on it
+	bool output;
+	// contents are discarded after the last use, there is no final transition
+	bool transient;
+	// transient image whose memory this image reuses, its uses have to finish before the first use of this one
+	std::optional<ResourceId> aliasedResource;
+};
+
+struct Use {
+	ResourceId resource;
+	Access access;
+	bool write;
+};
+
+struct Pass {
+	std::string name;
+	// each resource at most once per pass, a read-modify-write is a single write use
+	std::vector<Use> uses;
+};
+
+// positions in State::order of the first and last pass using a resource
+struct Lifetime {
+	uint32_t first;
+	uint32_t last;
+};
+
+// barriers batched into a single vkCmdPipelineBarrier2 ahead of the pass
+struct Step {
+	PassId pass;
+	std::vector<vk::ImageMemoryBarrier2> imageMemoryBarriers;
+};
+
+struct State {
+	std::vector<Image> images;
+	std::vector<Pass> passes;
+	// derived by compile()
+	std::vector<PassId> order;
+	std::vector<bool> culled;
+	// derived by build() every frame
+	std::vector<Step> steps;
+	std::vector<vk::ImageMemoryBarrier2> finalImageMemoryBarriers;
+	uint32_t barrierCount;
+};
+
+ResourceId addImage(State &state, Image &&image);
+PassId addPass(State &state, Pass &&pass);
+
+void bindImage(State &state, ResourceId resource, vk::Image image);
+void aliasImage(State &state, ResourceId resource, std::optional<ResourceId> aliasedResource);
+
+bool isCulled(const State &state, PassId pass);
+
+// empty when no live pass uses the resource, valid after compile()
+std::optional<Lifetime> findLifetime(const State &state, ResourceId resource);
+
+// orders the passes by their dependencies, declaration order breaks ties, and culls the ones no output depends on
+void compile(State &state);
+
+// derives the barriers for the currently bound images
+void build(State &state);
+
+// records the barriers ahead of each step and calls recordPass for the pass itself, then the final transitions
+template<class F>
+void execute(State &state, vk::CommandBuffer cmd, F &&recordPass) {
+	const auto recordBarriers = [&] (const std::vector<vk::ImageMemoryBarrier2> &imageMemoryBarriers) {
+		if (imageMemoryBarriers.empty()) {
+			return;
+		}
+
+		cmd.pipelineBarrier2({
+			.imageMemoryBarrierCount = static_cast<uint32_t>(imageMemoryBarriers.size()),
+			.pImageMemoryBarriers = imageMemoryBarriers.data(),
+		});
+	};
+
+	for (const auto &step : state.steps) {
+		recordBarriers(step.imageMemoryBarriers);
+
+		recordPass(step.pass);
+	}
+
+	recordBarriers(state.finalImageMemoryBarriers);
+}
+
+State setup();
+
+} // ware::rendererVK::graph
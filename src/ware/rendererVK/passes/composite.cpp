@@ -0,0 +1,277 @@
+#include "composite.hpp"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <util/map.hpp>
+
+#include "../profiler.hpp"
+#include "../reflection.hpp"
+#include "../shaders.hpp"
+
+namespace ware::rendererVK::passes::composite {
+
+struct PushConstant {
+	uint32_t sceneColorIndex;
+	uint32_t uiLayerIndex;
+};
+
+[[nodiscard]] std::vector<ware::rendererVK::reflection::Module> reflectShaders(const std::vector<ware::rendererVK::shaders::Code> &shaderCodes) {
+	return util::map(shaderCodes, [] (const auto &shaderCode) {
+		return ware::rendererVK::reflection::reflect(shaderCode.words);
+	});
+}
+
+[[nodiscard]] vk::UniquePipeline createPipeline(ware::contextVK::State &context, vk::Format colorFormat, vk::PipelineLayout layout, const std::vector<ware::rendererVK::shaders::Code> &shaderCodes) {
+	auto vertexShaderModule = ware::rendererVK::shaders::createModule(context, shaderCodes[0]);
+	auto fragmentShaderModule = ware::rendererVK::shaders::createModule(context, shaderCodes[1]);
+
+	std::array stages{
+		vk::PipelineShaderStageCreateInfo{
+			.stage = vk::ShaderStageFlagBits::eVertex,
+			.module = vertexShaderModule.get(),
+			.pName = "main",
+		},
+		vk::PipelineShaderStageCreateInfo{
+			.stage = vk::ShaderStageFlagBits::eFragment,
+			.module = fragmentShaderModule.get(),
+			.pName = "main",
+		},
+	};
+
+	vk::PipelineVertexInputStateCreateInfo vertexInputState{};
+	vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState{
+		.topology = vk::PrimitiveTopology::eTriangleList,
+	};
+	vk::PipelineViewportStateCreateInfo viewportState{};
+	vk::PipelineRasterizationStateCreateInfo rasterizationState{
+		.depthClampEnable = false,
+		.rasterizerDiscardEnable = false,
+		.polygonMode = vk::PolygonMode::eFill,
+		.cullMode = vk::CullModeFlagBits::eNone,
+		.frontFace = vk::FrontFace::eCounterClockwise,
+		.depthBiasEnable = false,
+		.lineWidth = 1.0f,
+	};
+
+	std::array blendAttachmentState{
+		vk::PipelineColorBlendAttachmentState{
+			.blendEnable = false,
+			.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
+		},
+	};
+	vk::PipelineColorBlendStateCreateInfo colorBlendState{
+		.attachmentCount = static_cast<uint32_t>(blendAttachmentState.size()),
+		.pAttachments = blendAttachmentState.data(),
+	};
+
+	std::array dynamicStates{
+		vk::DynamicState::eScissorWithCount,
+		vk::DynamicState::eViewportWithCount,
+	};
+	vk::PipelineDynamicStateCreateInfo dynamicState{
+		.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size()),
+		.pDynamicStates = dynamicStates.data(),
+	};
+
+	std::array colorAttachmentFormats{
+		colorFormat,
+	};
+
+	vk::StructureChain craphicsPipelineCreateInfo{
+		vk::GraphicsPipelineCreateInfo{
+			.flags = ware::contextVK::descriptorHeapPipelineFlags(context),
+			.stageCount = static_cast<uint32_t>(stages.size()),
+			.pStages = stages.data(),
+			.pVertexInputState = &vertexInputState,
+			.pInputAssemblyState = &inputAssemblyState,
+			.pViewportState = &viewportState,
+			.pRasterizationState = &rasterizationState,
+			.pColorBlendState = &colorBlendState,
+			.pDynamicState = &dynamicState,
+			.layout = layout,
+		},
+		vk::PipelineRenderingCreateInfo{
+			.colorAttachmentCount = static_cast<uint32_t>(colorAttachmentFormats.size()),
+			.pColorAttachmentFormats = colorAttachmentFormats.data(),
+		},
+	};
+
+	auto resultValue = context.device->createGraphicsPipelineUnique(context.pipelineCache.get(), craphicsPipelineCreateInfo.get());
+
+	if (resultValue.result != vk::Result::eSuccess && resultValue.result != vk::Result::ePipelineCompileRequired) {
+		throw std::runtime_error{fmt::format("Unable to create pipeline (error: {})", vk::to_string(resultValue.result))};
+	}
+
+	return std::move(resultValue.value);
+}
+
+std::vector<FrameResources> createFrameResources(ware::contextVK::State &context, ware::swapchainVK::State &swapchain) {
+	return util::mapRange(swapchain.framesInFlight, [&] ([[maybe_unused]] const auto &index) {
+		auto renderingCommandPool = context.device->createCommandPoolUnique({
+			.flags = vk::CommandPoolCreateFlagBits::eTransient,
+			.queueFamilyIndex = context.graphicQueueFamily,
+		});
+
+		std::vector<vk::CommandBuffer> renderingCommandBuffers = context.device->allocateCommandBuffers({
+			.commandPool = renderingCommandPool.get(),
+			.level = vk::CommandBufferLevel::eSecondary,
+			.commandBufferCount = 1,
+		});
+
+		return FrameResources{
+			.renderingCommandPool = std::move(renderingCommandPool),
+			.renderingCommandBuffer = renderingCommandBuffers[0],
+			.sceneColorDescriptor = {},
+			.uiLayerDescriptor = {},
+		};
+	});
+}
+
+// the transient targets change with every resize, the previous frame of this slot has retired so its heap slots can be rewritten
+void writeDescriptor(ware::contextVK::State &context, ware::contextVK::UniqueDescriptor &descriptor, vk::ImageView imageView) {
+	if (descriptor) {
+		ware::contextVK::updateSampledImageDescriptor(context, descriptor, imageView, vk::ImageLayout::eShaderReadOnlyOptimal);
+	} else {
+		descriptor = ware::contextVK::createSampledImageDescriptor(context, imageView, vk::ImageLayout::eShaderReadOnlyOptimal);
+	}
+}
+
+vk::CommandBuffer render(State &state) {
+	const auto &context = state.context;
+	const auto &swapchain = state.swapchain;
+	const auto &swapchainImageResources = swapchain.imageResources[swapchain.imageIndex];
+	auto &frameResources = state.frameResources[swapchain.frameIndex];
+
+	const auto width = static_cast<uint32_t>(state.window.description->width);
+	const auto height = static_cast<uint32_t>(state.window.description->height);
+
+	context.device->resetCommandPool(frameResources.renderingCommandPool.get());
+
+	writeDescriptor(state.context, frameResources.sceneColorDescriptor, ware::rendererVK::transient::imageView(state.transient, state.sceneColorTarget));
+	writeDescriptor(state.context, frameResources.uiLayerDescriptor, ware::rendererVK::transient::imageView(state.transient, state.uiLayerTarget));
+
+	auto &cmd = frameResources.renderingCommandBuffer;
+
+	vk::CommandBufferInheritanceInfo inheritanceInfo{
+		.pipelineStatistics = ware::rendererVK::profiler::inheritedPipelineStatistics(context),
+	};
+	cmd.begin({
+		.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+		.pInheritanceInfo = &inheritanceInfo,
+	});
+
+	// the render graph transitions the swapchain image and both layers ahead of this pass
+	{
+		std::array colorAttachments{
+			vk::RenderingAttachmentInfo{
+				.imageView = swapchainImageResources.imageView.get(),
+				.imageLayout = vk::ImageLayout::eAttachmentOptimal,
+				.loadOp = vk::AttachmentLoadOp::eDontCare,
+				.storeOp = vk::AttachmentStoreOp::eStore,
+			},
+		};
+
+		cmd.beginRendering(vk::RenderingInfo{
+			.renderArea = vk::Rect2D{ 0, 0, width, height },
+			.layerCount = 1,
+			.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size()),
+			.pColorAttachments = colorAttachments.data(),
+		});
+
+		ware::contextVK::bindDescriptorHeap(context, cmd, vk::PipelineBindPoint::eGraphics, state.pipelineLayout.layout, ware::rendererVK::reflection::heapSet);
+
+		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, state.pipeline.get());
+
+		PushConstant pushConstant{
+			.sceneColorIndex = frameResources.sceneColorDescriptor->index,
+			.uiLayerIndex = frameResources.uiLayerDescriptor->index,
+		};
+		cmd.pushConstants(state.pipelineLayout.layout, state.pipelineLayout.pushConstantStages, 0, sizeof(PushConstant), &pushConstant);
+
+		cmd.setScissorWithCount({
+			vk::Rect2D{ 0, 0, width, height },
+		});
+		cmd.setViewportWithCount({
+			vk::Viewport{
+				.x = 0.0f,
+				.y = 0.0f,
+				.width = static_cast<float>(width),
+				.height = static_cast<float>(height),
+				.minDepth = 0.0f,
+				.maxDepth = 1.0f,
+			},
+		});
+
+		cmd.draw(3, 1, 0, 0);
+
+		cmd.endRendering();
+	}
+
+	cmd.end();
+
+	return cmd;
+}
+
+std::move_only_function<vk::UniquePipeline()> rebuildPipeline(const State &state) {
+	// the surface format is read here on the main thread, the swapchain may be recreated while the worker compiles
+	return [&context = state.context, &pipelineLayout = state.pipelineLayout, colorFormat = state.swapchain.surfaceFormat.format] {
+		auto shaderCodes = ware::rendererVK::shaders::load(shaderFiles, ware::rendererVK::shaders::Source::eOverride);
+
+		ware::rendererVK::reflection::checkLayoutUnchanged(reflectShaders(shaderCodes), pipelineLayout);
+
+		return createPipeline(context, colorFormat, pipelineLayout.layout, shaderCodes);
+	};
+}
+
+void replacePipeline(State &state, vk::UniquePipeline &&pipeline) {
+	auto &context = state.context;
+
+	ware::contextVK::deferDestroy(context, context.frameValue, std::exchange(state.pipeline, std::move(pipeline)));
+}
+
+State::~State() {
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(frameResources), std::move(pipeline));
+}
+
+State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::swapchainVK::State &swapchain, const ware::rendererVK::transient::State &transient, graph::ResourceId sceneColorTarget, graph::ResourceId uiLayerTarget) {
+	auto shaderCodes = ware::rendererVK::shaders::load(shaderFiles, ware::rendererVK::shaders::Source::eEmbedded);
+
+	auto pipelineLayout = ware::rendererVK::reflection::createPipelineLayout(context, reflectShaders(shaderCodes));
+
+	auto pipeline = createPipeline(context, swapchain.surfaceFormat.format, pipelineLayout.layout, shaderCodes);
+
+	ware::rendererVK::reflection::checkPushConstantSize(pipelineLayout, sizeof(PushConstant));
+
+	// the heap slots are written by the first frame of each slot, the targets are not bound before
+	auto frameResources = createFrameResources(context, swapchain);
+
+	return State{
+		.window = window,
+		.context = context,
+		.swapchain = swapchain,
+		.transient = transient,
+		.sceneColorTarget = sceneColorTarget,
+		.uiLayerTarget = uiLayerTarget,
+		.pipelineLayout = std::move(pipelineLayout),
+		.pipeline = std::move(pipeline),
+		.frameResources = std::move(frameResources),
+	};
+}
+
+void refresh([[maybe_unused]] State &state) {
+	ZoneScopedN("ware::rendererVK::passes::composite::refresh()");
+}
+
+vk::CommandBuffer process(State &state) {
+	ZoneScopedN("ware::rendererVK::passes::composite::process()");
+
+	return render(state);
+}
+
+} // ware::rendererVK::passes::composite
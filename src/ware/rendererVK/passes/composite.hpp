@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "../../contextVK/contextVK.hpp"
+#include "../../swapchainVK/swapchainVK.hpp"
+#include "../reflection.hpp"
+#include "../transient.hpp"
+
+namespace ware::rendererVK::passes::composite {
+
+const std::array<std::string_view, 2> shaderFiles{ "composite.vert.spv", "composite.frag.spv" };
+
+struct FrameResources {
+	vk::UniqueCommandPool renderingCommandPool;
+	vk::CommandBuffer renderingCommandBuffer;
+	// rewritten each frame, empty until the first frame of the slot
+	ware::contextVK::UniqueDescriptor sceneColorDescriptor;
+	ware::contextVK::UniqueDescriptor uiLayerDescriptor;
+};
+
+struct State {
+	ware::windowGLFW::State &window;
+	ware::contextVK::State &context;
+	ware::swapchainVK::State &swapchain;
+	const ware::rendererVK::transient::State &transient;
+	graph::ResourceId sceneColorTarget;
+	graph::ResourceId uiLayerTarget;
+
+	ware::rendererVK::reflection::PipelineLayout pipelineLayout;
+	vk::UniquePipeline pipeline;
+	std::vector<FrameResources> frameResources;
+
+	~State();
+};
+
+State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::swapchainVK::State &swapchain, const ware::rendererVK::transient::State &transient, graph::ResourceId sceneColorTarget, graph::ResourceId uiLayerTarget);
+
+void refresh(State &state);
+
+vk::CommandBuffer process(State &state);
+
+[[nodiscard]] std::move_only_function<vk::UniquePipeline()> rebuildPipeline(const State &state);
+
+void replacePipeline(State &state, vk::UniquePipeline &&pipeline);
+
+} // ware::rendererVK::passes::composite
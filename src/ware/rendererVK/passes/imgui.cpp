@@ -2,158 +2,52 @@
 
 #include <algorithm>
 #include <array>
-#include <filesystem>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include <fmt/format.h>
 #include <spdlog/spdlog.h>
 #include <tracy/Tracy.hpp>
 
-#include <util/fs.hpp>
+#include <util/hash.hpp>
 #include <util/map.hpp>
+#include <util/streamCopy.hpp>
+
+#include "../reflection.hpp"
+#include "../shaders.hpp"
 
 namespace ware::rendererVK::passes::imgui {
 
+// the texture ids of imgui are descriptor heap indices, only the image index changes between draws
 struct PushConstant {
 	float scale[2];
 	float translate[2];
+	uint32_t imageIndex;
+	uint32_t samplerIndex;
 };
 
-const uint32_t sampledImageMaxCount = 1;
-const uint32_t samplerMaxCount = 1;
-
-enum DescriptorIndex : uint32_t {
-	Images = 0,
-	Samplers = 1,
-};
-
-[[nodiscard]] vk::UniqueDescriptorPool createDescriptorPool(ware::contextVK::State &context) {
-	std::array poolSizes{
-		 vk::DescriptorPoolSize{
-			.type = vk::DescriptorType::eSampledImage,
-			.descriptorCount = sampledImageMaxCount,
-		},
-		 vk::DescriptorPoolSize{
-			.type = vk::DescriptorType::eSampler,
-			.descriptorCount = samplerMaxCount,
-		},
-	};
-
-	return context.device->createDescriptorPoolUnique({
-		.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
-		.maxSets = sampledImageMaxCount + samplerMaxCount,
-		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
-		.pPoolSizes = poolSizes.data(),
-	});
-}
-
-[[nodiscard]] std::vector<vk::UniqueDescriptorSetLayout> createDescriptorSetLayouts(ware::contextVK::State &context) {
-	std::array sampledImagesSetLayoutBindings{
-		vk::DescriptorSetLayoutBinding{
-			.binding = 0,
-			.descriptorType = vk::DescriptorType::eSampledImage,
-			.descriptorCount = sampledImageMaxCount,
-			.stageFlags = vk::ShaderStageFlagBits::eAll,
-			.pImmutableSamplers = nullptr,
-		},
-	};
-
-	std::array samplersSetLayoutBindings{
-		vk::DescriptorSetLayoutBinding{
-			.binding = 0,
-			.descriptorType = vk::DescriptorType::eSampler,
-			.descriptorCount = samplerMaxCount,
-			.stageFlags = vk::ShaderStageFlagBits::eAll,
-			.pImmutableSamplers = nullptr,
-		},
-	};
-
-	std::array<vk::DescriptorBindingFlags, sampledImagesSetLayoutBindings.size()> sampledImagesSetLayoutBindingFlags{};
-	std::array<vk::DescriptorBindingFlags, samplersSetLayoutBindings.size()> samplersSetLayoutBindingFlags{};
-
-	auto bindlessBindingFlags = vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eVariableDescriptorCount | vk::DescriptorBindingFlagBits::eUpdateAfterBind;
-	sampledImagesSetLayoutBindingFlags.fill(bindlessBindingFlags);
-	samplersSetLayoutBindingFlags.fill(bindlessBindingFlags);
-
-	vk::StructureChain sampledImagesSetLayoutCreateInfo{
-		vk::DescriptorSetLayoutCreateInfo{
-			.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
-			.bindingCount = static_cast<uint32_t>(sampledImagesSetLayoutBindings.size()),
-			.pBindings = sampledImagesSetLayoutBindings.data(),
-		},
-		vk::DescriptorSetLayoutBindingFlagsCreateInfo{
-			.bindingCount = static_cast<uint32_t>(sampledImagesSetLayoutBindingFlags.size()),
-			.pBindingFlags = sampledImagesSetLayoutBindingFlags.data(),
-		},
-	};
-	vk::StructureChain samplersSetLayoutCreateInfo{
-		vk::DescriptorSetLayoutCreateInfo{
-			.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
-			.bindingCount = static_cast<uint32_t>(samplersSetLayoutBindings.size()),
-			.pBindings = samplersSetLayoutBindings.data(),
-		},
-		vk::DescriptorSetLayoutBindingFlagsCreateInfo{
-			.bindingCount = static_cast<uint32_t>(samplersSetLayoutBindingFlags.size()),
-			.pBindingFlags = samplersSetLayoutBindingFlags.data(),
-		},
-	};
-
-	auto sampledImagesSetLayout = context.device->createDescriptorSetLayoutUnique(sampledImagesSetLayoutCreateInfo.get());
-	auto samplersSetLayout = context.device->createDescriptorSetLayoutUnique(samplersSetLayoutCreateInfo.get());
-
-	std::vector<vk::UniqueDescriptorSetLayout> setLayouts{};
-	setLayouts.reserve(2);
-	setLayouts.push_back(std::move(sampledImagesSetLayout));
-	setLayouts.push_back(std::move(samplersSetLayout));
+// index data has to start at a multiple of the index size, 16 bytes suit every vertex and index type
+const vk::DeviceSize geometryAlignment = 16;
+const vk::DeviceSize initialGeometryRingSize = 1024 * 1024;
+// below that per worker the copy is not worth handing out
+const size_t minCopyJobSize = 64 * 1024;
 
-	return setLayouts;
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+	return (value + alignment - 1) / alignment * alignment;
 }
 
-[[nodiscard]] vk::UniquePipelineLayout createPipelineLayout(ware::contextVK::State &context, const std::vector<vk::UniqueDescriptorSetLayout> &descriptorSetLayouts) {
-	std::vector setLayouts = util::map(descriptorSetLayouts, [] (const auto &setLayout) { return setLayout.get(); });
-
-	std::array pushConstantRanges{
-		vk::PushConstantRange{
-			.stageFlags = vk::ShaderStageFlagBits::eAll,
-			.offset = 0,
-			.size = sizeof(PushConstant),
-		},
-	};
-
-	return context.device->createPipelineLayoutUnique({
-		.setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
-		.pSetLayouts = setLayouts.data(),
-		.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size()),
-		.pPushConstantRanges = pushConstantRanges.data(),
-	});
-}
-
-[[nodiscard]] vk::UniqueShaderModule createShaderModule(ware::contextVK::State &context, const std::filesystem::path &filePath) {
-	auto contentsO = util::fsReadBytes(filePath);
-
-	if ( ! contentsO) {
-		throw std::runtime_error{fmt::format("Unable to read shader file \"{}\"", filePath.string())};
-	}
-
-	if (contentsO->size() == 0) {
-		throw std::runtime_error{fmt::format("Shader file \"{}\" is empty", filePath.string())};
-	}
-
-	if (contentsO->size() % sizeof(uint32_t) != 0) {
-		throw std::runtime_error{fmt::format("Shader file \"{}\" is corrupted (size: {})", filePath.string(), contentsO->size())};
-	}
-
-	vk::ShaderModuleCreateInfo PFN_vkGetShaderModuleCreateInfoIdentifierEXT;
-
-	return context.device->createShaderModuleUnique({
-		.codeSize = static_cast<uint32_t>(contentsO->size()),
-		.pCode = reinterpret_cast<uint32_t *>(contentsO->data()),
+[[nodiscard]] std::vector<ware::rendererVK::reflection::Module> reflectShaders(const std::vector<ware::rendererVK::shaders::Code> &shaderCodes) {
+	return util::map(shaderCodes, [] (const auto &shaderCode) {
+		return ware::rendererVK::reflection::reflect(shaderCode.words);
 	});
 }
 
-[[nodiscard]] vk::UniquePipeline createPipeline([[maybe_unused]] ware::windowGLFW::State &window, ware::contextVK::State &context, ware::swapchainVK::State &swapchain, vk::PipelineLayout layout) {
-	auto vertexShaderModule = createShaderModule(context, "shaders/imgui.vert.spv");
-	auto fragmentShaderModule = createShaderModule(context, "shaders/imgui.frag.spv");
+[[nodiscard]] vk::UniquePipeline createPipeline([[maybe_unused]] ware::windowGLFW::State &window, ware::contextVK::State &context, vk::Format colorFormat, vk::PipelineLayout layout, const std::vector<ware::rendererVK::shaders::Code> &shaderCodes, const std::vector<ware::rendererVK::reflection::Module> &modules) {
+	auto vertexShaderModule = ware::rendererVK::shaders::createModule(context, shaderCodes[0]);
+	auto fragmentShaderModule = ware::rendererVK::shaders::createModule(context, shaderCodes[1]);
 
 	std::array stages{
 		vk::PipelineShaderStageCreateInfo{
@@ -196,6 +90,9 @@ enum DescriptorIndex : uint32_t {
 		},
 	};
 
+	// the layout of ImDrawVert is not in the shader, only which locations it reads
+	ware::rendererVK::reflection::checkVertexInputs(modules[0], vertexInputAttributeDescriptions);
+
 	vk::PipelineVertexInputStateCreateInfo vertexInputState{
 		.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexInputBindingDescriptions.size()),
 		.pVertexBindingDescriptions = vertexInputBindingDescriptions.data(),
@@ -219,14 +116,15 @@ enum DescriptorIndex : uint32_t {
 		.lineWidth = 1.0f,
 	};
 
+	// the layer starts out transparent, accumulating coverage in alpha leaves it premultiplied for the composite pass
 	std::array blendAttachmentState{
 		vk::PipelineColorBlendAttachmentState{
 			.blendEnable = true,
 			.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha,
 			.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
 			.colorBlendOp = vk::BlendOp::eAdd,
-			.srcAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
-			.dstAlphaBlendFactor = vk::BlendFactor::eZero,
+			.srcAlphaBlendFactor = vk::BlendFactor::eOne,
+			.dstAlphaBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha,
 			.alphaBlendOp = vk::BlendOp::eAdd,
 			.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA,
 		},
@@ -252,11 +150,12 @@ enum DescriptorIndex : uint32_t {
 	};
 
 	std::array colorAttachmentFormats{
-		swapchain.surfaceFormat.format,
+		colorFormat,
 	};
 
 	vk::StructureChain craphicsPipelineCreateInfo{
 		vk::GraphicsPipelineCreateInfo{
+			.flags = ware::contextVK::descriptorHeapPipelineFlags(context),
 			.stageCount = static_cast<uint32_t>(stages.size()),
 			.pStages = stages.data(),
 			.pVertexInputState = &vertexInputState,
@@ -283,36 +182,13 @@ enum DescriptorIndex : uint32_t {
 	return std::move(resultValue.value);
 }
 
-[[nodiscard]] std::vector<vk::DescriptorSet> allocateDescriptorSets(ware::contextVK::State &context, vk::DescriptorPool descriptorPool, const std::vector<vk::UniqueDescriptorSetLayout> &descriptorSetLayouts) {
-	std::vector setLayouts = util::map(descriptorSetLayouts, [] (const auto &setLayout) { return setLayout.get(); });
-
-	std::array descriptorCounts{
-		sampledImageMaxCount,
-		samplerMaxCount,
-	};
-
-	vk::StructureChain descriptorSetsAllocateInfo{
-		vk::DescriptorSetAllocateInfo{
-			.descriptorPool = descriptorPool,
-			.descriptorSetCount = static_cast<uint32_t>(setLayouts.size()),
-			.pSetLayouts = setLayouts.data(),
-		},
-		vk::DescriptorSetVariableDescriptorCountAllocateInfo{
-			.descriptorSetCount = static_cast<uint32_t>(descriptorCounts.size()),
-			.pDescriptorCounts = descriptorCounts.data(),
-		},
-	};
-
-	return context.device->allocateDescriptorSets(descriptorSetsAllocateInfo.get());
-}
-
-std::tuple<ware::contextVK::UniqueImage, vk::UniqueImageView, ware::contextVK::UniqueBuffer, vk::UniqueSampler> createFontResources(ware::contextVK::State &context) {
+std::tuple<ware::contextVK::UniqueImage, vk::UniqueImageView, vk::Sampler> createFontResources(ware::contextVK::State &context, ware::uploadVK::State &upload) {
 	auto &io = ImGui::GetIO();
 
 	unsigned char* texData;
 	int texWidth, texHeight, bytesPerPixel;
 	io.Fonts->GetTexDataAsRGBA32(&texData, &texWidth, &texHeight, &bytesPerPixel);
-	vk::DeviceSize uploadSize = texWidth * texHeight * bytesPerPixel;
+	const size_t uploadSize = static_cast<size_t>(texWidth * texHeight * bytesPerPixel);
 
 	vk::ImageCreateInfo imageCreateInfo{
 		.imageType = vk::ImageType::e2D,
@@ -341,23 +217,16 @@ std::tuple<ware::contextVK::UniqueImage, vk::UniqueImageView, ware::contextVK::U
 		},
 	});
 
-	vk::BufferCreateInfo stagingBufferCreateInfo{
-		.size = uploadSize,
-		.usage = vk::BufferUsageFlagBits::eTransferSrc,
-	};
-	vma::AllocationCreateInfo stagingAllocationCreateInfo{
-		.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
-		.usage = vma::MemoryUsage::eAutoPreferHost,
-		.requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible,
-	};
-
-	auto stagingBuffer = ware::contextVK::createBuffer(context, stagingBufferCreateInfo, stagingAllocationCreateInfo);
-
-	std::copy_n(texData, uploadSize, reinterpret_cast<unsigned char *>(stagingBuffer->mappedData));
-
-	ware::contextVK::flushMappedData(stagingBuffer);
+	ware::uploadVK::uploadImage(upload, std::as_bytes(std::span{texData, uploadSize}), {
+		.image = image->image,
+		.extent = image->extent,
+		.aspectMask = vk::ImageAspectFlagBits::eColor,
+		.finalLayout = vk::ImageLayout::eReadOnlyOptimal,
+		.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+		.dstAccessMask = vk::AccessFlagBits2::eShaderSampledRead,
+	});
 
-	auto sampler = context.device->createSamplerUnique({
+	auto sampler = ware::contextVK::getSampler(context, {
 		.magFilter = vk::Filter::eLinear,
 		.minFilter = vk::Filter::eLinear,
 		.mipmapMode = vk::SamplerMipmapMode::eLinear,
@@ -367,11 +236,11 @@ std::tuple<ware::contextVK::UniqueImage, vk::UniqueImageView, ware::contextVK::U
 		.borderColor = vk::BorderColor::eFloatOpaqueWhite,
 	});
 
-	return { std::move(image), std::move(imageView), std::move(stagingBuffer), std::move(sampler) };
+	return { std::move(image), std::move(imageView), sampler };
 }
 
 std::vector<FrameResources> createFrameResources(ware::contextVK::State &context, ware::swapchainVK::State &swapchain) {
-	return util::mapRange(swapchain.frameResources.size(), [&] ([[maybe_unused]] const auto &index) {
+	return util::mapRange(swapchain.framesInFlight, [&] ([[maybe_unused]] const auto &index) {
 		auto renderingCommandPool = context.device->createCommandPoolUnique({
 			.flags = vk::CommandPoolCreateFlagBits::eTransient,
 			.queueFamilyIndex = context.graphicQueueFamily,
@@ -386,27 +255,143 @@ std::vector<FrameResources> createFrameResources(ware::contextVK::State &context
 		return FrameResources{
 			.renderingCommandPool = std::move(renderingCommandPool),
 			.renderingCommandBuffer = renderingCommandBuffers[0],
-			.vertexBuffer = {},
-			.indexBuffer = {},
-			.vertexCount = 0,
-			.indexCount = 0,
+			.geometry = {},
+			.recording = std::nullopt,
 		};
 	});
 }
 
+// the recorded command buffers reference the pipeline, the geometry ring and the layer, replacing any of them invalidates them
+void invalidateRecordings(State &state) {
+	for (auto &frameResources : state.frameResources) {
+		frameResources.recording = std::nullopt;
+	}
+}
+
 void recreateFrameResources(State &state) {
 	auto &context = state.context;
 	auto &swapchain = state.swapchain;
 
-	if (swapchain.description.swapchainResized && state.frameResources.size() != swapchain.frameResources.size()) {
-		ware::contextVK::requestWaitIdle(context);
-
-		state.frameResources.clear();
+	if (swapchain.description.swapchainResized && state.frameResources.size() != swapchain.framesInFlight) {
+		ware::contextVK::deferDestroy(context, context.frameValue, std::move(state.frameResources));
 
 		state.frameResources = createFrameResources(context, swapchain);
 	}
 }
 
+[[nodiscard]] double skipRate(uint64_t skippedCount, uint64_t frameCount) {
+	return frameCount > 0 ? 100.0 * static_cast<double>(skippedCount) / static_cast<double>(frameCount) : 0.0;
+}
+
+void recordStatistics(State &state) {
+	const auto &swapchain = state.swapchain;
+	const auto &transientStatistics = ware::rendererVK::transient::queryStatistics(state.transient);
+
+	ImGui::SetNextWindowPos(ImVec2{10.0f, 10.0f}, ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowBgAlpha(0.75f);
+
+	if (ImGui::Begin("Statistics", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing)) {
+		ImGui::Text("present mode: %s", swapchain.headless ? "headless" : vk::to_string(swapchain.presentMode).data());
+		ImGui::Text("swapchain images: %u", static_cast<uint32_t>(swapchain.imageResources.size()));
+		ImGui::Text("frames in flight: %u", swapchain.framesInFlight);
+		ImGui::Text("CPU to GPU completion latency: %.3fms", swapchain.latency.count());
+		ImGui::Text("swapchain recreates: %u (last stall: %.3fms, max: %.3fms)", swapchain.recreateStatistics.count, swapchain.recreateStatistics.last.count(), swapchain.recreateStatistics.max.count());
+		ImGui::Text("transient targets: %llu KiB allocated, %llu KiB saved per frame", static_cast<unsigned long long>(transientStatistics.allocatedSize / 1024), static_cast<unsigned long long>(transientStatistics.savedSize / 1024));
+		ImGui::Text("imgui geometry ring: %llu KiB (grown: %u)", static_cast<unsigned long long>(state.geometryRing.size / 1024), state.geometryRing.growCount);
+		ImGui::Text("imgui frames skipped: %.1f%% uploads, %.1f%% recordings", skipRate(state.skipStatistics.skippedUploadCount, state.skipStatistics.frameCount), skipRate(state.skipStatistics.skippedRecordCount, state.skipStatistics.frameCount));
+	}
+	ImGui::End();
+}
+
+void recordProfiler(State &state) {
+	const auto &profiler = state.profiler;
+
+	ImGui::SetNextWindowPos(ImVec2{10.0f, 140.0f}, ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowBgAlpha(0.75f);
+
+	if (ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing)) {
+		if ( ! profiler.supported) {
+			ImGui::TextUnformatted("GPU timestamps are not supported");
+		}
+
+		if (ImGui::BeginTable("passes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+			ImGui::TableSetupColumn("pass");
+			ImGui::TableSetupColumn("CPU record [ms]");
+			ImGui::TableSetupColumn("GPU avg [ms]");
+			ImGui::TableSetupColumn("GPU min [ms]");
+			ImGui::TableSetupColumn("GPU max [ms]");
+			ImGui::TableHeadersRow();
+
+			for (const auto &statistics : profiler.statistics) {
+				const auto summary = ware::rendererVK::profiler::summarize(statistics);
+
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(statistics.name.data());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", statistics.cpuLast.count());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", summary.average.count());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", summary.min.count());
+				ImGui::TableNextColumn();
+				ImGui::Text("%.3f", summary.max.count());
+			}
+
+			ImGui::EndTable();
+		}
+	}
+	ImGui::End();
+}
+
+void recordPipelineStatistics(State &state) {
+	const auto &profiler = state.profiler;
+
+	ImGui::SetNextWindowPos(ImVec2{10.0f, 280.0f}, ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowBgAlpha(0.75f);
+
+	if (ImGui::Begin("Pipeline statistics", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing)) {
+		if ( ! profiler.pipelineStatisticsSupported) {
+			ImGui::TextUnformatted("pipeline statistics queries are not supported");
+		}
+
+		if (ImGui::BeginTable("passes", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit)) {
+			ImGui::TableSetupColumn("pass");
+			ImGui::TableSetupColumn("vertex invocations");
+			ImGui::TableSetupColumn("clipping invocations");
+			ImGui::TableSetupColumn("clipping primitives");
+			ImGui::TableSetupColumn("fragment invocations");
+			ImGui::TableSetupColumn("fragments per pixel");
+			ImGui::TableHeadersRow();
+
+			for (const auto &statistics : profiler.statistics) {
+				if ( ! statistics.hasPipelineStatistics) {
+					continue;
+				}
+
+				const auto &pipelineStatistics = statistics.pipelineStatisticsLast;
+
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn();
+				ImGui::TextUnformatted(statistics.name.data());
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", static_cast<unsigned long long>(pipelineStatistics.vertexShaderInvocations));
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", static_cast<unsigned long long>(pipelineStatistics.clippingInvocations));
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", static_cast<unsigned long long>(pipelineStatistics.clippingPrimitives));
+				ImGui::TableNextColumn();
+				ImGui::Text("%llu", static_cast<unsigned long long>(pipelineStatistics.fragmentShaderInvocations));
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f", pipelineStatistics.fragmentsPerPixel);
+			}
+
+			ImGui::EndTable();
+		}
+	}
+	ImGui::End();
+}
+
 void recordNewFrame([[maybe_unused]] State &state) {
 	ZoneScopedN("ware::rendererVK::passes::imgui::refresh()#record new frame");
 
@@ -414,49 +399,174 @@ void recordNewFrame([[maybe_unused]] State &state) {
 
 	ImGui::ShowDemoWindow();
 
+	recordStatistics(state);
+
+	recordProfiler(state);
+
+	recordPipelineStatistics(state);
+
 	ImGui::EndFrame();
 
 	ImGui::Render();
 }
 
-void resizeBuffers(State &state) {
-	ZoneScopedN("ware::rendererVK::passes::imgui::refresh()#resize buffers");
+[[nodiscard]] GeometryRing createGeometryRing(ware::contextVK::State &context, vk::DeviceSize size, uint32_t growCount) {
+	vk::BufferCreateInfo bufferCreateInfo{
+		.size = size,
+		.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer,
+	};
+	vma::AllocationCreateInfo allocationCreateInfo{
+		.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
+		.usage = vma::MemoryUsage::eAutoPreferHost,
+		.requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible,
+	};
+
+	return GeometryRing{
+		.buffer = ware::contextVK::createBuffer(context, bufferCreateInfo, allocationCreateInfo),
+		.size = size,
+		.head = 0,
+		.tail = 0,
+		.ranges = {},
+		.growCount = growCount,
+	};
+}
+
+void reclaimGeometry(State &state) {
+	auto &ring = state.geometryRing;
+
+	while ( ! ring.ranges.empty() && ware::contextVK::isFrameRetired(state.context, ring.ranges.front().frameValue)) {
+		ring.tail = ring.ranges.front().end;
+		ring.ranges.pop_front();
+	}
+}
+
+// a range that does not wrap around the end of the ring, none while the frames in flight still hold too much of it
+[[nodiscard]] std::optional<vk::DeviceSize> placeGeometry(GeometryRing &ring, vk::DeviceSize size) {
+	if (ring.ranges.empty()) {
+		// nothing in flight, restart at the beginning of the ring
+		ring.head = ring.tail = alignUp(ring.head, ring.size);
+	}
+
+	auto offset = alignUp(ring.head, geometryAlignment);
+	if (offset % ring.size + size > ring.size) {
+		offset = alignUp(offset, ring.size);
+	}
+
+	if (offset + size - ring.tail > ring.size) {
+		return std::nullopt;
+	}
+
+	return offset;
+}
 
+// instead of waiting for the frames in flight, they keep reading the previous buffer until it is destroyed along with them
+void growGeometryRing(State &state, vk::DeviceSize size) {
 	auto &context = state.context;
+	auto &ring = state.geometryRing;
+
+	// room for a frame of that size in every slot and the one being built
+	auto ringSize = ring.size * 2;
+	while (ringSize < size * (state.swapchain.framesInFlight + 1)) {
+		ringSize *= 2;
+	}
+
+	spdlog::debug("ware::rendererVK::passes::imgui::growGeometryRing() => {} -> {} byte(s) for a frame of {} byte(s)", ring.size, ringSize, size);
+
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(ring.buffer));
+
+	ring = createGeometryRing(context, ringSize, ring.growCount + 1);
+
+	invalidateRecordings(state);
+}
+
+// everything the draws depend on, vertices and indices are the bulk of it
+[[nodiscard]] uint64_t hashDrawData(const ImDrawData *drawData) {
+	ZoneScopedN("ware::rendererVK::passes::imgui::refresh()#hash draw data");
+
+	if ( ! drawData) {
+		return util::hashSeed;
+	}
+
+	auto hash = util::hashValue(drawData->DisplayPos);
+	hash = util::hashValue(drawData->DisplaySize, hash);
+	hash = util::hashValue(drawData->CmdListsCount, hash);
+
+	for (const auto &cmdList : std::span{drawData->CmdLists, static_cast<uint32_t>(drawData->CmdListsCount)}) {
+		hash = util::hashBytesWide(std::as_bytes(std::span{cmdList->VtxBuffer.Data, static_cast<size_t>(cmdList->VtxBuffer.Size)}), hash);
+		hash = util::hashBytesWide(std::as_bytes(std::span{cmdList->IdxBuffer.Data, static_cast<size_t>(cmdList->IdxBuffer.Size)}), hash);
+
+		for (const auto &drawCmd : std::span{cmdList->CmdBuffer.Data, static_cast<size_t>(cmdList->CmdBuffer.Size)}) {
+			hash = util::hashValue(drawCmd.ClipRect, hash);
+			hash = util::hashValue(drawCmd.GetTexID(), hash);
+			hash = util::hashValue(drawCmd.ElemCount, hash);
+		}
+	}
+
+	return hash;
+}
+
+// the previous frame wrote the same data, its range is kept alive for this frame instead of filling a new one
+void reuseGeometry(State &state, const Geometry &geometry) {
+	const auto &context = state.context;
+	auto &ring = state.geometryRing;
+
+	reclaimGeometry(state);
+
+	if (ring.ranges.empty()) {
+		// the previous frame retired already, nothing has been placed after its range since
+		ring.tail = geometry.start;
+		ring.ranges.push_back(GeometryRange{
+			.frameValue = context.frameValue,
+			.end = ring.head,
+		});
+	} else {
+		// the newest range is the one of the previous frame, frames retire in order so it now lives as long as this one
+		ring.ranges.back().frameValue = context.frameValue;
+	}
+
+	state.frameResources[state.swapchain.frameIndex].geometry = geometry;
+}
+
+void allocateGeometry(State &state, uint64_t hash) {
+	ZoneScopedN("ware::rendererVK::passes::imgui::refresh()#allocate geometry");
+
+	const auto &context = state.context;
 	const auto &swapchain = state.swapchain;
+	auto &ring = state.geometryRing;
 	auto &frameResources = state.frameResources[swapchain.frameIndex];
 
 	ImDrawData *drawData = ImGui::GetDrawData();
-	const vk::DeviceSize vertexBufferSize = std::max(drawData ? drawData->TotalVtxCount : 0, 1024) * sizeof(ImDrawVert);
-	const vk::DeviceSize indexBufferSize = std::max(drawData ? drawData->TotalIdxCount : 0, 1024) * sizeof(ImDrawIdx);
+	const vk::DeviceSize vertexSize = static_cast<vk::DeviceSize>(drawData ? drawData->TotalVtxCount : 0) * sizeof(ImDrawVert);
+	const vk::DeviceSize indexSize = static_cast<vk::DeviceSize>(drawData ? drawData->TotalIdxCount : 0) * sizeof(ImDrawIdx);
 
-	if ( ! frameResources.vertexBuffer || frameResources.vertexBuffer->size < vertexBufferSize) {
-		vk::BufferCreateInfo vertexBufferCreateInfo{
-			.size = vertexBufferSize * 2,
-			.usage = vk::BufferUsageFlagBits::eVertexBuffer,
-		};
-		vma::AllocationCreateInfo vertexAllocationCreateInfo{
-			.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
-			.usage = vma::MemoryUsage::eAutoPreferHost,
-			.requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible,
-		};
+	// vertices first, indices right after them in the same range
+	const auto indexStart = alignUp(vertexSize, geometryAlignment);
+	const auto size = std::max(indexStart + indexSize, geometryAlignment);
+
+	reclaimGeometry(state);
 
-		frameResources.vertexBuffer = ware::contextVK::createBuffer(context, vertexBufferCreateInfo, vertexAllocationCreateInfo);
+	auto offset = placeGeometry(ring, size);
+	if ( ! offset) {
+		growGeometryRing(state, size);
+		offset = placeGeometry(ring, size);
 	}
 
-	if ( ! frameResources.indexBuffer || frameResources.indexBuffer->size < indexBufferSize) {
-		vk::BufferCreateInfo indexBufferCreateInfo{
-			.size = indexBufferSize * 2,
-			.usage = vk::BufferUsageFlagBits::eIndexBuffer,
-		};
-		vma::AllocationCreateInfo indexAllocationCreateInfo{
-			.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
-			.usage = vma::MemoryUsage::eAutoPreferHost,
-			.requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible,
-		};
+	ring.head = *offset + size;
+	ring.ranges.push_back(GeometryRange{
+		.frameValue = context.frameValue,
+		.end = ring.head,
+	});
 
-		frameResources.indexBuffer = ware::contextVK::createBuffer(context, indexBufferCreateInfo, indexAllocationCreateInfo);
-	}
+	const auto vertexOffset = *offset % ring.size;
+
+	frameResources.geometry = Geometry{
+		.hash = hash,
+		.start = *offset,
+		.vertexOffset = vertexOffset,
+		.indexOffset = vertexOffset + indexStart,
+		.vertexCount = static_cast<uint32_t>(drawData ? drawData->TotalVtxCount : 0),
+		.indexCount = static_cast<uint32_t>(drawData ? drawData->TotalIdxCount : 0),
+	};
 }
 
 void uploadBuffers(State &state) {
@@ -467,153 +577,102 @@ void uploadBuffers(State &state) {
 		return;
 	}
 
-	const vk::DeviceSize vertexBufferSize = drawData->TotalVtxCount * sizeof(ImDrawVert);
 	const vk::DeviceSize indexBufferSize = drawData->TotalIdxCount * sizeof(ImDrawIdx);
 
 	const auto &swapchain = state.swapchain;
-	auto &frameResources = state.frameResources[swapchain.frameIndex];
+	auto &ring = state.geometryRing;
+
+	auto *mappedData = reinterpret_cast<std::byte *>(ring.buffer->mappedData);
+	const auto &geometry = state.frameResources[swapchain.frameIndex].geometry;
+
+	// vertices and indices are laid out in the order of the lists, the destinations are a prefix sum over their sizes
+	std::vector<util::CopySegment> segments{};
+	segments.reserve(static_cast<size_t>(drawData->CmdListsCount) * 2);
 
-	auto *vertexMappedData = reinterpret_cast<ImDrawVert *>(frameResources.vertexBuffer->mappedData);
-	auto *indexMappedData = reinterpret_cast<ImDrawIdx *>(frameResources.indexBuffer->mappedData);
+	auto *vertexDestination = mappedData + geometry.vertexOffset;
+	auto *indexDestination = mappedData + geometry.indexOffset;
 
 	for (const auto &cmdList : std::span{drawData->CmdLists, static_cast<uint32_t>(drawData->CmdListsCount)}) {
-		vertexMappedData = std::copy_n(cmdList->VtxBuffer.Data, cmdList->VtxBuffer.Size, vertexMappedData);
-		indexMappedData = std::copy_n(cmdList->IdxBuffer.Data, cmdList->IdxBuffer.Size, indexMappedData);
+		const auto vertexSize = static_cast<size_t>(cmdList->VtxBuffer.Size) * sizeof(ImDrawVert);
+		const auto indexSize = static_cast<size_t>(cmdList->IdxBuffer.Size) * sizeof(ImDrawIdx);
+
+		segments.push_back(util::CopySegment{
+			.destination = vertexDestination,
+			.source = reinterpret_cast<const std::byte *>(cmdList->VtxBuffer.Data),
+			.size = vertexSize,
+		});
+		segments.push_back(util::CopySegment{
+			.destination = indexDestination,
+			.source = reinterpret_cast<const std::byte *>(cmdList->IdxBuffer.Data),
+			.size = indexSize,
+		});
+
+		vertexDestination += vertexSize;
+		indexDestination += indexSize;
 	}
 
-	ware::contextVK::flushMappedData(frameResources.vertexBuffer, 0, vertexBufferSize);
-	ware::contextVK::flushMappedData(frameResources.indexBuffer, 0, indexBufferSize);
+	// the mapping is written sequentially and never read, streaming stores skip reading it into the cache
+	util::streamCopyParallel(state.jobs, segments, minCopyJobSize);
 
-	frameResources.vertexCount = drawData->TotalVtxCount;
-	frameResources.indexCount = drawData->TotalIdxCount;
+	// vertices and indices are one range of the ring
+	ware::contextVK::flushMappedData(ring.buffer, geometry.vertexOffset, geometry.indexOffset + indexBufferSize - geometry.vertexOffset);
 }
 
 vk::CommandBuffer render(State &state) {
 	const auto &context = state.context;
 	const auto &swapchain = state.swapchain;
-	const auto &swapchainImageResources = swapchain.imageResources[swapchain.imageIndex];
 	auto &frameResources = state.frameResources[swapchain.frameIndex];
-
-	context.device->resetCommandPool(frameResources.renderingCommandPool.get());
+	const auto &geometry = frameResources.geometry;
 
 	auto &cmd = frameResources.renderingCommandBuffer;
 
-	vk::ImageSubresourceRange  swapchainSubresourceRange{
-		.aspectMask = vk::ImageAspectFlagBits::eColor,
-		.baseMipLevel = 0,
-		.levelCount = 1,
-		.baseArrayLayer = 0,
-		.layerCount = 1,
+	const Recording recording{
+		.hash = geometry.hash,
+		.vertexOffset = geometry.vertexOffset,
+		.indexOffset = geometry.indexOffset,
+		.uiLayerView = ware::rendererVK::transient::imageView(state.transient, state.uiLayerTarget),
 	};
 
-	vk::CommandBufferInheritanceInfo inheritanceInfo{};
-	cmd.begin({
-		.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
-		.pInheritanceInfo = &inheritanceInfo,
-	});
-
-	if ( ! state.fontImageUploaded) {
-		std::array preImageMemoryBerries{
-			vk::ImageMemoryBarrier2{
-				.srcStageMask = vk::PipelineStageFlagBits2::eHost,
-				.srcAccessMask = vk::AccessFlagBits2::eNone,
-				.dstStageMask = vk::PipelineStageFlagBits2::eTransfer,
-				.dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
-				.oldLayout = vk::ImageLayout::eUndefined,
-				.newLayout = vk::ImageLayout::eTransferDstOptimal,
-				.srcQueueFamilyIndex = context.graphicQueueFamily,
-				.dstQueueFamilyIndex = context.graphicQueueFamily,
-				.image = state.fontImage->image,
-				.subresourceRange = {
-					.aspectMask = vk::ImageAspectFlagBits::eColor,
-					.levelCount = 1,
-					.layerCount = 1,
-				},
-			},
-		};
-		cmd.pipelineBarrier2({
-			.imageMemoryBarrierCount = static_cast<uint32_t>(preImageMemoryBerries.size()),
-			.pImageMemoryBarriers = preImageMemoryBerries.data(),
-		});
+	// the previous submission of this slot has retired, so its command buffer can go again as it is
+	if (frameResources.recording == recording) {
+		state.skipStatistics.skippedRecordCount++;
 
-		std::array regions{
-			vk::BufferImageCopy2{
-				.bufferOffset = 0,
-				.bufferRowLength = 0, // tightly packed
-				.bufferImageHeight = 0, // tightly packed
-				.imageSubresource = {
-					.aspectMask = vk::ImageAspectFlagBits::eColor,
-					.mipLevel = 0,
-					.baseArrayLayer = 0,
-					.layerCount = 1,
-				},
-				.imageOffset = {},
-				.imageExtent = state.fontImage->extent,
-			},
-		};
+		return cmd;
+	}
 
-		cmd.copyBufferToImage2({
-			.srcBuffer = state.fontStaginBuffer->buffer,
-			.dstImage = state.fontImage->image,
-			.dstImageLayout = vk::ImageLayout::eTransferDstOptimal,
-			.regionCount = static_cast<uint32_t>(regions.size()),
-			.pRegions = regions.data(),
-		});
+	context.device->resetCommandPool(frameResources.renderingCommandPool.get());
 
-		std::array postImageMemoryBerries{
-			vk::ImageMemoryBarrier2{
-				.srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
-				.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
-				.dstStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
-				.dstAccessMask = vk::AccessFlagBits2::eShaderRead,
-				.oldLayout = vk::ImageLayout::eTransferDstOptimal,
-				.newLayout = vk::ImageLayout::eReadOnlyOptimal,
-				.srcQueueFamilyIndex = context.graphicQueueFamily,
-				.dstQueueFamilyIndex = context.graphicQueueFamily,
-				.image = state.fontImage->image,
-				.subresourceRange = {
-					.aspectMask = vk::ImageAspectFlagBits::eColor,
-					.levelCount = 1,
-					.layerCount = 1,
-				},
-			},
-		};
-		cmd.pipelineBarrier2({
-			.imageMemoryBarrierCount = static_cast<uint32_t>(postImageMemoryBerries.size()),
-			.pImageMemoryBarriers = postImageMemoryBerries.data(),
-		});
+	frameResources.recording = recording;
 
-		vk::DescriptorImageInfo fontImageInfo{
-			.imageView = state.fontImageView.get(),
-			.imageLayout = vk::ImageLayout::eReadOnlyOptimal,
-		};
-		vk::DescriptorImageInfo fontSamplerInfo{
-			.sampler = state.fontSampler.get(),
-		};
+	vk::CommandBufferInheritanceInfo inheritanceInfo{
+		.pipelineStatistics = ware::rendererVK::profiler::inheritedPipelineStatistics(context),
+	};
+	// not one time submit, it may be submitted again
+	cmd.begin({
+		.pInheritanceInfo = &inheritanceInfo,
+	});
 
-		std::array writeDescriptorSets{
-			vk::WriteDescriptorSet{
-				.dstSet = state.descriptorSets[DescriptorIndex::Images],
-				.dstBinding = 0,
-				.dstArrayElement = 0,
-				.descriptorCount = 1,
-				.descriptorType = vk::DescriptorType::eSampledImage,
-				.pImageInfo = &fontImageInfo,
-			},
-			vk::WriteDescriptorSet{
-				.dstSet = state.descriptorSets[DescriptorIndex::Samplers],
-				.dstBinding = 0,
-				.dstArrayElement = 0,
-				.descriptorCount = 1,
-				.descriptorType = vk::DescriptorType::eSampler,
-				.pImageInfo = &fontSamplerInfo,
+	// the layer is transient, it is cleared even without anything to draw so that the composite pass reads transparent texels
+	std::array colorAttachments{
+		vk::RenderingAttachmentInfo{
+			.imageView = recording.uiLayerView,
+			.imageLayout = vk::ImageLayout::eAttachmentOptimal,
+			.loadOp = vk::AttachmentLoadOp::eClear,
+			.storeOp = vk::AttachmentStoreOp::eStore,
+			.clearValue = {
+				.color = {
+					.float32 = std::array<float, 4>{ 0.0f, 0.0f, 0.0f, 0.0f },
+				},
 			},
-		};
-
-		context.device->updateDescriptorSets(static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+		},
+	};
 
-		state.fontImageUploaded = true;
-	}
+	cmd.beginRendering(vk::RenderingInfo{
+		.renderArea = vk::Rect2D{ 0, 0, static_cast<uint32_t>(state.window.description->width), static_cast<uint32_t>(state.window.description->height) },
+		.layerCount = 1,
+		.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size()),
+		.pColorAttachments = colorAttachments.data(),
+	});
 
 	ImDrawData *drawData = ImGui::GetDrawData();
 	if (drawData && drawData->CmdListsCount > 0) {
@@ -621,32 +680,20 @@ vk::CommandBuffer render(State &state) {
 		const auto width = static_cast<uint32_t>(io.DisplaySize.x);
 		const auto height = static_cast<uint32_t>(io.DisplaySize.y);
 
-		std::array colorAttachments{
-			vk::RenderingAttachmentInfo{
-				.imageView = swapchainImageResources.imageView.get(),
-				.imageLayout = vk::ImageLayout::eAttachmentOptimal,
-				.loadOp = vk::AttachmentLoadOp::eLoad,
-				.storeOp = vk::AttachmentStoreOp::eStore,
-			},
-		};
-
-		cmd.beginRendering(vk::RenderingInfo{
-			.renderArea = vk::Rect2D{ 0, 0, width, height },
-			.layerCount = 1,
-			.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size()),
-			.pColorAttachments = colorAttachments.data(),
-		});
-
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, state.layout.get(), 0, static_cast<uint32_t>(state.descriptorSets.size()), state.descriptorSets.data(), 0, nullptr);
+		ware::contextVK::bindDescriptorHeap(context, cmd, vk::PipelineBindPoint::eGraphics, state.pipelineLayout.layout, ware::rendererVK::reflection::heapSet);
 
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, state.pipeline.get());
 
+		uint32_t imageIndex = state.fontImageDescriptor->index;
+
 		{
 			PushConstant pushConstant{
 				.scale = { 2.0f / io.DisplaySize.x, 2.0f / io.DisplaySize.y },
 				.translate = { -1.0f, -1.0f },
+				.imageIndex = imageIndex,
+				.samplerIndex = state.fontSamplerDescriptor->index,
 			};
-			cmd.pushConstants(state.layout.get(), vk::ShaderStageFlagBits::eAll, 0, sizeof(PushConstant), &pushConstant);
+			cmd.pushConstants(state.pipelineLayout.layout, state.pipelineLayout.pushConstantStages, 0, sizeof(PushConstant), &pushConstant);
 		}
 
 		cmd.setViewportWithCount({
@@ -660,14 +707,14 @@ vk::CommandBuffer render(State &state) {
 			},
 		});
 
-		cmd.bindIndexBuffer(frameResources.indexBuffer->buffer, 0, sizeof(ImDrawIdx) == sizeof(uint16_t) ? vk::IndexType::eUint16 : vk::IndexType::eUint32);
+		cmd.bindIndexBuffer(state.geometryRing.buffer->buffer, geometry.indexOffset, sizeof(ImDrawIdx) == sizeof(uint16_t) ? vk::IndexType::eUint16 : vk::IndexType::eUint32);
 
 		{
 			std::array buffers{
-				frameResources.vertexBuffer->buffer,
+				state.geometryRing.buffer->buffer,
 			};
 			std::array offsets{
-				vk::DeviceSize{0u},
+				geometry.vertexOffset,
 			};
 			cmd.bindVertexBuffers2(0, 1, buffers.data(), offsets.data(), nullptr, nullptr);
 		}
@@ -680,6 +727,11 @@ vk::CommandBuffer render(State &state) {
 			for (int32_t j = 0; j < drawList->CmdBuffer.Size; j++) {
 				const ImDrawCmd *drawCmd = &drawList->CmdBuffer[j];
 
+				if (const auto drawImageIndex = static_cast<uint32_t>(drawCmd->GetTexID()); drawImageIndex != imageIndex) {
+					imageIndex = drawImageIndex;
+					cmd.pushConstants(state.pipelineLayout.layout, state.pipelineLayout.pushConstantStages, offsetof(PushConstant, imageIndex), sizeof(imageIndex), &imageIndex);
+				}
+
 				cmd.setScissorWithCount({
 					vk::Rect2D{
 						static_cast<int32_t>(drawCmd->ClipRect.x),
@@ -696,71 +748,81 @@ vk::CommandBuffer render(State &state) {
 
 			vertexOffset += drawList->VtxBuffer.Size;
 		}
-
-		cmd.endRendering();
 	}
 
-	{
-		std::array imageMemoryBerries{
-			vk::ImageMemoryBarrier2{
-				.srcStageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-				.srcAccessMask = vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite,
-				.dstStageMask = vk::PipelineStageFlagBits2::eBottomOfPipe,
-				.dstAccessMask = vk::AccessFlagBits2::eMemoryRead,
-				.oldLayout = vk::ImageLayout::eAttachmentOptimal,
-				.newLayout = vk::ImageLayout::ePresentSrcKHR,
-				.srcQueueFamilyIndex = context.graphicQueueFamily,
-				.dstQueueFamilyIndex = context.presentationQueueFamily,
-				.image = swapchainImageResources.image,
-				.subresourceRange = swapchainSubresourceRange,
-			},
-		};
-
-		cmd.pipelineBarrier2({
-			.imageMemoryBarrierCount = static_cast<uint32_t>(imageMemoryBerries.size()),
-			.pImageMemoryBarriers = imageMemoryBerries.data(),
-		});
-	}
+	cmd.endRendering();
 
 	cmd.end();
 
 	return cmd;
 }
 
+std::move_only_function<vk::UniquePipeline()> rebuildPipeline(const State &state) {
+	return [&window = state.window, &context = state.context, &pipelineLayout = state.pipelineLayout, colorFormat = ware::rendererVK::transient::findTarget(state.transient, state.uiLayerTarget).format] {
+		auto shaderCodes = ware::rendererVK::shaders::load(shaderFiles, ware::rendererVK::shaders::Source::eOverride);
+		auto modules = reflectShaders(shaderCodes);
+
+		ware::rendererVK::reflection::checkLayoutUnchanged(modules, pipelineLayout);
+
+		return createPipeline(window, context, colorFormat, pipelineLayout.layout, shaderCodes, modules);
+	};
+}
+
+void replacePipeline(State &state, vk::UniquePipeline &&pipeline) {
+	auto &context = state.context;
+
+	ware::contextVK::deferDestroy(context, context.frameValue, std::exchange(state.pipeline, std::move(pipeline)));
+
+	invalidateRecordings(state);
+}
+
 State::~State() {
-	ware::contextVK::requestWaitIdle(context);
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(frameResources), std::move(geometryRing), std::move(pipeline), std::move(fontSamplerDescriptor), std::move(fontImageDescriptor), std::move(fontImageView), std::move(fontImage));
 }
 
-State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, [[maybe_unused]] ware::contextImgui::State &imgui, ware::swapchainVK::State &swapchain) {
-	auto descriptorPool = createDescriptorPool(context);
+State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::uploadVK::State &upload, [[maybe_unused]] ware::contextImgui::State &imgui, ware::swapchainVK::State &swapchain, const ware::rendererVK::profiler::State &profiler, const ware::rendererVK::transient::State &transient, util::JobSystem &jobs, graph::ResourceId uiLayerTarget) {
+	auto shaderCodes = ware::rendererVK::shaders::load(shaderFiles, ware::rendererVK::shaders::Source::eEmbedded);
+	auto modules = reflectShaders(shaderCodes);
 
-	auto descriptorSetLayouts = createDescriptorSetLayouts(context);
+	auto pipelineLayout = ware::rendererVK::reflection::createPipelineLayout(context, modules);
+	ware::rendererVK::reflection::checkPushConstantSize(pipelineLayout, sizeof(PushConstant));
 
-	auto layout = createPipelineLayout(context, descriptorSetLayouts);
+	auto pipeline = createPipeline(window, context, ware::rendererVK::transient::findTarget(transient, uiLayerTarget).format, pipelineLayout.layout, shaderCodes, modules);
 
-	auto pipeline = createPipeline(window, context, swapchain, layout.get());
+	auto [fontImage, fontImageView, fontSampler] = createFontResources(context, upload);
 
-	auto [fontImage, fontImageView, fontStaginBuffer, fontSampler] = createFontResources(context);
+	auto fontImageDescriptor = ware::contextVK::createSampledImageDescriptor(context, fontImageView.get(), vk::ImageLayout::eReadOnlyOptimal);
+	auto fontSamplerDescriptor = ware::contextVK::createSamplerDescriptor(context, fontSampler);
 
-	auto descriptorSets = allocateDescriptorSets(context, descriptorPool.get(), descriptorSetLayouts);
+	ImGui::GetIO().Fonts->SetTexID(static_cast<ImTextureID>(fontImageDescriptor->index));
 
 	auto frameResources = createFrameResources(context, swapchain);
 
+	auto geometryRing = createGeometryRing(context, initialGeometryRingSize, 0);
+
 	return State{
 		.window = window,
 		.context = context,
 		.swapchain = swapchain,
-		.descriptorPool = std::move(descriptorPool),
-		.descriptorSetLayouts = std::move(descriptorSetLayouts),
-		.layout = std::move(layout),
+		.profiler = profiler,
+		.transient = transient,
+		.jobs = jobs,
+		.uiLayerTarget = uiLayerTarget,
+		.pipelineLayout = std::move(pipelineLayout),
 		.pipeline = std::move(pipeline),
 		.fontImage = std::move(fontImage),
 		.fontImageView = std::move(fontImageView),
-		.fontStaginBuffer = std::move(fontStaginBuffer),
-		.fontSampler = std::move(fontSampler),
-		.fontImageUploaded = false,
-		.descriptorSets = std::move(descriptorSets),
+		.fontSampler = fontSampler,
+		.fontImageDescriptor = std::move(fontImageDescriptor),
+		.fontSamplerDescriptor = std::move(fontSamplerDescriptor),
 		.frameResources = std::move(frameResources),
+		.geometryRing = std::move(geometryRing),
+		.previousGeometry = std::nullopt,
+		.skipStatistics = {
+			.frameCount = 0,
+			.skippedUploadCount = 0,
+			.skippedRecordCount = 0,
+		},
 		.description = {
 			.changed = false,
 		},
@@ -772,13 +834,28 @@ void refresh(State &state) {
 
 	if (state.swapchain.description.changed) {
 		recreateFrameResources(state);
+		// the transient layer may have been recreated along with the swapchain
+		invalidateRecordings(state);
 	}
 
 	recordNewFrame(state);
 
-	resizeBuffers(state);
+	const auto hash = hashDrawData(ImGui::GetDrawData());
+
+	if (state.previousGeometry && state.previousGeometry->hash == hash) {
+		reuseGeometry(state, *state.previousGeometry);
+
+		state.skipStatistics.skippedUploadCount++;
+	} else {
+		allocateGeometry(state, hash);
+
+		uploadBuffers(state);
+	}
+
+	state.previousGeometry = state.frameResources[state.swapchain.frameIndex].geometry;
+	state.skipStatistics.frameCount++;
 
-	uploadBuffers(state);
+	TracyPlot("imgui skipped uploads [%]", skipRate(state.skipStatistics.skippedUploadCount, state.skipStatistics.frameCount));
 }
 
 vk::CommandBuffer process(State &state) {
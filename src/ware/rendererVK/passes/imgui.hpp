@@ -1,18 +1,76 @@
 #pragma once
 
+#include <array>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string_view>
+
+#include <util/jobSystem.hpp>
+
 #include "../../contextVK/contextVK.hpp"
 #include "../../swapchainVK/swapchainVK.hpp"
+#include "../../uploadVK/uploadVK.hpp"
 #include "../../contextImgui/contextImgui.hpp"
+#include "../profiler.hpp"
+#include "../reflection.hpp"
+#include "../transient.hpp"
 
 namespace ware::rendererVK::passes::imgui {
 
+const std::array<std::string_view, 2> shaderFiles{ "imgui.vert.spv", "imgui.frag.spv" };
+
+// where the vertices and indices of a frame are in the geometry ring
+struct Geometry {
+	// of the draw data, a frame with the same hash as the previous one shares its range
+	uint64_t hash;
+	// monotonic ring position the range starts at
+	vk::DeviceSize start;
+	vk::DeviceSize vertexOffset;
+	vk::DeviceSize indexOffset;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+};
+
+// what a command buffer was recorded with, it is submitted again while that stays the same
+struct Recording {
+	uint64_t hash;
+	vk::DeviceSize vertexOffset;
+	vk::DeviceSize indexOffset;
+	vk::ImageView uiLayerView;
+
+	bool operator==(const Recording &other) const = default;
+};
+
 struct FrameResources {
 	vk::UniqueCommandPool renderingCommandPool;
 	vk::CommandBuffer renderingCommandBuffer;
-	ware::contextVK::UniqueBuffer vertexBuffer;
-	ware::contextVK::UniqueBuffer indexBuffer;
-	uint32_t vertexCount;
-	uint32_t indexCount;
+	Geometry geometry;
+	// empty once anything the command buffer references was replaced
+	std::optional<Recording> recording;
+};
+
+struct SkipStatistics {
+	uint64_t frameCount;
+	uint64_t skippedUploadCount;
+	uint64_t skippedRecordCount;
+};
+
+struct GeometryRange {
+	uint64_t frameValue;
+	vk::DeviceSize end;
+};
+
+// vertex and index data of every frame in flight in one persistently mapped buffer, each frame takes one range of it
+struct GeometryRing {
+	ware::contextVK::UniqueBuffer buffer;
+	vk::DeviceSize size;
+	// head and tail grow monotonically, the ring offset is their value modulo size
+	vk::DeviceSize head;
+	vk::DeviceSize tail;
+	// oldest first, the tail moves past a range once its frame retired
+	std::deque<GeometryRange> ranges;
+	uint32_t growCount;
 };
 
 struct Description {
@@ -23,29 +81,39 @@ struct State {
 	ware::windowGLFW::State &window;
 	ware::contextVK::State &context;
 	ware::swapchainVK::State &swapchain;
+	const ware::rendererVK::profiler::State &profiler;
+	const ware::rendererVK::transient::State &transient;
+	// large draw data is copied into the geometry ring by several workers
+	util::JobSystem &jobs;
+	graph::ResourceId uiLayerTarget;
 
-	vk::UniqueDescriptorPool descriptorPool;
-	std::vector<vk::UniqueDescriptorSetLayout> descriptorSetLayouts;
-	vk::UniquePipelineLayout layout;
+	ware::rendererVK::reflection::PipelineLayout pipelineLayout;
 	vk::UniquePipeline pipeline;
 	ware::contextVK::UniqueImage fontImage;
 	vk::UniqueImageView fontImageView;
-	ware::contextVK::UniqueBuffer fontStaginBuffer;
-	vk::UniqueSampler fontSampler;
-	bool fontImageUploaded;
-	std::vector<vk::DescriptorSet> descriptorSets;
+	// shared through the context cache
+	vk::Sampler fontSampler;
+	ware::contextVK::UniqueDescriptor fontImageDescriptor;
+	ware::contextVK::UniqueDescriptor fontSamplerDescriptor;
 
 	std::vector<FrameResources> frameResources;
+	GeometryRing geometryRing;
+	std::optional<Geometry> previousGeometry;
+	SkipStatistics skipStatistics;
 
 	Description description;
 
 	~State();
 };
 
-State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::contextImgui::State &imgui, ware::swapchainVK::State &swapchain);
+State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::uploadVK::State &upload, ware::contextImgui::State &imgui, ware::swapchainVK::State &swapchain, const ware::rendererVK::profiler::State &profiler, const ware::rendererVK::transient::State &transient, util::JobSystem &jobs, graph::ResourceId uiLayerTarget);
 
 void refresh(State &state);
 
 vk::CommandBuffer process(State &state);
 
+[[nodiscard]] std::move_only_function<vk::UniquePipeline()> rebuildPipeline(const State &state);
+
+void replacePipeline(State &state, vk::UniquePipeline &&pipeline);
+
 } // ware::rendererVK::passes::imgui
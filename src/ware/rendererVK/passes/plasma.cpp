@@ -0,0 +1,230 @@
+#include "plasma.hpp"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <util/map.hpp>
+
+#include "../reflection.hpp"
+#include "../shaders.hpp"
+
+namespace ware::rendererVK::passes::plasma {
+
+struct PushConstant {
+	float time;
+	uint32_t imageIndex;
+};
+
+const uint32_t imageSize = 512;
+const uint32_t workGroupSize = 8;
+
+[[nodiscard]] std::vector<ware::rendererVK::reflection::Module> reflectShaders(const std::vector<ware::rendererVK::shaders::Code> &shaderCodes) {
+	return util::map(shaderCodes, [] (const auto &shaderCode) {
+		return ware::rendererVK::reflection::reflect(shaderCode.words);
+	});
+}
+
+[[nodiscard]] vk::UniquePipeline createPipeline(ware::contextVK::State &context, vk::PipelineLayout layout, const std::vector<ware::rendererVK::shaders::Code> &shaderCodes) {
+	auto computeShaderModule = ware::rendererVK::shaders::createModule(context, shaderCodes[0]);
+
+	auto resultValue = context.device->createComputePipelineUnique(context.pipelineCache.get(), {
+		.flags = ware::contextVK::descriptorHeapPipelineFlags(context),
+		.stage = {
+			.stage = vk::ShaderStageFlagBits::eCompute,
+			.module = computeShaderModule.get(),
+			.pName = "main",
+		},
+		.layout = layout,
+	});
+
+	if (resultValue.result != vk::Result::eSuccess && resultValue.result != vk::Result::ePipelineCompileRequired) {
+		throw std::runtime_error{fmt::format("Unable to create pipeline (error: {})", vk::to_string(resultValue.result))};
+	}
+
+	return std::move(resultValue.value);
+}
+
+std::vector<FrameResources> createFrameResources(ware::contextVK::State &context, ware::swapchainVK::State &swapchain) {
+	// concurrent sharing spares the ownership transfers when compute and graphic live in different families
+	std::array queueFamilyIndices{
+		context.computeQueueFamily,
+		context.graphicQueueFamily,
+	};
+	const bool concurrent = context.computeQueueFamily != context.graphicQueueFamily;
+
+	return util::mapRange(swapchain.framesInFlight, [&] ([[maybe_unused]] const auto &index) {
+		auto computeCommandPool = context.device->createCommandPoolUnique({
+			.flags = vk::CommandPoolCreateFlagBits::eTransient,
+			.queueFamilyIndex = context.computeQueueFamily,
+		});
+
+		std::vector<vk::CommandBuffer> computeCommandBuffers = context.device->allocateCommandBuffers({
+			.commandPool = computeCommandPool.get(),
+			.level = vk::CommandBufferLevel::ePrimary,
+			.commandBufferCount = 1,
+		});
+
+		vk::ImageCreateInfo imageCreateInfo{
+			.imageType = vk::ImageType::e2D,
+			.format = vk::Format::eR8G8B8A8Unorm,
+			.extent = { imageSize, imageSize, 1 },
+			.mipLevels = 1,
+			.arrayLayers = 1,
+			.usage = vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+			.sharingMode = concurrent ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive,
+			.queueFamilyIndexCount = concurrent ? static_cast<uint32_t>(queueFamilyIndices.size()) : 0,
+			.pQueueFamilyIndices = concurrent ? queueFamilyIndices.data() : nullptr,
+			.initialLayout = vk::ImageLayout::eUndefined,
+		};
+		vma::AllocationCreateInfo allocationCreateInfo{
+			.usage = vma::MemoryUsage::eAutoPreferDevice,
+		};
+
+		auto image = ware::contextVK::createImage(context, imageCreateInfo, allocationCreateInfo);
+
+		auto imageView = context.device->createImageViewUnique({
+			.image = image->image,
+			.viewType = vk::ImageViewType::e2D,
+			.format = vk::Format::eR8G8B8A8Unorm,
+			.subresourceRange = {
+				.aspectMask = vk::ImageAspectFlagBits::eColor,
+				.levelCount = 1,
+				.layerCount = 1,
+			},
+		});
+
+		auto storageImageDescriptor = ware::contextVK::createStorageImageDescriptor(context, imageView.get());
+		auto sampledImageDescriptor = ware::contextVK::createSampledImageDescriptor(context, imageView.get(), vk::ImageLayout::eGeneral);
+
+		return FrameResources{
+			.computeCommandPool = std::move(computeCommandPool),
+			.computeCommandBuffer = computeCommandBuffers[0],
+			.image = std::move(image),
+			.imageView = std::move(imageView),
+			.storageImageDescriptor = std::move(storageImageDescriptor),
+			.sampledImageDescriptor = std::move(sampledImageDescriptor),
+		};
+	});
+}
+
+ComputeWork compute(State &state) {
+	const auto &context = state.context;
+	const auto &swapchain = state.swapchain;
+	auto &frameResources = state.frameResources[swapchain.frameIndex];
+
+	context.device->resetCommandPool(frameResources.computeCommandPool.get());
+
+	auto &cmd = frameResources.computeCommandBuffer;
+
+	cmd.begin({
+		.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+	});
+
+	{
+		// the whole image is rewritten, the previous frame in this slot has retired and its contents can be discarded
+		std::array imageMemoryBarriers{
+			vk::ImageMemoryBarrier2{
+				.srcStageMask = vk::PipelineStageFlagBits2::eNone,
+				.srcAccessMask = vk::AccessFlagBits2::eNone,
+				.dstStageMask = vk::PipelineStageFlagBits2::eComputeShader,
+				.dstAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+				.oldLayout = vk::ImageLayout::eUndefined,
+				.newLayout = vk::ImageLayout::eGeneral,
+				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.image = frameResources.image->image,
+				.subresourceRange = {
+					.aspectMask = vk::ImageAspectFlagBits::eColor,
+					.levelCount = 1,
+					.layerCount = 1,
+				},
+			},
+		};
+
+		cmd.pipelineBarrier2({
+			.imageMemoryBarrierCount = static_cast<uint32_t>(imageMemoryBarriers.size()),
+			.pImageMemoryBarriers = imageMemoryBarriers.data(),
+		});
+	}
+
+	cmd.bindPipeline(vk::PipelineBindPoint::eCompute, state.pipeline.get());
+
+	ware::contextVK::bindDescriptorHeap(context, cmd, vk::PipelineBindPoint::eCompute, state.pipelineLayout.layout, ware::rendererVK::reflection::heapSet);
+
+	{
+		const std::chrono::duration<float> time = std::chrono::steady_clock::now() - state.startTimePoint;
+
+		PushConstant pushConstant{
+			.time = time.count(),
+			.imageIndex = frameResources.storageImageDescriptor->index,
+		};
+		cmd.pushConstants(state.pipelineLayout.layout, state.pipelineLayout.pushConstantStages, 0, sizeof(PushConstant), &pushConstant);
+	}
+
+	cmd.dispatch((imageSize + workGroupSize - 1) / workGroupSize, (imageSize + workGroupSize - 1) / workGroupSize, 1);
+
+	cmd.end();
+
+	return ComputeWork{
+		.commandBuffer = cmd,
+		.consumerStageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+	};
+}
+
+std::move_only_function<vk::UniquePipeline()> rebuildPipeline(const State &state) {
+	return [&context = state.context, &pipelineLayout = state.pipelineLayout] {
+		auto shaderCodes = ware::rendererVK::shaders::load(shaderFiles, ware::rendererVK::shaders::Source::eOverride);
+
+		ware::rendererVK::reflection::checkLayoutUnchanged(reflectShaders(shaderCodes), pipelineLayout);
+
+		return createPipeline(context, pipelineLayout.layout, shaderCodes);
+	};
+}
+
+void replacePipeline(State &state, vk::UniquePipeline &&pipeline) {
+	auto &context = state.context;
+
+	ware::contextVK::deferDestroy(context, context.frameValue, std::exchange(state.pipeline, std::move(pipeline)));
+}
+
+State::~State() {
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(frameResources), std::move(pipeline));
+}
+
+State setup(ware::contextVK::State &context, ware::swapchainVK::State &swapchain) {
+	auto shaderCodes = ware::rendererVK::shaders::load(shaderFiles, ware::rendererVK::shaders::Source::eEmbedded);
+
+	auto pipelineLayout = ware::rendererVK::reflection::createPipelineLayout(context, reflectShaders(shaderCodes));
+	ware::rendererVK::reflection::checkPushConstantSize(pipelineLayout, sizeof(PushConstant));
+
+	auto pipeline = createPipeline(context, pipelineLayout.layout, shaderCodes);
+
+	// frames in flight are fixed for the lifetime of the swapchain state, so are the images
+	auto frameResources = createFrameResources(context, swapchain);
+
+	return State{
+		.context = context,
+		.swapchain = swapchain,
+		.pipelineLayout = std::move(pipelineLayout),
+		.pipeline = std::move(pipeline),
+		.frameResources = std::move(frameResources),
+		.startTimePoint = std::chrono::steady_clock::now(),
+	};
+}
+
+void refresh([[maybe_unused]] State &state) {
+	ZoneScopedN("ware::rendererVK::passes::plasma::refresh()");
+}
+
+ComputeWork process(State &state) {
+	ZoneScopedN("ware::rendererVK::passes::plasma::process()");
+
+	return compute(state);
+}
+
+} // ware::rendererVK::passes::plasma
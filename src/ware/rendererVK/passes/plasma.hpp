@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "../../contextVK/contextVK.hpp"
+#include "../../swapchainVK/swapchainVK.hpp"
+#include "../reflection.hpp"
+#include "work.hpp"
+
+namespace ware::rendererVK::passes::plasma {
+
+const std::array<std::string_view, 1> shaderFiles{ "plasma.comp.spv" };
+
+struct FrameResources {
+	vk::UniqueCommandPool computeCommandPool;
+	vk::CommandBuffer computeCommandBuffer;
+	ware::contextVK::UniqueImage image;
+	vk::UniqueImageView imageView;
+	// written here through the first, sampled by later passes through the second
+	ware::contextVK::UniqueDescriptor storageImageDescriptor;
+	ware::contextVK::UniqueDescriptor sampledImageDescriptor;
+};
+
+struct State {
+	ware::contextVK::State &context;
+	ware::swapchainVK::State &swapchain;
+
+	ware::rendererVK::reflection::PipelineLayout pipelineLayout;
+	vk::UniquePipeline pipeline;
+	// one image per frame slot, written on the compute queue and sampled on the graphic queue in vk::ImageLayout::eGeneral
+	std::vector<FrameResources> frameResources;
+	std::chrono::steady_clock::time_point startTimePoint;
+
+	~State();
+};
+
+State setup(ware::contextVK::State &context, ware::swapchainVK::State &swapchain);
+
+void refresh(State &state);
+
+ComputeWork process(State &state);
+
+[[nodiscard]] std::move_only_function<vk::UniquePipeline()> rebuildPipeline(const State &state);
+
+void replacePipeline(State &state, vk::UniquePipeline &&pipeline);
+
+} // ware::rendererVK::passes::plasma
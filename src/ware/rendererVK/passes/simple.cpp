@@ -2,200 +2,37 @@
 
 #include <algorithm>
 #include <array>
-#include <filesystem>
+#include <span>
+#include <utility>
 #include <vector>
 
 #include <fmt/format.h>
 #include <spdlog/spdlog.h>
 #include <tracy/Tracy.hpp>
 
-#include <util/fs.hpp>
 #include <util/map.hpp>
 
-namespace ware::rendererVK::passes::simple {
-
-const uint32_t uniformBufferMaxCount = 1024;
-const uint32_t sampledImageMaxCount = 1024;
-const uint32_t storageImageMaxCount = 1024;
-const uint32_t samplerMaxCount = 32;
-
-[[nodiscard]] vk::UniqueDescriptorPool createDescriptorPool(ware::contextVK::State &context) {
-	std::array poolSizes{
-		 vk::DescriptorPoolSize{
-			.type = vk::DescriptorType::eUniformBuffer,
-			.descriptorCount = uniformBufferMaxCount,
-		},
-		 vk::DescriptorPoolSize{
-			.type = vk::DescriptorType::eSampledImage,
-			.descriptorCount = sampledImageMaxCount,
-		},
-		 vk::DescriptorPoolSize{
-			.type = vk::DescriptorType::eStorageImage,
-			.descriptorCount = storageImageMaxCount,
-		},
-		 vk::DescriptorPoolSize{
-			.type = vk::DescriptorType::eSampler,
-			.descriptorCount = samplerMaxCount,
-		},
-	};
+#include "../profiler.hpp"
+#include "../reflection.hpp"
+#include "../shaders.hpp"
 
-	return context.device->createDescriptorPoolUnique({
-		.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
-		.maxSets = uniformBufferMaxCount + sampledImageMaxCount + storageImageMaxCount + samplerMaxCount,
-		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
-		.pPoolSizes = poolSizes.data(),
-	});
-}
-
-[[nodiscard]] std::vector<vk::UniqueDescriptorSetLayout> createDescriptorSetLayouts(ware::contextVK::State &context) {
-	std::array buffersSetLayoutBindings{
-		vk::DescriptorSetLayoutBinding{
-			.binding = 0,
-			.descriptorType = vk::DescriptorType::eUniformBuffer,
-			.descriptorCount = uniformBufferMaxCount,
-			.stageFlags = vk::ShaderStageFlagBits::eAll,
-			.pImmutableSamplers = nullptr,
-		},
-	};
-
-	std::array sampledImagesSetLayoutBindings{
-		vk::DescriptorSetLayoutBinding{
-			.binding = 0,
-			.descriptorType = vk::DescriptorType::eSampledImage,
-			.descriptorCount = sampledImageMaxCount,
-			.stageFlags = vk::ShaderStageFlagBits::eAll,
-			.pImmutableSamplers = nullptr,
-		},
-	};
-
-	std::array storageImagesSetLayoutBindings{
-		vk::DescriptorSetLayoutBinding{
-			.binding = 0,
-			.descriptorType = vk::DescriptorType::eStorageImage,
-			.descriptorCount = storageImageMaxCount,
-			.stageFlags = vk::ShaderStageFlagBits::eAll,
-			.pImmutableSamplers = nullptr,
-		},
-	};
-
-	std::array samplersSetLayoutBindings{
-		vk::DescriptorSetLayoutBinding{
-			.binding = 0,
-			.descriptorType = vk::DescriptorType::eSampler,
-			.descriptorCount = samplerMaxCount,
-			.stageFlags = vk::ShaderStageFlagBits::eAll,
-			.pImmutableSamplers = nullptr,
-		},
-	};
-
-	std::array<vk::DescriptorBindingFlags, buffersSetLayoutBindings.size()> buffersSetLayoutBindingFlags{};
-	std::array<vk::DescriptorBindingFlags, sampledImagesSetLayoutBindings.size()> sampledImagesSetLayoutBindingFlags{};
-	std::array<vk::DescriptorBindingFlags, storageImagesSetLayoutBindings.size()> storageImagesSetLayoutBindingFlags{};
-	std::array<vk::DescriptorBindingFlags, samplersSetLayoutBindings.size()> samplersSetLayoutBindingFlags{};
-
-	auto bindlessBindingFlags = vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eVariableDescriptorCount | vk::DescriptorBindingFlagBits::eUpdateAfterBind;
-	buffersSetLayoutBindingFlags.fill(bindlessBindingFlags);
-	sampledImagesSetLayoutBindingFlags.fill(bindlessBindingFlags);
-	storageImagesSetLayoutBindingFlags.fill(bindlessBindingFlags);
-	samplersSetLayoutBindingFlags.fill(bindlessBindingFlags);
-
-	vk::StructureChain buffersSetLayoutCreateInfo{
-		vk::DescriptorSetLayoutCreateInfo{
-			.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
-			.bindingCount = static_cast<uint32_t>(buffersSetLayoutBindings.size()),
-			.pBindings = buffersSetLayoutBindings.data(),
-		},
-		vk::DescriptorSetLayoutBindingFlagsCreateInfo{
-			.bindingCount = static_cast<uint32_t>(buffersSetLayoutBindingFlags.size()),
-			.pBindingFlags = buffersSetLayoutBindingFlags.data(),
-		},
-	};
-	vk::StructureChain sampledImagesSetLayoutCreateInfo{
-		vk::DescriptorSetLayoutCreateInfo{
-			.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
-			.bindingCount = static_cast<uint32_t>(sampledImagesSetLayoutBindings.size()),
-			.pBindings = sampledImagesSetLayoutBindings.data(),
-		},
-		vk::DescriptorSetLayoutBindingFlagsCreateInfo{
-			.bindingCount = static_cast<uint32_t>(sampledImagesSetLayoutBindingFlags.size()),
-			.pBindingFlags = sampledImagesSetLayoutBindingFlags.data(),
-		},
-	};
-	vk::StructureChain storageImagesSetLayoutCreateInfo{
-		vk::DescriptorSetLayoutCreateInfo{
-			.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
-			.bindingCount = static_cast<uint32_t>(storageImagesSetLayoutBindings.size()),
-			.pBindings = storageImagesSetLayoutBindings.data(),
-		},
-		vk::DescriptorSetLayoutBindingFlagsCreateInfo{
-			.bindingCount = static_cast<uint32_t>(storageImagesSetLayoutBindingFlags.size()),
-			.pBindingFlags = storageImagesSetLayoutBindingFlags.data(),
-		},
-	};
-	vk::StructureChain samplersSetLayoutCreateInfo{
-		vk::DescriptorSetLayoutCreateInfo{
-			.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
-			.bindingCount = static_cast<uint32_t>(samplersSetLayoutBindings.size()),
-			.pBindings = samplersSetLayoutBindings.data(),
-		},
-		vk::DescriptorSetLayoutBindingFlagsCreateInfo{
-			.bindingCount = static_cast<uint32_t>(samplersSetLayoutBindingFlags.size()),
-			.pBindingFlags = samplersSetLayoutBindingFlags.data(),
-		},
-	};
-
-	auto buffersSetLayout = context.device->createDescriptorSetLayoutUnique(buffersSetLayoutCreateInfo.get());
-	auto sampledImagesSetLayout = context.device->createDescriptorSetLayoutUnique(sampledImagesSetLayoutCreateInfo.get());
-	auto storageImagesSetLayout = context.device->createDescriptorSetLayoutUnique(storageImagesSetLayoutCreateInfo.get());
-	auto samplersSetLayout = context.device->createDescriptorSetLayoutUnique(samplersSetLayoutCreateInfo.get());
-
-	std::vector<vk::UniqueDescriptorSetLayout> setLayouts{};
-	setLayouts.reserve(4);
-	setLayouts.push_back(std::move(buffersSetLayout));
-	setLayouts.push_back(std::move(sampledImagesSetLayout));
-	setLayouts.push_back(std::move(storageImagesSetLayout));
-	setLayouts.push_back(std::move(samplersSetLayout));
-
-	return setLayouts;
-}
-
-[[nodiscard]] vk::UniquePipelineLayout createPipelineLayout(ware::contextVK::State &context, const std::vector<vk::UniqueDescriptorSetLayout> &descriptorSetLayouts) {
-	std::vector setLayouts = util::map(descriptorSetLayouts, [] (const auto &setLayout) { return setLayout.get(); });
-
-	return context.device->createPipelineLayoutUnique({
-		.setLayoutCount = static_cast<uint32_t>(setLayouts.size()),
-		.pSetLayouts = setLayouts.data(),
-		.pushConstantRangeCount = 0,
-		.pPushConstantRanges = nullptr,
-	});
-}
-
-[[nodiscard]] vk::UniqueShaderModule createShaderModule(ware::contextVK::State &context, const std::filesystem::path &filePath) {
-	auto contentsO = util::fsReadBytes(filePath);
-
-	if ( ! contentsO) {
-		throw std::runtime_error{fmt::format("Unable to read shader file \"{}\"", filePath.string())};
-	}
-
-	if (contentsO->size() == 0) {
-		throw std::runtime_error{fmt::format("Shader file \"{}\" is empty", filePath.string())};
-	}
-
-	if (contentsO->size() % sizeof(uint32_t) != 0) {
-		throw std::runtime_error{fmt::format("Shader file \"{}\" is corrupted (size: {})", filePath.string(), contentsO->size())};
-	}
+namespace ware::rendererVK::passes::simple {
 
-	vk::ShaderModuleCreateInfo PFN_vkGetShaderModuleCreateInfoIdentifierEXT;
+// indices into the descriptor heap
+struct PushConstant {
+	uint32_t plasmaImageIndex;
+	uint32_t samplerIndex;
+};
 
-	return context.device->createShaderModuleUnique({
-		.codeSize = static_cast<uint32_t>(contentsO->size()),
-		.pCode = reinterpret_cast<uint32_t *>(contentsO->data()),
+[[nodiscard]] std::vector<ware::rendererVK::reflection::Module> reflectShaders(const std::vector<ware::rendererVK::shaders::Code> &shaderCodes) {
+	return util::map(shaderCodes, [] (const auto &shaderCode) {
+		return ware::rendererVK::reflection::reflect(shaderCode.words);
 	});
 }
 
-[[nodiscard]] vk::UniquePipeline createPipeline([[maybe_unused]] ware::windowGLFW::State &window, ware::contextVK::State &context, ware::swapchainVK::State &swapchain, vk::PipelineLayout layout) {
-	auto vertexShaderModule = createShaderModule(context, "shaders/simple.vert.spv");
-	auto fragmentShaderModule = createShaderModule(context, "shaders/simple.frag.spv");
+[[nodiscard]] vk::UniquePipeline createPipeline([[maybe_unused]] ware::windowGLFW::State &window, ware::contextVK::State &context, vk::Format colorFormat, vk::Format depthFormat, vk::PipelineLayout layout, const std::vector<ware::rendererVK::shaders::Code> &shaderCodes) {
+	auto vertexShaderModule = ware::rendererVK::shaders::createModule(context, shaderCodes[0]);
+	auto fragmentShaderModule = ware::rendererVK::shaders::createModule(context, shaderCodes[1]);
 
 	std::array stages{
 		vk::PipelineShaderStageCreateInfo{
@@ -236,6 +73,9 @@ const uint32_t samplerMaxCount = 32;
 		.pAttachments = blendAttachmentState.data(),
 	};
 
+	// depth test and write are dynamic
+	vk::PipelineDepthStencilStateCreateInfo depthStencilState{};
+
 	std::array dynamicStates{
 		vk::DynamicState::eBlendConstants,
 		vk::DynamicState::eCullMode,
@@ -268,17 +108,19 @@ const uint32_t samplerMaxCount = 32;
 	};
 
 	std::array colorAttachmentFormats{
-		swapchain.surfaceFormat.format,
+		colorFormat,
 	};
 
 	vk::StructureChain craphicsPipelineCreateInfo{
 		vk::GraphicsPipelineCreateInfo{
+			.flags = ware::contextVK::descriptorHeapPipelineFlags(context),
 			.stageCount = static_cast<uint32_t>(stages.size()),
 			.pStages = stages.data(),
 			.pVertexInputState = &vertexInputState,
 			.pInputAssemblyState = &inputAssemblyState,
 			.pViewportState = &viewportState,
 			.pRasterizationState = &rasterizationState,
+			.pDepthStencilState = &depthStencilState,
 			.pColorBlendState = &colorBlendState,
 			.pDynamicState = &dynamicState,
 			.layout = layout,
@@ -286,6 +128,7 @@ const uint32_t samplerMaxCount = 32;
 		vk::PipelineRenderingCreateInfo{
 			.colorAttachmentCount = static_cast<uint32_t>(colorAttachmentFormats.size()),
 			.pColorAttachmentFormats = colorAttachmentFormats.data(),
+			.depthAttachmentFormat = depthFormat,
 		},
 	};
 
@@ -298,34 +141,15 @@ const uint32_t samplerMaxCount = 32;
 	return std::move(resultValue.value);
 }
 
-[[nodiscard]] std::vector<vk::DescriptorSet> allocateDescriptorSets(ware::contextVK::State &context, vk::DescriptorPool descriptorPool, const std::vector<vk::UniqueDescriptorSetLayout> &descriptorSetLayouts) {
-	std::vector setLayouts = util::map(descriptorSetLayouts, [] (const auto &setLayout) { return setLayout.get(); });
-
-	std::array descriptorCounts{
-		uniformBufferMaxCount,
-		sampledImageMaxCount,
-		storageImageMaxCount,
-		samplerMaxCount,
-	};
-
-	vk::StructureChain descriptorSetsAllocateInfo{
-		vk::DescriptorSetAllocateInfo{
-			.descriptorPool = descriptorPool,
-			.descriptorSetCount = static_cast<uint32_t>(setLayouts.size()),
-			.pSetLayouts = setLayouts.data(),
-		},
-		vk::DescriptorSetVariableDescriptorCountAllocateInfo{
-			.descriptorSetCount = static_cast<uint32_t>(descriptorCounts.size()),
-			.pDescriptorCounts = descriptorCounts.data(),
-		},
+ware::contextVK::UniqueBuffer createVertexBuffer(ware::contextVK::State &context, ware::uploadVK::State &upload) {
+	std::array vertices{
+		 0.0f, -0.5f,
+		 0.5f,  0.5f,
+		-0.5f,  0.5f,
 	};
 
-	return context.device->allocateDescriptorSets(descriptorSetsAllocateInfo.get());
-}
-
-std::tuple<ware::contextVK::UniqueBuffer, ware::contextVK::UniqueBuffer> createBuffers(ware::contextVK::State &context) {
 	vk::BufferCreateInfo vertexBufferCreateInfo{
-		.size = 3 * 2 * sizeof(float),
+		.size = sizeof(vertices),
 		.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
 	};
 	vma::AllocationCreateInfo vertexAllocationCreateInfo{
@@ -334,33 +158,30 @@ std::tuple<ware::contextVK::UniqueBuffer, ware::contextVK::UniqueBuffer> createB
 
 	auto vertexBuffer = ware::contextVK::createBuffer(context, vertexBufferCreateInfo, vertexAllocationCreateInfo);
 
-	vk::BufferCreateInfo stagingBufferCreateInfo{
-		.size = 3 * 2 * sizeof(float),
-		.usage = vk::BufferUsageFlagBits::eTransferSrc,
-	};
-	vma::AllocationCreateInfo stagingAllocationCreateInfo{
-		.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
-		.usage = vma::MemoryUsage::eAutoPreferHost,
-		.requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible,
-	};
-
-	auto stagingBuffer = ware::contextVK::createBuffer(context, stagingBufferCreateInfo, stagingAllocationCreateInfo);
-
-	// upload data to staging buffer
-	std::array vertices{
-		 0.0f, -0.5f,
-		 0.5f,  0.5f,
-		-0.5f,  0.5f,
-	};
-	std::copy_n(vertices.data(), vertices.size(), reinterpret_cast<float *>(stagingBuffer->mappedData));
+	ware::uploadVK::uploadBuffer(upload, std::as_bytes(std::span{vertices}), {
+		.buffer = vertexBuffer->buffer,
+		.offset = 0,
+		.dstStageMask = vk::PipelineStageFlagBits2::eVertexAttributeInput,
+		.dstAccessMask = vk::AccessFlagBits2::eVertexAttributeRead,
+	});
 
-	ware::contextVK::flushMappedData(stagingBuffer);
+	return vertexBuffer;
+}
 
-	return { std::move(vertexBuffer), std::move(stagingBuffer) };
+[[nodiscard]] vk::Sampler createSampler(ware::contextVK::State &context) {
+	return ware::contextVK::getSampler(context, {
+		.magFilter = vk::Filter::eLinear,
+		.minFilter = vk::Filter::eLinear,
+		.mipmapMode = vk::SamplerMipmapMode::eLinear,
+		.addressModeU = vk::SamplerAddressMode::eClampToEdge,
+		.addressModeV = vk::SamplerAddressMode::eClampToEdge,
+		.addressModeW = vk::SamplerAddressMode::eClampToEdge,
+		.borderColor = vk::BorderColor::eFloatOpaqueWhite,
+	});
 }
 
 std::vector<FrameResources> createFrameResources(ware::contextVK::State &context, ware::swapchainVK::State &swapchain) {
-	return util::mapRange(swapchain.frameResources.size(), [&] ([[maybe_unused]] const auto &index) {
+	return util::mapRange(swapchain.framesInFlight, [&] ([[maybe_unused]] const auto &index) {
 		auto renderingCommandPool = context.device->createCommandPoolUnique({
 			.flags = vk::CommandPoolCreateFlagBits::eTransient,
 			.queueFamilyIndex = context.graphicQueueFamily,
@@ -383,10 +204,8 @@ void recreateFrameResources(State &state) {
 	auto &context = state.context;
 	auto &swapchain = state.swapchain;
 
-	if (state.swapchain.description.swapchainResized && state.frameResources.size() != swapchain.frameResources.size()) {
-		ware::contextVK::requestWaitIdle(context);
-
-		state.frameResources.clear();
+	if (state.swapchain.description.swapchainResized && state.frameResources.size() != swapchain.framesInFlight) {
+		ware::contextVK::deferDestroy(context, context.frameValue, std::move(state.frameResources));
 
 		state.frameResources = createFrameResources(context, swapchain);
 	}
@@ -395,7 +214,6 @@ void recreateFrameResources(State &state) {
 vk::CommandBuffer render(State &state) {
 	const auto &context = state.context;
 	const auto &swapchain = state.swapchain;
-	const auto &swapchainImageResources = swapchain.imageResources[swapchain.imageIndex];
 	// const auto &swapchainFrameResources = swapchain.frameResources[swapchain.frameIndex];
 	auto &frameResources = state.frameResources[swapchain.frameIndex];
 
@@ -406,84 +224,19 @@ vk::CommandBuffer render(State &state) {
 
 	auto &cmd = frameResources.renderingCommandBuffer;
 
-	vk::ImageSubresourceRange  swapchainSubresourceRange{
-		.aspectMask = vk::ImageAspectFlagBits::eColor,
-		.baseMipLevel = 0,
-		.levelCount = 1,
-		.baseArrayLayer = 0,
-		.layerCount = 1,
+	vk::CommandBufferInheritanceInfo inheritanceInfo{
+		.pipelineStatistics = ware::rendererVK::profiler::inheritedPipelineStatistics(context),
 	};
-
-	vk::CommandBufferInheritanceInfo inheritanceInfo{};
 	cmd.begin({
 		.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
 		.pInheritanceInfo = &inheritanceInfo,
 	});
 
-	if ( ! state.vertexBufferUploaded) {
-		std::array regions{
-			vk::BufferCopy2{
-				.srcOffset = 0,
-				.dstOffset = 0,
-				.size = state.vertexBuffer.get().size,
-			},
-		};
-
-		cmd.copyBuffer2({
-			.srcBuffer = state.stagingBuffer.get().buffer,
-			.dstBuffer = state.vertexBuffer.get().buffer,
-			.regionCount = static_cast<uint32_t>(regions.size()),
-			.pRegions = regions.data(),
-		});
-
-		std::array bufferMemoryBerries{
-			vk::BufferMemoryBarrier2{
-				.srcStageMask = vk::PipelineStageFlagBits2::eTopOfPipe,
-				.srcAccessMask = vk::AccessFlagBits2::eNone,
-				.dstStageMask = vk::PipelineStageFlagBits2::eVertexInput,
-				.dstAccessMask = vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead,
-				.srcQueueFamilyIndex = context.graphicQueueFamily,
-				.dstQueueFamilyIndex = context.graphicQueueFamily,
-				.buffer = state.vertexBuffer.get().buffer,
-				.offset = 0,
-				.size = state.vertexBuffer.get().size,
-			},
-		};
-
-		cmd.pipelineBarrier2({
-			.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferMemoryBerries.size()),
-			.pBufferMemoryBarriers = bufferMemoryBerries.data(),
-		});
-
-		state.vertexBufferUploaded = true;
-	}
-
+	// the render graph transitions both targets into eAttachmentOptimal ahead of this pass
 	{
-		{
-			std::array imageMemoryBerries{
-				vk::ImageMemoryBarrier2{
-					.srcStageMask = vk::PipelineStageFlagBits2::eTopOfPipe,
-					.srcAccessMask = vk::AccessFlagBits2::eMemoryRead,
-					.dstStageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
-					.dstAccessMask = vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite,
-					.oldLayout = vk::ImageLayout::eUndefined,
-					.newLayout = vk::ImageLayout::eAttachmentOptimal,
-					.srcQueueFamilyIndex = context.presentationQueueFamily,
-					.dstQueueFamilyIndex = context.graphicQueueFamily,
-					.image = swapchainImageResources.image,
-					.subresourceRange = swapchainSubresourceRange,
-				},
-			};
-
-			cmd.pipelineBarrier2({
-				.imageMemoryBarrierCount = static_cast<uint32_t>(imageMemoryBerries.size()),
-				.pImageMemoryBarriers = imageMemoryBerries.data(),
-			});
-		}
-
 		std::array colorAttachments{
 			vk::RenderingAttachmentInfo{
-				.imageView = swapchainImageResources.imageView.get(),
+				.imageView = ware::rendererVK::transient::imageView(state.transient, state.sceneColorTarget),
 				.imageLayout = vk::ImageLayout::eAttachmentOptimal,
 				// .loadOp = vk::AttachmentLoadOp::eClear,
 				.loadOp = vk::AttachmentLoadOp::eDontCare,
@@ -491,17 +244,40 @@ vk::CommandBuffer render(State &state) {
 				// .clearValue = vk::ClearColorValue{std::array<float, 4>{ 1.0f, 1.0f, 1.0f, 0.0f }},
 			},
 		};
+		// never read back, on tiled GPUs it stays in tile memory
+		vk::RenderingAttachmentInfo depthAttachment{
+			.imageView = ware::rendererVK::transient::imageView(state.transient, state.depthTarget),
+			.imageLayout = vk::ImageLayout::eAttachmentOptimal,
+			.loadOp = vk::AttachmentLoadOp::eClear,
+			.storeOp = vk::AttachmentStoreOp::eDontCare,
+			.clearValue = {
+				.depthStencil = {
+					.depth = 1.0f,
+					.stencil = 0,
+				},
+			},
+		};
 
 		cmd.beginRendering(vk::RenderingInfo{
 			.renderArea = vk::Rect2D{ 0, 0, width, height },
 			.layerCount = 1,
 			.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size()),
 			.pColorAttachments = colorAttachments.data(),
+			.pDepthAttachment = &depthAttachment,
 		});
 
-		cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, state.layout.get(), 0, static_cast<uint32_t>(state.descriptorSets.size()), state.descriptorSets.data(), 0, nullptr);
+		ware::contextVK::bindDescriptorHeap(context, cmd, vk::PipelineBindPoint::eGraphics, state.pipelineLayout.layout, ware::rendererVK::reflection::heapSet);
 
 		cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, state.pipeline.get());
+
+		{
+			PushConstant pushConstant{
+				.plasmaImageIndex = state.plasmaImageIndices[swapchain.frameIndex],
+				.samplerIndex = state.samplerDescriptor->index,
+			};
+			cmd.pushConstants(state.pipelineLayout.layout, state.pipelineLayout.pushConstantStages, 0, sizeof(PushConstant), &pushConstant);
+		}
+
 		// set vk::DynamicState::eBlendConstants
 		const float blendConstants[4]{ 0.0f, 0.0f, 0.0f, 0.0f };
 		cmd.setBlendConstants(blendConstants);
@@ -516,11 +292,11 @@ vk::CommandBuffer render(State &state) {
 		// set vk::DynamicState::eDepthBoundsTestEnable
 		cmd.setDepthBoundsTestEnable(false);
 		// set vk::DynamicState::eDepthCompareOp
-		cmd.setDepthCompareOp(vk::CompareOp::eNever);
+		cmd.setDepthCompareOp(vk::CompareOp::eLessOrEqual);
 		// set vk::DynamicState::eDepthTestEnable
-		cmd.setDepthTestEnable(false);
+		cmd.setDepthTestEnable(true);
 		// set vk::DynamicState::eDepthWriteEnable
-		cmd.setDepthWriteEnable(false);
+		cmd.setDepthWriteEnable(true);
 		// set vk::DynamicState::eFrontFace
 		cmd.setFrontFace(vk::FrontFace::eCounterClockwise);
 		// set vk::DynamicState::eLineWidth
@@ -612,22 +388,43 @@ vk::CommandBuffer render(State &state) {
 	return cmd;
 }
 
+std::move_only_function<vk::UniquePipeline()> rebuildPipeline(const State &state) {
+	return [&window = state.window, &context = state.context, &pipelineLayout = state.pipelineLayout, colorFormat = ware::rendererVK::transient::findTarget(state.transient, state.sceneColorTarget).format, depthFormat = ware::rendererVK::transient::findTarget(state.transient, state.depthTarget).format] {
+		auto shaderCodes = ware::rendererVK::shaders::load(shaderFiles, ware::rendererVK::shaders::Source::eOverride);
+
+		ware::rendererVK::reflection::checkLayoutUnchanged(reflectShaders(shaderCodes), pipelineLayout);
+
+		return createPipeline(window, context, colorFormat, depthFormat, pipelineLayout.layout, shaderCodes);
+	};
+}
+
+void replacePipeline(State &state, vk::UniquePipeline &&pipeline) {
+	auto &context = state.context;
+
+	ware::contextVK::deferDestroy(context, context.frameValue, std::exchange(state.pipeline, std::move(pipeline)));
+}
+
 State::~State() {
-	ware::contextVK::requestWaitIdle(context);
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(frameResources), std::move(vertexBuffer), std::move(samplerDescriptor), std::move(pipeline));
 }
 
-State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::swapchainVK::State &swapchain) {
-	auto descriptorPool = createDescriptorPool(context);
+State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::uploadVK::State &upload, ware::swapchainVK::State &swapchain, ware::rendererVK::passes::plasma::State &plasma, const ware::rendererVK::transient::State &transient, graph::ResourceId sceneColorTarget, graph::ResourceId depthTarget) {
+	auto shaderCodes = ware::rendererVK::shaders::load(shaderFiles, ware::rendererVK::shaders::Source::eEmbedded);
 
-	auto descriptorSetLayouts = createDescriptorSetLayouts(context);
+	auto pipelineLayout = ware::rendererVK::reflection::createPipelineLayout(context, reflectShaders(shaderCodes));
+	ware::rendererVK::reflection::checkPushConstantSize(pipelineLayout, sizeof(PushConstant));
 
-	auto layout = createPipelineLayout(context, descriptorSetLayouts);
+	auto pipeline = createPipeline(window, context, ware::rendererVK::transient::findTarget(transient, sceneColorTarget).format, ware::rendererVK::transient::findTarget(transient, depthTarget).format, pipelineLayout.layout, shaderCodes);
 
-	auto pipeline = createPipeline(window, context, swapchain, layout.get());
+	// the plasma images are fixed for the lifetime of its state
+	std::vector plasmaImageIndices = util::mapRange(plasma.frameResources.size(), [&] (size_t index) {
+		return plasma.frameResources[index].sampledImageDescriptor->index;
+	});
 
-	auto descriptorSets = allocateDescriptorSets(context, descriptorPool.get(), descriptorSetLayouts);
+	auto sampler = createSampler(context);
+	auto samplerDescriptor = ware::contextVK::createSamplerDescriptor(context, sampler);
 
-	auto [vertexBuffer, stagingBuffer] = createBuffers(context);
+	auto vertexBuffer = createVertexBuffer(context, upload);
 
 	auto frameResources = createFrameResources(context, swapchain);
 
@@ -635,14 +432,15 @@ State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, wa
 		.window = window,
 		.context = context,
 		.swapchain = swapchain,
-		.descriptorPool = std::move(descriptorPool),
-		.descriptorSetLayouts = std::move(descriptorSetLayouts),
-		.layout = std::move(layout),
+		.transient = transient,
+		.sceneColorTarget = sceneColorTarget,
+		.depthTarget = depthTarget,
+		.pipelineLayout = std::move(pipelineLayout),
 		.pipeline = std::move(pipeline),
-		.descriptorSets = std::move(descriptorSets),
+		.plasmaImageIndices = std::move(plasmaImageIndices),
 		.vertexBuffer = std::move(vertexBuffer),
-		.stagingBuffer = std::move(stagingBuffer),
-		.vertexBufferUploaded = false,
+		.sampler = sampler,
+		.samplerDescriptor = std::move(samplerDescriptor),
 		.frameResources = std::move(frameResources),
 		.description = {
 			.changed = false,
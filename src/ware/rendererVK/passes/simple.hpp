@@ -1,12 +1,22 @@
 #pragma once
 
+#include <array>
+#include <functional>
+#include <string_view>
 #include <vector>
 
 #include "../../contextVK/contextVK.hpp"
 #include "../../swapchainVK/swapchainVK.hpp"
+#include "../../uploadVK/uploadVK.hpp"
+#include "../reflection.hpp"
+#include "../transient.hpp"
+#include "plasma.hpp"
 
 namespace ware::rendererVK::passes::simple {
 
+// file names below shaders/ the pipeline is built from
+const std::array<std::string_view, 2> shaderFiles{ "simple.vert.spv", "simple.frag.spv" };
+
 struct FrameResources {
 	vk::UniqueCommandPool renderingCommandPool;
 	vk::CommandBuffer renderingCommandBuffer;
@@ -20,15 +30,18 @@ struct State {
 	ware::windowGLFW::State &window;
 	ware::contextVK::State &context;
 	ware::swapchainVK::State &swapchain;
+	const ware::rendererVK::transient::State &transient;
+	graph::ResourceId sceneColorTarget;
+	graph::ResourceId depthTarget;
 
-	vk::UniqueDescriptorPool descriptorPool;
-	std::vector<vk::UniqueDescriptorSetLayout> descriptorSetLayouts;
-	vk::UniquePipelineLayout layout;
+	ware::rendererVK::reflection::PipelineLayout pipelineLayout;
 	vk::UniquePipeline pipeline;
-	std::vector<vk::DescriptorSet> descriptorSets;
+	// descriptor heap index of the plasma image by frame slot
+	std::vector<uint32_t> plasmaImageIndices;
 	ware::contextVK::UniqueBuffer vertexBuffer;
-	ware::contextVK::UniqueBuffer stagingBuffer;
-	bool vertexBufferUploaded;
+	// shared through the context cache
+	vk::Sampler sampler;
+	ware::contextVK::UniqueDescriptor samplerDescriptor;
 	std::vector<FrameResources> frameResources;
 
 	Description description;
@@ -36,10 +49,17 @@ struct State {
 	~State();
 };
 
-State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::swapchainVK::State &swapchain);
+State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::uploadVK::State &upload, ware::swapchainVK::State &swapchain, ware::rendererVK::passes::plasma::State &plasma, const ware::rendererVK::transient::State &transient, graph::ResourceId sceneColorTarget, graph::ResourceId depthTarget);
 
 void refresh(State &state);
 
 vk::CommandBuffer process(State &state);
 
+// reads what the pipeline depends on from the state, the returned function builds a replacement from the shader files
+// as they are then, it runs on a worker and no longer touches the state
+[[nodiscard]] std::move_only_function<vk::UniquePipeline()> rebuildPipeline(const State &state);
+
+// the replaced pipeline is destroyed once the frames recorded with it have retired
+void replacePipeline(State &state, vk::UniquePipeline &&pipeline);
+
 } // ware::rendererVK::passes::simple
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+
+namespace ware::rendererVK::passes {
+
+// primary command buffer recorded for the compute queue, the graphic submit of the same frame waits for it at consumerStageMask
+struct ComputeWork {
+	vk::CommandBuffer commandBuffer;
+	vk::PipelineStageFlags2 consumerStageMask;
+};
+
+} // ware::rendererVK::passes
@@ -0,0 +1,262 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <util/map.hpp>
+
+namespace ware::rendererVK::profiler {
+
+const size_t sampleCount = 120;
+
+void readTimestamps(State &state, FrameResources &frameResources) {
+	auto &context = state.context;
+
+	for (uint32_t scope = 0; scope < state.statistics.size(); scope++) {
+		// the scopes of culled passes are never written, their queries would never become available
+		if ((frameResources.timestampScopeMask & (uint64_t{1} << scope)) == 0) {
+			continue;
+		}
+
+		auto [result, timestamps] = context.device->getQueryPoolResults<uint64_t>(frameResources.queryPool.get(), scope * 2, 2, 2 * sizeof(uint64_t), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+		if (result != vk::Result::eSuccess) {
+			spdlog::debug("ware::rendererVK::profiler::readTimestamps() => timestamps not available (result: {})", vk::to_string(result));
+			continue;
+		}
+
+		auto &statistics = state.statistics[scope];
+
+		const auto ticks = (timestamps[1] - timestamps[0]) & state.timestampMask;
+		const Duration duration = std::chrono::duration<double, std::nano>{static_cast<double>(ticks) * state.timestampPeriod};
+
+		statistics.gpuLast = duration;
+		statistics.gpuSamples[statistics.gpuSampleIndex] = duration.count();
+		statistics.gpuSampleIndex = (statistics.gpuSampleIndex + 1) % sampleCount;
+		statistics.gpuSampleCount = std::min(statistics.gpuSampleCount + 1, sampleCount);
+
+		TracyPlot(statistics.plotName.data(), duration.count());
+	}
+}
+
+void readPipelineStatistics(State &state, FrameResources &frameResources) {
+	auto &context = state.context;
+
+	for (uint32_t scope = 0; scope < state.statistics.size(); scope++) {
+		if ((frameResources.statisticsScopeMask & (uint64_t{1} << scope)) == 0) {
+			continue;
+		}
+
+		// one query per scope, results are written in the bit order of pipelineStatisticFlags
+		auto [result, counters] = context.device->getQueryPoolResults<uint64_t>(frameResources.statisticsQueryPool.get(), scope, 1, 4 * sizeof(uint64_t), 4 * sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+		if (result != vk::Result::eSuccess) {
+			spdlog::debug("ware::rendererVK::profiler::readPipelineStatistics() => pipeline statistics not available (result: {})", vk::to_string(result));
+			continue;
+		}
+
+		auto &statistics = state.statistics[scope];
+
+		statistics.hasPipelineStatistics = true;
+		statistics.pipelineStatisticsLast = PipelineStatistics{
+			.vertexShaderInvocations = counters[0],
+			.clippingInvocations = counters[1],
+			.clippingPrimitives = counters[2],
+			.fragmentShaderInvocations = counters[3],
+			.fragmentsPerPixel = frameResources.pixelCount > 0 ? static_cast<double>(counters[3]) / static_cast<double>(frameResources.pixelCount) : 0.0,
+		};
+	}
+}
+
+void readResults(State &state, FrameResources &frameResources) {
+	if ( ! frameResources.written || ! ware::contextVK::isFrameRetired(state.context, frameResources.frameValue)) {
+		return;
+	}
+
+	if (state.supported) {
+		readTimestamps(state, frameResources);
+	}
+
+	if (state.pipelineStatisticsSupported) {
+		readPipelineStatistics(state, frameResources);
+	}
+
+	frameResources.written = false;
+}
+
+void beginFrame(State &state, vk::CommandBuffer cmd) {
+	if ( ! state.supported && ! state.pipelineStatisticsSupported) {
+		return;
+	}
+
+	ZoneScopedN("ware::rendererVK::profiler::beginFrame()");
+
+	auto &frameResources = state.frameResources[state.swapchain.frameIndex];
+
+	readResults(state, frameResources);
+
+	if (state.supported) {
+		cmd.resetQueryPool(frameResources.queryPool.get(), 0, static_cast<uint32_t>(state.statistics.size() * 2));
+	}
+
+	if (state.pipelineStatisticsSupported) {
+		cmd.resetQueryPool(frameResources.statisticsQueryPool.get(), 0, static_cast<uint32_t>(state.statistics.size()));
+	}
+
+	const auto &description = state.swapchain.description;
+
+	frameResources.frameValue = state.context.frameValue;
+	frameResources.pixelCount = static_cast<uint64_t>(description.width) * static_cast<uint64_t>(description.height);
+	frameResources.timestampScopeMask = 0;
+	frameResources.statisticsScopeMask = 0;
+	frameResources.written = true;
+}
+
+void beginScope(State &state, vk::CommandBuffer cmd, uint32_t scope) {
+	if ( ! state.supported) {
+		return;
+	}
+
+	cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, state.frameResources[state.swapchain.frameIndex].queryPool.get(), scope * 2);
+}
+
+void endScope(State &state, vk::CommandBuffer cmd, uint32_t scope) {
+	if ( ! state.supported) {
+		return;
+	}
+
+	auto &frameResources = state.frameResources[state.swapchain.frameIndex];
+
+	cmd.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, frameResources.queryPool.get(), scope * 2 + 1);
+
+	frameResources.timestampScopeMask |= uint64_t{1} << scope;
+}
+
+void beginPipelineStatistics(State &state, vk::CommandBuffer cmd, uint32_t scope) {
+	if ( ! state.pipelineStatisticsSupported) {
+		return;
+	}
+
+	auto &frameResources = state.frameResources[state.swapchain.frameIndex];
+
+	cmd.beginQuery(frameResources.statisticsQueryPool.get(), scope, vk::QueryControlFlags{});
+
+	frameResources.statisticsScopeMask |= uint64_t{1} << scope;
+}
+
+void endPipelineStatistics(State &state, vk::CommandBuffer cmd, uint32_t scope) {
+	if ( ! state.pipelineStatisticsSupported) {
+		return;
+	}
+
+	cmd.endQuery(state.frameResources[state.swapchain.frameIndex].statisticsQueryPool.get(), scope);
+}
+
+vk::QueryPipelineStatisticFlags inheritedPipelineStatistics(const ware::contextVK::State &context) {
+	// the inheritance info may only name pipeline statistics when the feature is enabled
+	return context.hasPipelineStatisticsQuery ? pipelineStatisticFlags : vk::QueryPipelineStatisticFlags{};
+}
+
+void recordCpuTime(State &state, uint32_t scope, Duration duration) {
+	state.statistics[scope].cpuLast = duration;
+}
+
+Summary summarize(const Statistics &statistics) {
+	if (statistics.gpuSampleCount == 0) {
+		return Summary{
+			.average = {},
+			.min = {},
+			.max = {},
+		};
+	}
+
+	const auto begin = statistics.gpuSamples.begin();
+	const auto end = std::next(begin, static_cast<std::ptrdiff_t>(statistics.gpuSampleCount));
+	const auto [min, max] = std::minmax_element(begin, end);
+
+	return Summary{
+		.average = Duration{std::accumulate(begin, end, 0.0) / static_cast<double>(statistics.gpuSampleCount)},
+		.min = Duration{*min},
+		.max = Duration{*max},
+	};
+}
+
+std::vector<FrameResources> createFrameResources(ware::contextVK::State &context, ware::swapchainVK::State &swapchain, uint32_t scopeCount, bool supported, bool pipelineStatisticsSupported) {
+	return util::mapRange(swapchain.framesInFlight, [&] ([[maybe_unused]] const auto &index) {
+		return FrameResources{
+			.queryPool = supported ? context.device->createQueryPoolUnique({
+				.queryType = vk::QueryType::eTimestamp,
+				.queryCount = scopeCount * 2,
+			}) : vk::UniqueQueryPool{},
+			.statisticsQueryPool = pipelineStatisticsSupported ? context.device->createQueryPoolUnique({
+				.queryType = vk::QueryType::ePipelineStatistics,
+				.queryCount = scopeCount,
+				.pipelineStatistics = pipelineStatisticFlags,
+			}) : vk::UniqueQueryPool{},
+			.frameValue = 0,
+			.pixelCount = 0,
+			.timestampScopeMask = 0,
+			.statisticsScopeMask = 0,
+			.written = false,
+		};
+	});
+}
+
+State::~State() {
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(frameResources));
+}
+
+State setup(ware::contextVK::State &context, ware::swapchainVK::State &swapchain, const std::vector<std::string_view> &scopeNames) {
+	const auto timestampValidBits = context.queueFamilyProperties2[context.graphicQueueFamily].queueFamilyProperties.timestampValidBits;
+	const auto timestampPeriod = static_cast<double>(context.physicalDeviceProperties2.properties.limits.timestampPeriod);
+	const bool supported = timestampValidBits > 0 && timestampPeriod > 0.0;
+
+	if ( ! supported) {
+		spdlog::warn("ware::rendererVK::profiler::setup() => timestamps are not supported on the graphic queue family {}, GPU times are not available", context.graphicQueueFamily);
+	}
+
+	const bool pipelineStatisticsSupported = context.hasPipelineStatisticsQuery;
+
+	if ( ! pipelineStatisticsSupported) {
+		spdlog::warn("ware::rendererVK::profiler::setup() => pipeline statistics queries are not supported, pass statistics are not available");
+	}
+
+	if (scopeNames.size() > 64) {
+		throw std::runtime_error{fmt::format("Too many profiler scopes (count: {}, max: 64)", scopeNames.size())};
+	}
+
+	auto statistics = util::map(scopeNames, [] (const auto &scopeName) {
+		return Statistics{
+			.name = std::string{scopeName},
+			.plotName = fmt::format("GPU {} [ms]", scopeName),
+			.gpuSamples = std::vector<double>(sampleCount, 0.0),
+			.gpuSampleIndex = 0,
+			.gpuSampleCount = 0,
+			.gpuLast = {},
+			.cpuLast = {},
+			.hasPipelineStatistics = false,
+			.pipelineStatisticsLast = {},
+		};
+	});
+
+	auto frameResources = supported || pipelineStatisticsSupported ? createFrameResources(context, swapchain, static_cast<uint32_t>(scopeNames.size()), supported, pipelineStatisticsSupported) : std::vector<FrameResources>{};
+
+	return State{
+		.context = context,
+		.swapchain = swapchain,
+		.supported = supported,
+		.pipelineStatisticsSupported = pipelineStatisticsSupported,
+		.timestampPeriod = timestampPeriod,
+		.timestampMask = timestampValidBits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t{1} << timestampValidBits) - 1,
+		.statistics = std::move(statistics),
+		.frameResources = std::move(frameResources),
+	};
+}
+
+} // ware::rendererVK::profiler
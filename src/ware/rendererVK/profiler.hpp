@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../contextVK/contextVK.hpp"
+#include "../swapchainVK/swapchainVK.hpp"
+
+namespace ware::rendererVK::profiler {
+
+using Duration = std::chrono::duration<double, std::milli>;
+
+// counters the pipeline statistics queries gather, in the order Vulkan writes them
+inline constexpr vk::QueryPipelineStatisticFlags pipelineStatisticFlags = vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations | vk::QueryPipelineStatisticFlagBits::eClippingInvocations | vk::QueryPipelineStatisticFlagBits::eClippingPrimitives | vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations;
+
+struct PipelineStatistics {
+	uint64_t vertexShaderInvocations;
+	uint64_t clippingInvocations;
+	uint64_t clippingPrimitives;
+	uint64_t fragmentShaderInvocations;
+	// fragment shader invocations per pixel of the render area, above 1 means overdraw
+	double fragmentsPerPixel;
+};
+
+// rolling window over the last sampleCount frames
+struct Statistics {
+	std::string name;
+	std::string plotName;
+	std::vector<double> gpuSamples;
+	size_t gpuSampleIndex;
+	size_t gpuSampleCount;
+	Duration gpuLast;
+	Duration cpuLast;
+	bool hasPipelineStatistics;
+	PipelineStatistics pipelineStatisticsLast;
+};
+
+struct FrameResources {
+	vk::UniqueQueryPool queryPool;
+	vk::UniqueQueryPool statisticsQueryPool;
+	uint64_t frameValue;
+	uint64_t pixelCount;
+	// bit i is set when both timestamps of scope i were written in this frame
+	uint64_t timestampScopeMask;
+	// bit i is set when scope i gathered pipeline statistics in this frame
+	uint64_t statisticsScopeMask;
+	bool written;
+};
+
+struct State {
+	ware::contextVK::State &context;
+	ware::swapchainVK::State &swapchain;
+	bool supported;
+	bool pipelineStatisticsSupported;
+	double timestampPeriod;
+	uint64_t timestampMask;
+	std::vector<Statistics> statistics;
+	std::vector<FrameResources> frameResources;
+
+	~State();
+};
+
+struct Summary {
+	Duration average;
+	Duration min;
+	Duration max;
+};
+
+// reads back the timestamps and pipeline statistics the current frame slot wrote framesInFlight frames ago, if they are available, and resets its queries
+void beginFrame(State &state, vk::CommandBuffer cmd);
+
+// scope i is bracketed by the timestamp queries 2i and 2i+1
+void beginScope(State &state, vk::CommandBuffer cmd, uint32_t scope);
+void endScope(State &state, vk::CommandBuffer cmd, uint32_t scope);
+
+// pipeline statistics queries can not nest, only one scope may gather them at a time
+void beginPipelineStatistics(State &state, vk::CommandBuffer cmd, uint32_t scope);
+void endPipelineStatistics(State &state, vk::CommandBuffer cmd, uint32_t scope);
+
+// secondary command buffers executed while pipeline statistics are gathered have to inherit them
+vk::QueryPipelineStatisticFlags inheritedPipelineStatistics(const ware::contextVK::State &context);
+
+void recordCpuTime(State &state, uint32_t scope, Duration duration);
+
+Summary summarize(const Statistics &statistics);
+
+State setup(ware::contextVK::State &context, ware::swapchainVK::State &swapchain, const std::vector<std::string_view> &scopeNames);
+
+} // ware::rendererVK::profiler
@@ -0,0 +1,650 @@
+#include "reflection.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include <fmt/format.h>
+
+#include <util/map.hpp>
+
+namespace ware::rendererVK::reflection {
+
+// the subset of the SPIR-V specification reflection needs
+const uint32_t spirvMagic = 0x07230203;
+const size_t spirvHeaderSize = 5;
+
+enum class Op : uint32_t {
+	EntryPoint = 15,
+	TypeBool = 20,
+	TypeInt = 21,
+	TypeFloat = 22,
+	TypeVector = 23,
+	TypeMatrix = 24,
+	TypeImage = 25,
+	TypeSampler = 26,
+	TypeSampledImage = 27,
+	TypeArray = 28,
+	TypeRuntimeArray = 29,
+	TypeStruct = 30,
+	TypePointer = 32,
+	Constant = 43,
+	Variable = 59,
+	Decorate = 71,
+	MemberDecorate = 72,
+	TypeAccelerationStructureKHR = 5341,
+};
+
+enum class Decoration : uint32_t {
+	Block = 2,
+	BufferBlock = 3,
+	ArrayStride = 6,
+	MatrixStride = 7,
+	BuiltIn = 11,
+	Location = 30,
+	Binding = 33,
+	DescriptorSet = 34,
+	Offset = 35,
+};
+
+enum class StorageClass : uint32_t {
+	UniformConstant = 0,
+	Input = 1,
+	Uniform = 2,
+	PushConstant = 9,
+	StorageBuffer = 12,
+};
+
+const uint32_t dimBuffer = 5;
+const uint32_t dimSubpassData = 6;
+const uint32_t imageSampledStorage = 2;
+
+struct Decorations {
+	std::optional<uint32_t> set;
+	std::optional<uint32_t> binding;
+	std::optional<uint32_t> location;
+	bool builtIn;
+	bool block;
+	bool bufferBlock;
+	uint32_t arrayStride;
+};
+
+struct MemberDecorations {
+	uint32_t offset;
+	uint32_t matrixStride;
+	bool builtIn;
+};
+
+struct Variable {
+	uint32_t id;
+	uint32_t pointerType;
+	StorageClass storageClass;
+};
+
+// everything is keyed by result id, the operands are kept as the words that follow it
+struct Parsed {
+	std::optional<vk::ShaderStageFlagBits> stage;
+	std::unordered_map<uint32_t, std::pair<Op, std::vector<uint32_t>>> types;
+	std::unordered_map<uint32_t, uint32_t> constants;
+	std::unordered_map<uint32_t, Decorations> decorations;
+	std::unordered_map<uint32_t, std::vector<MemberDecorations>> memberDecorations;
+	std::vector<Variable> variables;
+};
+
+[[nodiscard]] vk::ShaderStageFlagBits stageFromExecutionModel(uint32_t executionModel) {
+	switch (executionModel) {
+		case 0: return vk::ShaderStageFlagBits::eVertex;
+		case 1: return vk::ShaderStageFlagBits::eTessellationControl;
+		case 2: return vk::ShaderStageFlagBits::eTessellationEvaluation;
+		case 3: return vk::ShaderStageFlagBits::eGeometry;
+		case 4: return vk::ShaderStageFlagBits::eFragment;
+		case 5: return vk::ShaderStageFlagBits::eCompute;
+		case 5364: return vk::ShaderStageFlagBits::eTaskEXT;
+		case 5365: return vk::ShaderStageFlagBits::eMeshEXT;
+	}
+
+	throw std::runtime_error{fmt::format("Unsupported SPIR-V execution model {}", executionModel)};
+}
+
+[[nodiscard]] Parsed parse(std::span<const uint32_t> code) {
+	if (code.size() < spirvHeaderSize || code[0] != spirvMagic) {
+		throw std::runtime_error{"Not a SPIR-V module"};
+	}
+
+	Parsed parsed{};
+
+	for (size_t i = spirvHeaderSize; i < code.size();) {
+		const uint32_t wordCount = code[i] >> 16;
+		const auto op = static_cast<Op>(code[i] & 0xffff);
+
+		if (wordCount == 0 || i + wordCount > code.size()) {
+			throw std::runtime_error{fmt::format("SPIR-V module is corrupted at word {}", i)};
+		}
+
+		const auto operands = code.subspan(i + 1, wordCount - 1);
+		i += wordCount;
+
+		switch (op) {
+			case Op::EntryPoint:
+				// modules with several entry points are reflected as the first
+				if ( ! parsed.stage) {
+					parsed.stage = stageFromExecutionModel(operands[0]);
+				}
+				break;
+			case Op::TypeBool:
+			case Op::TypeInt:
+			case Op::TypeFloat:
+			case Op::TypeVector:
+			case Op::TypeMatrix:
+			case Op::TypeImage:
+			case Op::TypeSampler:
+			case Op::TypeSampledImage:
+			case Op::TypeArray:
+			case Op::TypeRuntimeArray:
+			case Op::TypeStruct:
+			case Op::TypePointer:
+			case Op::TypeAccelerationStructureKHR:
+				parsed.types[operands[0]] = { op, std::vector<uint32_t>(operands.begin() + 1, operands.end()) };
+				break;
+			case Op::Constant:
+				parsed.constants[operands[1]] = operands[2];
+				break;
+			case Op::Variable:
+				parsed.variables.push_back(Variable{
+					.id = operands[1],
+					.pointerType = operands[0],
+					.storageClass = static_cast<StorageClass>(operands[2]),
+				});
+				break;
+			case Op::Decorate: {
+				auto &decorations = parsed.decorations[operands[0]];
+
+				switch (static_cast<Decoration>(operands[1])) {
+					case Decoration::Block: decorations.block = true; break;
+					case Decoration::BufferBlock: decorations.bufferBlock = true; break;
+					case Decoration::ArrayStride: decorations.arrayStride = operands[2]; break;
+					case Decoration::BuiltIn: decorations.builtIn = true; break;
+					case Decoration::Location: decorations.location = operands[2]; break;
+					case Decoration::Binding: decorations.binding = operands[2]; break;
+					case Decoration::DescriptorSet: decorations.set = operands[2]; break;
+					default: break;
+				}
+				break;
+			}
+			case Op::MemberDecorate: {
+				auto &members = parsed.memberDecorations[operands[0]];
+				if (members.size() <= operands[1]) {
+					members.resize(operands[1] + 1);
+				}
+				auto &decorations = members[operands[1]];
+
+				switch (static_cast<Decoration>(operands[2])) {
+					case Decoration::Offset: decorations.offset = operands[3]; break;
+					case Decoration::MatrixStride: decorations.matrixStride = operands[3]; break;
+					case Decoration::BuiltIn: decorations.builtIn = true; break;
+					default: break;
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	if ( ! parsed.stage) {
+		throw std::runtime_error{"SPIR-V module has no entry point"};
+	}
+
+	return parsed;
+}
+
+[[nodiscard]] const std::pair<Op, std::vector<uint32_t>> & findType(const Parsed &parsed, uint32_t typeId) {
+	auto type = parsed.types.find(typeId);
+
+	if (type == parsed.types.end()) {
+		throw std::runtime_error{fmt::format("SPIR-V type %{} is not declared", typeId)};
+	}
+
+	return type->second;
+}
+
+[[nodiscard]] uint32_t findConstant(const Parsed &parsed, uint32_t constantId) {
+	auto constant = parsed.constants.find(constantId);
+
+	if (constant == parsed.constants.end()) {
+		throw std::runtime_error{fmt::format("SPIR-V array length %{} is not a constant", constantId)};
+	}
+
+	return constant->second;
+}
+
+[[nodiscard]] uint32_t typeSize(const Parsed &parsed, uint32_t typeId, uint32_t matrixStride = 0) {
+	const auto &[op, operands] = findType(parsed, typeId);
+
+	switch (op) {
+		case Op::TypeInt:
+		case Op::TypeFloat:
+			return operands[0] / 8;
+		case Op::TypeVector:
+			return operands[1] * typeSize(parsed, operands[0]);
+		case Op::TypeMatrix:
+			return operands[1] * (matrixStride != 0 ? matrixStride : typeSize(parsed, operands[0]));
+		case Op::TypeArray: {
+			auto decorations = parsed.decorations.find(typeId);
+			const uint32_t arrayStride = decorations != parsed.decorations.end() ? decorations->second.arrayStride : 0;
+
+			return findConstant(parsed, operands[1]) * (arrayStride != 0 ? arrayStride : typeSize(parsed, operands[0]));
+		}
+		case Op::TypeStruct: {
+			auto members = parsed.memberDecorations.find(typeId);
+			uint32_t size = 0;
+
+			for (size_t i = 0; i < operands.size(); i++) {
+				const bool decorated = members != parsed.memberDecorations.end() && i < members->second.size();
+				const auto offset = decorated ? members->second[i].offset : 0;
+				const auto memberMatrixStride = decorated ? members->second[i].matrixStride : 0;
+
+				size = std::max(size, offset + typeSize(parsed, operands[i], memberMatrixStride));
+			}
+
+			return size;
+		}
+		default:
+			throw std::runtime_error{fmt::format("SPIR-V type %{} has no size known to reflection", typeId)};
+	}
+}
+
+[[nodiscard]] vk::DescriptorType descriptorType(const Parsed &parsed, uint32_t typeId, StorageClass storageClass) {
+	const auto &[op, operands] = findType(parsed, typeId);
+
+	switch (op) {
+		case Op::TypeSampler:
+			return vk::DescriptorType::eSampler;
+		case Op::TypeSampledImage:
+			return vk::DescriptorType::eCombinedImageSampler;
+		case Op::TypeImage:
+			// operands: sampled type, dim, depth, arrayed, multisampled, sampled, format
+			if (operands[1] == dimBuffer) {
+				return operands[5] == imageSampledStorage ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+			}
+			if (operands[1] == dimSubpassData) {
+				return vk::DescriptorType::eInputAttachment;
+			}
+			return operands[5] == imageSampledStorage ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+		case Op::TypeAccelerationStructureKHR:
+			return vk::DescriptorType::eAccelerationStructureKHR;
+		case Op::TypeStruct: {
+			auto decorations = parsed.decorations.find(typeId);
+			const bool bufferBlock = decorations != parsed.decorations.end() && decorations->second.bufferBlock;
+
+			if (storageClass == StorageClass::StorageBuffer || bufferBlock) {
+				return vk::DescriptorType::eStorageBuffer;
+			}
+			return vk::DescriptorType::eUniformBuffer;
+		}
+		default:
+			throw std::runtime_error{fmt::format("SPIR-V type %{} is no descriptor type known to reflection", typeId)};
+	}
+}
+
+[[nodiscard]] Binding reflectBinding(const Parsed &parsed, const Variable &variable, const Decorations &decorations) {
+	uint32_t typeId = findType(parsed, variable.pointerType).second[1];
+	uint32_t descriptorCount = 1;
+
+	// arrays of arrays are not allowed for descriptors, one level is all there is
+	const auto &[op, operands] = findType(parsed, typeId);
+	if (op == Op::TypeArray) {
+		descriptorCount = findConstant(parsed, operands[1]);
+		typeId = operands[0];
+	} else if (op == Op::TypeRuntimeArray) {
+		descriptorCount = 0;
+		typeId = operands[0];
+	}
+
+	return Binding{
+		.set = decorations.set.value_or(0),
+		.binding = decorations.binding.value_or(0),
+		.descriptorType = descriptorType(parsed, typeId, variable.storageClass),
+		.descriptorCount = descriptorCount,
+		.stageFlags = *parsed.stage,
+	};
+}
+
+[[nodiscard]] vk::Format vertexInputFormat(const Parsed &parsed, uint32_t typeId) {
+	const auto *type = &findType(parsed, typeId);
+	uint32_t componentCount = 1;
+
+	if (type->first == Op::TypeVector) {
+		componentCount = type->second[1];
+		type = &findType(parsed, type->second[0]);
+	}
+
+	const auto &[op, operands] = *type;
+
+	// operands: width, signedness for integers
+	if (componentCount > 4 || operands[0] != 32 || (op != Op::TypeFloat && op != Op::TypeInt)) {
+		return vk::Format::eUndefined;
+	}
+
+	const std::array floatFormats{ vk::Format::eR32Sfloat, vk::Format::eR32G32Sfloat, vk::Format::eR32G32B32Sfloat, vk::Format::eR32G32B32A32Sfloat };
+	const std::array sintFormats{ vk::Format::eR32Sint, vk::Format::eR32G32Sint, vk::Format::eR32G32B32Sint, vk::Format::eR32G32B32A32Sint };
+	const std::array uintFormats{ vk::Format::eR32Uint, vk::Format::eR32G32Uint, vk::Format::eR32G32B32Uint, vk::Format::eR32G32B32A32Uint };
+
+	if (op == Op::TypeFloat) {
+		return floatFormats[componentCount - 1];
+	}
+	return operands[1] != 0 ? sintFormats[componentCount - 1] : uintFormats[componentCount - 1];
+}
+
+Module reflect(std::span<const uint32_t> code) {
+	const auto parsed = parse(code);
+
+	Module module{
+		.stage = *parsed.stage,
+		.bindings = {},
+		.pushConstantSize = 0,
+		.vertexInputs = {},
+	};
+
+	for (const auto &variable : parsed.variables) {
+		auto decorationsIt = parsed.decorations.find(variable.id);
+		const auto decorations = decorationsIt != parsed.decorations.end() ? decorationsIt->second : Decorations{};
+
+		switch (variable.storageClass) {
+			case StorageClass::UniformConstant:
+			case StorageClass::Uniform:
+			case StorageClass::StorageBuffer:
+				module.bindings.push_back(reflectBinding(parsed, variable, decorations));
+				break;
+			case StorageClass::PushConstant:
+				module.pushConstantSize = typeSize(parsed, findType(parsed, variable.pointerType).second[1]);
+				break;
+			case StorageClass::Input:
+				if (module.stage == vk::ShaderStageFlagBits::eVertex && ! decorations.builtIn && decorations.location) {
+					module.vertexInputs.push_back(VertexInput{
+						.location = *decorations.location,
+						.format = vertexInputFormat(parsed, findType(parsed, variable.pointerType).second[1]),
+					});
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	std::sort(module.bindings.begin(), module.bindings.end(), [] (const auto &a, const auto &b) {
+		return std::tie(a.set, a.binding) < std::tie(b.set, b.binding);
+	});
+	std::sort(module.vertexInputs.begin(), module.vertexInputs.end(), [] (const auto &a, const auto &b) {
+		return a.location < b.location;
+	});
+
+	return module;
+}
+
+[[nodiscard]] std::vector<Binding> mergeBindings(std::span<const Module> modules) {
+	std::vector<Binding> bindings{};
+
+	for (const auto &module : modules) {
+		for (const auto &binding : module.bindings) {
+			auto merged = std::find_if(bindings.begin(), bindings.end(), [&] (const auto &other) {
+				return other.set == binding.set && other.binding == binding.binding;
+			});
+
+			if (merged == bindings.end()) {
+				bindings.push_back(binding);
+
+				continue;
+			}
+
+			if (merged->descriptorType != binding.descriptorType || merged->descriptorCount != binding.descriptorCount) {
+				throw std::runtime_error{fmt::format("Binding {} of set {} is declared differently by two stages", binding.binding, binding.set)};
+			}
+
+			merged->stageFlags |= binding.stageFlags;
+		}
+	}
+
+	std::sort(bindings.begin(), bindings.end(), [] (const auto &a, const auto &b) {
+		return std::tie(a.set, a.binding) < std::tie(b.set, b.binding);
+	});
+
+	return bindings;
+}
+
+[[nodiscard]] ware::contextVK::DescriptorSetLayoutDescription describeSetLayout(std::span<const Binding> bindings, uint32_t set, uint32_t runtimeArrayMaxCount) {
+	ware::contextVK::DescriptorSetLayoutDescription description{
+		.flags = {},
+		.bindings = {},
+		.bindingFlags = {},
+	};
+
+	for (const auto &binding : bindings) {
+		if (binding.set != set) {
+			continue;
+		}
+
+		const bool runtimeArray = binding.descriptorCount == 0;
+
+		if (runtimeArray && runtimeArrayMaxCount == 0) {
+			throw std::runtime_error{fmt::format("Binding {} of set {} is a runtime array, but the pipeline allows none", binding.binding, set)};
+		}
+
+		if (runtimeArray && &binding != &bindings.back() && std::next(&binding)->set == set) {
+			throw std::runtime_error{fmt::format("Binding {} of set {} is a runtime array, but not the last binding of its set", binding.binding, set)};
+		}
+
+		description.bindings.push_back(vk::DescriptorSetLayoutBinding{
+			.binding = binding.binding,
+			.descriptorType = binding.descriptorType,
+			.descriptorCount = runtimeArray ? runtimeArrayMaxCount : binding.descriptorCount,
+			.stageFlags = binding.stageFlags,
+			.pImmutableSamplers = nullptr,
+		});
+		description.bindingFlags.push_back(runtimeArray ? vk::DescriptorBindingFlagBits::ePartiallyBound | vk::DescriptorBindingFlagBits::eVariableDescriptorCount | vk::DescriptorBindingFlagBits::eUpdateAfterBind : vk::DescriptorBindingFlags{});
+
+		if (runtimeArray) {
+			description.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+		}
+	}
+
+	return description;
+}
+
+void checkHeapBinding(const Binding &binding) {
+	const auto &heapDescriptorTypes = ware::contextVK::heapDescriptorTypes;
+
+	if (binding.binding >= heapDescriptorTypes.size() || binding.descriptorType != heapDescriptorTypes[binding.binding]) {
+		throw std::runtime_error{fmt::format("Binding {} of set {} ({}) is not a binding of the descriptor heap", binding.binding, binding.set, vk::to_string(binding.descriptorType))};
+	}
+
+	if (binding.descriptorCount != 0) {
+		throw std::runtime_error{fmt::format("Binding {} of set {} has to be declared as a runtime array, like the descriptor heap", binding.binding, binding.set)};
+	}
+}
+
+[[nodiscard]] std::tuple<vk::ShaderStageFlags, uint32_t> mergePushConstants(std::span<const Module> modules) {
+	vk::ShaderStageFlags pushConstantStages{};
+	uint32_t pushConstantSize = 0;
+
+	for (const auto &module : modules) {
+		if (module.pushConstantSize > 0) {
+			pushConstantStages |= module.stage;
+			pushConstantSize = std::max(pushConstantSize, module.pushConstantSize);
+		}
+	}
+
+	return { pushConstantStages, pushConstantSize };
+}
+
+PipelineLayout createPipelineLayout(ware::contextVK::State &context, std::span<const Module> modules, uint32_t runtimeArrayMaxCount) {
+	auto bindings = mergeBindings(modules);
+
+	for (const auto &binding : bindings) {
+		if (binding.set == heapSet) {
+			checkHeapBinding(binding);
+		} else if (context.descriptorHeap.descriptorBuffer) {
+			// a pipeline created for descriptor buffers binds no set from a pool at all
+			throw std::runtime_error{fmt::format("Binding {} of set {} is outside the descriptor heap, that needs --descriptor-pool", binding.binding, binding.set)};
+		}
+	}
+
+	const auto [pushConstantStages, pushConstantSize] = mergePushConstants(modules);
+
+	// the heap set is there even for shaders that do not use it, so that it stays bound across pipelines
+	const size_t setCount = std::max<size_t>(heapSet + 1, bindings.empty() ? 0 : bindings.back().set + 1);
+
+	std::vector setLayouts = util::mapRange(setCount, [&] (size_t set) {
+		if (set == heapSet) {
+			return context.descriptorHeap.setLayout.get();
+		}
+
+		return ware::contextVK::getDescriptorSetLayout(context, describeSetLayout(bindings, static_cast<uint32_t>(set), runtimeArrayMaxCount));
+	});
+
+	// one range for all stages, a stage may not appear in two ranges anyway
+	std::vector<vk::PushConstantRange> pushConstantRanges{};
+	if (pushConstantSize > 0) {
+		pushConstantRanges.push_back(vk::PushConstantRange{
+			.stageFlags = pushConstantStages,
+			.offset = 0,
+			.size = (pushConstantSize + 3) / 4 * 4,
+		});
+	}
+
+	auto layout = ware::contextVK::getPipelineLayout(context, {
+		.setLayouts = setLayouts,
+		.pushConstantRanges = pushConstantRanges,
+	});
+
+	return PipelineLayout{
+		.bindings = std::move(bindings),
+		.setLayouts = std::move(setLayouts),
+		.layout = layout,
+		.pushConstantStages = pushConstantStages,
+		.pushConstantSize = pushConstantSize,
+	};
+}
+
+[[nodiscard]] uint32_t runtimeArrayCount(std::span<const uint32_t> runtimeArrayCounts, uint32_t set) {
+	if (set >= runtimeArrayCounts.size()) {
+		throw std::runtime_error{fmt::format("No size given for the runtime array of set {}", set)};
+	}
+
+	return runtimeArrayCounts[set];
+}
+
+vk::UniqueDescriptorPool createDescriptorPool(ware::contextVK::State &context, const PipelineLayout &pipelineLayout, uint32_t copyCount, std::span<const uint32_t> runtimeArrayCounts) {
+	std::vector<vk::DescriptorPoolSize> poolSizes{};
+	bool updateAfterBind = false;
+
+	for (const auto &binding : pipelineLayout.bindings) {
+		if (binding.set == heapSet) {
+			continue;
+		}
+
+		const bool runtimeArray = binding.descriptorCount == 0;
+		const uint32_t descriptorCount = copyCount * (runtimeArray ? runtimeArrayCount(runtimeArrayCounts, binding.set) : binding.descriptorCount);
+
+		updateAfterBind = updateAfterBind || runtimeArray;
+
+		if (descriptorCount == 0) {
+			continue;
+		}
+
+		auto poolSize = std::find_if(poolSizes.begin(), poolSizes.end(), [&] (const auto &other) {
+			return other.type == binding.descriptorType;
+		});
+
+		if (poolSize == poolSizes.end()) {
+			poolSizes.push_back(vk::DescriptorPoolSize{
+				.type = binding.descriptorType,
+				.descriptorCount = descriptorCount,
+			});
+		} else {
+			poolSize->descriptorCount += descriptorCount;
+		}
+	}
+
+	return context.device->createDescriptorPoolUnique({
+		.flags = updateAfterBind ? vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind : vk::DescriptorPoolCreateFlags{},
+		.maxSets = copyCount * static_cast<uint32_t>(pipelineLayout.setLayouts.size() - 1),
+		.poolSizeCount = static_cast<uint32_t>(poolSizes.size()),
+		.pPoolSizes = poolSizes.data(),
+	});
+}
+
+std::vector<vk::DescriptorSet> allocateDescriptorSets(ware::contextVK::State &context, const PipelineLayout &pipelineLayout, vk::DescriptorPool descriptorPool, std::span<const uint32_t> runtimeArrayCounts) {
+	std::vector<vk::DescriptorSetLayout> setLayouts{};
+	// sets without a runtime array ignore their count
+	std::vector<uint32_t> descriptorCounts{};
+
+	for (uint32_t set = 0; set < pipelineLayout.setLayouts.size(); set++) {
+		if (set == heapSet) {
+			continue;
+		}
+
+		const bool hasRuntimeArray = std::any_of(pipelineLayout.bindings.begin(), pipelineLayout.bindings.end(), [&] (const auto &binding) {
+			return binding.set == set && binding.descriptorCount == 0;
+		});
+
+		setLayouts.push_back(pipelineLayout.setLayouts[set]);
+		descriptorCounts.push_back(hasRuntimeArray ? runtimeArrayCount(runtimeArrayCounts, set) : 0);
+	}
+
+	vk::StructureChain descriptorSetsAllocateInfo{
+		vk::DescriptorSetAllocateInfo{
+			.descriptorPool = descriptorPool,
+			.descriptorSetCount = static_cast<uint32_t>(setLayouts.size()),
+			.pSetLayouts = setLayouts.data(),
+		},
+		vk::DescriptorSetVariableDescriptorCountAllocateInfo{
+			.descriptorSetCount = static_cast<uint32_t>(descriptorCounts.size()),
+			.pDescriptorCounts = descriptorCounts.data(),
+		},
+	};
+
+	std::vector<vk::DescriptorSet> descriptorSets = context.device->allocateDescriptorSets(descriptorSetsAllocateInfo.get());
+	descriptorSets.insert(descriptorSets.begin() + heapSet, context.descriptorHeap.descriptorSet);
+
+	return descriptorSets;
+}
+
+void checkLayoutUnchanged(std::span<const Module> modules, const PipelineLayout &pipelineLayout) {
+	// compared on the reflected interface, creating a layout to compare handles would leave it in the context caches
+	const auto bindings = mergeBindings(modules);
+	const auto [pushConstantStages, pushConstantSize] = mergePushConstants(modules);
+
+	const bool bindingsUnchanged = std::equal(bindings.begin(), bindings.end(), pipelineLayout.bindings.begin(), pipelineLayout.bindings.end(), [] (const auto &a, const auto &b) {
+		return std::tie(a.set, a.binding, a.descriptorType, a.descriptorCount, a.stageFlags) == std::tie(b.set, b.binding, b.descriptorType, b.descriptorCount, b.stageFlags);
+	});
+
+	if ( ! bindingsUnchanged || pushConstantStages != pipelineLayout.pushConstantStages || pushConstantSize != pipelineLayout.pushConstantSize) {
+		throw std::runtime_error{"The descriptor sets or push constants of the shaders changed, that needs a restart"};
+	}
+}
+
+void checkPushConstantSize(const PipelineLayout &pipelineLayout, size_t size) {
+	if (pipelineLayout.pushConstantSize != size) {
+		throw std::runtime_error{fmt::format("The push constant block of the shaders has {} bytes, the pass pushes {}", pipelineLayout.pushConstantSize, size)};
+	}
+}
+
+void checkVertexInputs(const Module &module, std::span<const vk::VertexInputAttributeDescription> attributes) {
+	for (const auto &vertexInput : module.vertexInputs) {
+		const bool provided = std::any_of(attributes.begin(), attributes.end(), [&] (const auto &attribute) {
+			return attribute.location == vertexInput.location;
+		});
+
+		if ( ! provided) {
+			throw std::runtime_error{fmt::format("The vertex shader reads location {} ({}), but no vertex attribute provides it", vertexInput.location, vk::to_string(vertexInput.format))};
+		}
+	}
+}
+
+} // ware::rendererVK::reflection
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "../contextVK/contextVK.hpp"
+
+namespace ware::rendererVK::reflection {
+
+// every pipeline layout has the descriptor heap of the context at this set, shaders declare its bindings as runtime arrays
+const uint32_t heapSet = 0;
+
+struct Binding {
+	uint32_t set;
+	uint32_t binding;
+	vk::DescriptorType descriptorType;
+	// 0 for a runtime array, its size is chosen when the set is allocated
+	uint32_t descriptorCount;
+	vk::ShaderStageFlags stageFlags;
+};
+
+struct VertexInput {
+	uint32_t location;
+	vk::Format format;
+};
+
+// the resource interface of one SPIR-V module
+struct Module {
+	vk::ShaderStageFlagBits stage;
+	std::vector<Binding> bindings;
+	// size of the push constant block, 0 without one
+	uint32_t pushConstantSize;
+	// only filled for vertex shaders
+	std::vector<VertexInput> vertexInputs;
+};
+
+// the handles are shared with every other pipeline of the same interface, contextVK owns them
+struct PipelineLayout {
+	// merged over all stages, sorted by set and binding
+	std::vector<Binding> bindings;
+	// one per set up to the highest one used, sets in between get an empty layout
+	std::vector<vk::DescriptorSetLayout> setLayouts;
+	vk::PipelineLayout layout;
+	// what vkCmdPushConstants() has to be called with, empty without push constants
+	vk::ShaderStageFlags pushConstantStages;
+	uint32_t pushConstantSize;
+};
+
+[[nodiscard]] Module reflect(std::span<const uint32_t> code);
+
+// runtime arrays outside the heap set become bindless bindings of up to runtimeArrayMaxCount descriptors, they have to be the last binding of their set
+[[nodiscard]] PipelineLayout createPipelineLayout(ware::contextVK::State &context, std::span<const Module> modules, uint32_t runtimeArrayMaxCount = 0);
+
+// room for copyCount sets of each set layout but the heap, runtimeArrayCounts holds the size the runtime array of a set is allocated with by set index
+[[nodiscard]] vk::UniqueDescriptorPool createDescriptorPool(ware::contextVK::State &context, const PipelineLayout &pipelineLayout, uint32_t copyCount, std::span<const uint32_t> runtimeArrayCounts = {});
+
+// one set of each set layout, the heap set is the one of the context
+[[nodiscard]] std::vector<vk::DescriptorSet> allocateDescriptorSets(ware::contextVK::State &context, const PipelineLayout &pipelineLayout, vk::DescriptorPool descriptorPool, std::span<const uint32_t> runtimeArrayCounts = {});
+
+// for rebuilding a pipeline into its existing layout, throws when the shaders need another one by now
+void checkLayoutUnchanged(std::span<const Module> modules, const PipelineLayout &pipelineLayout);
+
+// throws when the push constant block of the shaders differs in size from what the pass pushes
+void checkPushConstantSize(const PipelineLayout &pipelineLayout, size_t size);
+
+// throws when the shader reads a location none of the attributes provides
+void checkVertexInputs(const Module &module, std::span<const vk::VertexInputAttributeDescription> attributes);
+
+} // ware::rendererVK::reflection
@@ -1,13 +1,178 @@
 #include "rendererVK.hpp"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <numeric>
+#include <vector>
+
+#include <spdlog/spdlog.h>
 #include <tracy/Tracy.hpp>
 
 #include <util/map.hpp>
 
 namespace ware::rendererVK {
 
+enum ProfilerScope : uint32_t {
+	Frame = 0,
+	Simple = 1,
+	Imgui = 2,
+	Composite = 3,
+};
+
+// declaration order in createGraph()
+enum GraphResource : graph::ResourceId {
+	SwapchainImage = 0,
+	SceneColor = 1,
+	SceneDepth = 2,
+	UiLayer = 3,
+};
+
+enum GraphPass : graph::PassId {
+	SimplePass = 0,
+	ImguiPass = 1,
+	CompositePass = 2,
+};
+
+const std::array<ProfilerScope, 3> graphPassScopes{
+	ProfilerScope::Simple,
+	ProfilerScope::Imgui,
+	ProfilerScope::Composite,
+};
+
+graph::State createGraph(ware::swapchainVK::State &swapchain, transient::State &transientState) {
+	auto graphState = graph::setup();
+
+	graph::addImage(graphState, graph::Image{
+		.name = "swapchain image",
+		.image = vk::Image{},
+		.subresourceRange = {
+			.aspectMask = vk::ImageAspectFlagBits::eColor,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+		// the acquire semaphore is waited at eColorAttachmentOutput, the first transition chains to it
+		.initialAccess = {
+			.stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+			.accessMask = vk::AccessFlags2{},
+			.layout = vk::ImageLayout::eUndefined,
+		},
+		.finalAccess = {
+			.stageMask = vk::PipelineStageFlagBits2::eBottomOfPipe,
+			.accessMask = vk::AccessFlags2{},
+			.layout = swapchain.finalLayout,
+		},
+		.output = true,
+		.transient = false,
+		.aliasedResource = std::nullopt,
+	});
+
+	transient::request(transientState, graphState, transient::Target{
+		.name = "scene color",
+		.format = vk::Format::eR16G16B16A16Sfloat,
+		.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled,
+		.aspectMask = vk::ImageAspectFlagBits::eColor,
+	});
+	transient::request(transientState, graphState, transient::Target{
+		.name = "scene depth",
+		.format = vk::Format::eD32Sfloat,
+		.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment,
+		.aspectMask = vk::ImageAspectFlagBits::eDepth,
+	});
+	// same format as the swapchain, so that imgui blends in the same color space as before
+	transient::request(transientState, graphState, transient::Target{
+		.name = "ui layer",
+		.format = swapchain.surfaceFormat.format,
+		.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eSampled,
+		.aspectMask = vk::ImageAspectFlagBits::eColor,
+	});
+
+	// simple covers the whole scene color and discards what was there
+	graph::addPass(graphState, graph::Pass{
+		.name = "simple",
+		.uses = {
+			graph::Use{
+				.resource = GraphResource::SceneColor,
+				.access = {
+					.stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+					.accessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
+					.layout = vk::ImageLayout::eAttachmentOptimal,
+				},
+				.write = true,
+			},
+			graph::Use{
+				.resource = GraphResource::SceneDepth,
+				.access = {
+					.stageMask = vk::PipelineStageFlagBits2::eEarlyFragmentTests | vk::PipelineStageFlagBits2::eLateFragmentTests,
+					.accessMask = vk::AccessFlagBits2::eDepthStencilAttachmentRead | vk::AccessFlagBits2::eDepthStencilAttachmentWrite,
+					.layout = vk::ImageLayout::eAttachmentOptimal,
+				},
+				.write = true,
+			},
+		},
+	});
+
+	// imgui clears its own layer and blends into it
+	graph::addPass(graphState, graph::Pass{
+		.name = "imgui",
+		.uses = {
+			graph::Use{
+				.resource = GraphResource::UiLayer,
+				.access = {
+					.stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+					.accessMask = vk::AccessFlagBits2::eColorAttachmentRead | vk::AccessFlagBits2::eColorAttachmentWrite,
+					.layout = vk::ImageLayout::eAttachmentOptimal,
+				},
+				.write = true,
+			},
+		},
+	});
+
+	// composite puts the ui layer over the scene color into the swapchain image
+	graph::addPass(graphState, graph::Pass{
+		.name = "composite",
+		.uses = {
+			graph::Use{
+				.resource = GraphResource::SceneColor,
+				.access = {
+					.stageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+					.accessMask = vk::AccessFlagBits2::eShaderSampledRead,
+					.layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+				},
+				.write = false,
+			},
+			graph::Use{
+				.resource = GraphResource::UiLayer,
+				.access = {
+					.stageMask = vk::PipelineStageFlagBits2::eFragmentShader,
+					.accessMask = vk::AccessFlagBits2::eShaderSampledRead,
+					.layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+				},
+				.write = false,
+			},
+			graph::Use{
+				.resource = GraphResource::SwapchainImage,
+				.access = {
+					.stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+					.accessMask = vk::AccessFlagBits2::eColorAttachmentWrite,
+					.layout = vk::ImageLayout::eAttachmentOptimal,
+				},
+				.write = true,
+			},
+		},
+	});
+
+	graph::compile(graphState);
+
+	transient::allocate(transientState, graphState);
+
+	return graphState;
+}
+
 std::vector<FrameResources> createFrameResources(ware::contextVK::State &context, ware::swapchainVK::State &swapchain) {
-	return util::mapRange(swapchain.frameResources.size(), [&] ([[maybe_unused]] const auto &index) {
+	return util::mapRange(swapchain.framesInFlight, [&] ([[maybe_unused]] const auto &index) {
 		auto renderingCommandPool = context.device->createCommandPoolUnique({
 			.flags = vk::CommandPoolCreateFlagBits::eTransient,
 			.queueFamilyIndex = context.graphicQueueFamily,
@@ -30,25 +195,153 @@ void recreateFrameResources(State &state) {
 	auto &context = state.context;
 	auto &swapchain = state.swapchain;
 
-	if (state.swapchain.description.swapchainResized && state.frameResources.size() != swapchain.frameResources.size()) {
-		ware::contextVK::requestWaitIdle(context);
-
-		state.frameResources.clear();
+	if (state.swapchain.description.swapchainResized && state.frameResources.size() != swapchain.framesInFlight) {
+		ware::contextVK::deferDestroy(context, context.frameValue, std::move(state.frameResources));
 
 		state.frameResources = createFrameResources(context, swapchain);
 	}
 }
 
-State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::contextImgui::State &imgui, ware::swapchainVK::State &swapchain) {
+template<class PassState>
+[[nodiscard]] std::unique_ptr<PipelineReload> createPipelineReload(util::JobSystem &jobs, std::string passName, std::span<const std::string_view> shaderFiles, PassState &passState, std::move_only_function<vk::UniquePipeline()> (*rebuild)(const PassState &), void (*replace)(PassState &, vk::UniquePipeline &&)) {
+	return std::unique_ptr<PipelineReload>{new PipelineReload{
+		.passName = std::move(passName),
+		.shaderFiles = shaderFiles,
+		.rebuild = [&passState, rebuild] {
+			return rebuild(passState);
+		},
+		.replace = [&passState, replace] (vk::UniquePipeline &&pipeline) {
+			replace(passState, std::move(pipeline));
+		},
+		.running = false,
+		.stale = false,
+		.pipeline = {},
+		.job = util::JobScope{jobs},
+	}};
+}
+
+void launchReload(PipelineReload &reload) {
+	reload.running = true;
+	reload.stale = false;
+
+	// a background job, so that a main thread waiting for the jobs of a frame never compiles it in the middle of the frame,
+	// whatever the rebuild reads of the swapchain and the targets is taken here before they can change under it
+	reload.job.runInBackground("ware::rendererVK::launchReload()#rebuild pipeline", [&reload, rebuild = reload.rebuild()] () mutable {
+		reload.pipeline = rebuild();
+	});
+}
+
+// pipelines are only swapped here, between frames, while no pass is being recorded
+void reloadShaders(State &state) {
+	const auto fileNames = shaderWatch::poll(state.stateShaderWatch);
+
+	for (auto &reload : state.pipelineReloads) {
+		const bool changed = std::any_of(fileNames.begin(), fileNames.end(), [&] (const auto &fileName) {
+			return std::find(reload->shaderFiles.begin(), reload->shaderFiles.end(), fileName) != reload->shaderFiles.end();
+		});
+
+		if (changed && reload->running) {
+			reload->stale = true;
+		} else if (changed) {
+			spdlog::info("ware::rendererVK::reloadShaders() => rebuilding the pipeline of pass \"{}\"", reload->passName);
+
+			launchReload(*reload);
+		}
+
+		if ( ! reload->running || ! reload->job.done()) {
+			continue;
+		}
+
+		reload->running = false;
+
+		try {
+			reload->job.wait();
+			reload->replace(std::move(reload->pipeline));
+
+			spdlog::info("ware::rendererVK::reloadShaders() => swapped in the rebuilt pipeline of pass \"{}\"", reload->passName);
+		}
+		catch (std::exception const &e) {
+			spdlog::error("ware::rendererVK::reloadShaders() => rebuilding the pipeline of pass \"{}\" failed, keeping the previous one: {}", reload->passName, e.what());
+		}
+
+		// the files changed while compiling, what was just swapped in may already be outdated
+		if (reload->stale) {
+			launchReload(*reload);
+		}
+	}
+}
+
+State::~State() {
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(frameResources), std::move(computeTimeline));
+}
+
+State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::uploadVK::State &upload, ware::contextImgui::State &imgui, ware::swapchainVK::State &swapchain, util::JobSystem &jobs) {
 	auto frameResources = createFrameResources(context, swapchain);
 
+	std::unique_ptr<profiler::State> stateProfiler{new profiler::State(profiler::setup(context, swapchain, { "frame", "simple", "imgui", "composite" }))};
+	auto &profilerState = *stateProfiler;
+
+	std::unique_ptr<transient::State> stateTransient{new transient::State(transient::setup(context, swapchain))};
+	auto &transientState = *stateTransient;
+
+	std::unique_ptr<passes::plasma::State> statePlasma{};
+	std::unique_ptr<passes::imgui::State> stateImgui{};
+	std::unique_ptr<passes::simple::State> stateSimple{};
+	std::unique_ptr<passes::composite::State> stateComposite{};
+
+	// pipeline creation dominates the setup of a pass, the passes are set up side by side so that their pipelines compile concurrently,
+	// the scopes come after the states the jobs fill in, so that an unwinding exception joins the jobs first
+	util::JobScope plasmaSetup{jobs};
+	util::JobScope passSetups{jobs};
+
+	plasmaSetup.run("ware::rendererVK::setup()#plasma", [&] {
+		statePlasma.reset(new passes::plasma::State(passes::plasma::setup(context, swapchain)));
+	});
+
+	// requests the transient targets, the passes below look them up
+	auto graphState = createGraph(swapchain, transientState);
+
+	passSetups.run("ware::rendererVK::setup()#imgui", [&] {
+		stateImgui.reset(new passes::imgui::State(passes::imgui::setup(window, context, upload, imgui, swapchain, profilerState, transientState, jobs, GraphResource::UiLayer)));
+	});
+
+	passSetups.run("ware::rendererVK::setup()#simple", [&] {
+		// samples the plasma image, waiting executes other jobs until plasma is set up
+		plasmaSetup.wait();
+
+		stateSimple.reset(new passes::simple::State(passes::simple::setup(window, context, upload, swapchain, *statePlasma, transientState, GraphResource::SceneColor, GraphResource::SceneDepth)));
+	});
+
+	passSetups.run("ware::rendererVK::setup()#composite", [&] {
+		stateComposite.reset(new passes::composite::State(passes::composite::setup(window, context, swapchain, transientState, GraphResource::SceneColor, GraphResource::UiLayer)));
+	});
+
+	passSetups.wait();
+	plasmaSetup.wait();
+
+	std::vector<std::unique_ptr<PipelineReload>> pipelineReloads{};
+	pipelineReloads.push_back(createPipelineReload(jobs, "plasma", passes::plasma::shaderFiles, *statePlasma, passes::plasma::rebuildPipeline, passes::plasma::replacePipeline));
+	pipelineReloads.push_back(createPipelineReload(jobs, "imgui", passes::imgui::shaderFiles, *stateImgui, passes::imgui::rebuildPipeline, passes::imgui::replacePipeline));
+	pipelineReloads.push_back(createPipelineReload(jobs, "simple", passes::simple::shaderFiles, *stateSimple, passes::simple::rebuildPipeline, passes::simple::replacePipeline));
+	pipelineReloads.push_back(createPipelineReload(jobs, "composite", passes::composite::shaderFiles, *stateComposite, passes::composite::rebuildPipeline, passes::composite::replacePipeline));
+
 	return State{
 		.window = window,
 		.context = context,
+		.upload = upload,
 		.swapchain = swapchain,
+		.jobs = jobs,
 		.frameResources = std::move(frameResources),
-		.stateImgui = passes::imgui::setup(window, context, imgui, swapchain),
-		.stateSimple = passes::simple::setup(window, context, swapchain),
+		.computeTimeline = ware::contextVK::createTimelineSemaphore(context.device.get()),
+		.graph = std::move(graphState),
+		.stateProfiler = std::move(stateProfiler),
+		.stateTransient = std::move(stateTransient),
+		.statePlasma = std::move(statePlasma),
+		.stateImgui = std::move(stateImgui),
+		.stateSimple = std::move(stateSimple),
+		.stateComposite = std::move(stateComposite),
+		.stateShaderWatch = shaderWatch::setup(shaders::overrideDirectory),
+		.pipelineReloads = std::move(pipelineReloads),
 	};
 }
 
@@ -59,13 +352,21 @@ void refresh([[maybe_unused]] State &state) {
 		recreateFrameResources(state);
 	}
 
-	passes::imgui::refresh(state.stateImgui);
-	passes::simple::refresh(state.stateSimple);
+	transient::refresh(*state.stateTransient, state.graph);
+
+	reloadShaders(state);
+
+	passes::imgui::refresh(*state.stateImgui);
+	passes::plasma::refresh(*state.statePlasma);
+	passes::simple::refresh(*state.stateSimple);
+	passes::composite::refresh(*state.stateComposite);
 }
 
 void process([[maybe_unused]] State &state) {
 	ZoneScopedN("ware::rendererVK::process()");
 
+	const auto processTimePoint = std::chrono::steady_clock::now();
+
 	const auto &context = state.context;
 	const auto &swapchain = state.swapchain;
 	const auto &swapchainImageResources = swapchain.imageResources[swapchain.imageIndex];
@@ -76,8 +377,67 @@ void process([[maybe_unused]] State &state) {
 
 	context.device->resetCommandPool(frameResources.renderingCommandPool.get());
 
-	auto cmdSimple = passes::simple::process(state.stateSimple);
-	auto cmdImgui = passes::imgui::process(state.stateImgui);
+	std::array computeWorks{
+		passes::plasma::process(*state.statePlasma),
+	};
+
+	std::vector computeCommandBufferInfos = util::map(computeWorks, [] (const auto &computeWork) {
+		return vk::CommandBufferSubmitInfo{
+			.commandBuffer = computeWork.commandBuffer,
+		};
+	});
+	vk::SemaphoreSubmitInfo computeSignalSemaphoreInfo{
+		.semaphore = state.computeTimeline.get(),
+		.value = context.frameValue,
+		.stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+	};
+	vk::SubmitInfo2 computeSubmitInfo{
+		.commandBufferInfoCount = static_cast<uint32_t>(computeCommandBufferInfos.size()),
+		.pCommandBufferInfos = computeCommandBufferInfos.data(),
+		.signalSemaphoreInfoCount = 1,
+		.pSignalSemaphoreInfos = &computeSignalSemaphoreInfo,
+	};
+
+	// a software ICD may hand out a single queue for both, then compute goes into the same submit call as the graphic work
+	const bool sharedComputeQueue = context.computeQueue == context.graphicQueue;
+
+	if ( ! sharedComputeQueue) {
+		ZoneScopedN("ware::rendererVK::process()#submit compute");
+
+		// submitted ahead of recording the graphic work, so that it overlaps with it
+		context.computeQueue.submit2({ computeSubmitInfo });
+	}
+
+	auto &profilerState = *state.stateProfiler;
+
+	// the passes record into secondaries of their own per-frame pools, so they can be recorded side by side
+	std::array<vk::CommandBuffer, 3> passCommandBuffers{};
+	util::JobScope passRecordings{state.jobs};
+	const auto recordPass = [&] (const char *name, GraphPass pass, auto &&process) {
+		// culled passes are not recorded at all
+		if (graph::isCulled(state.graph, pass)) {
+			return;
+		}
+
+		passRecordings.run(name, [&profilerState, &passCommandBuffers, pass, process] {
+			const auto startTimePoint = std::chrono::steady_clock::now();
+			passCommandBuffers[pass] = process();
+			profiler::recordCpuTime(profilerState, graphPassScopes[pass], std::chrono::steady_clock::now() - startTimePoint);
+		});
+	};
+
+	recordPass("ware::rendererVK::process()#record simple", GraphPass::SimplePass, [&] { return passes::simple::process(*state.stateSimple); });
+	recordPass("ware::rendererVK::process()#record imgui", GraphPass::ImguiPass, [&] { return passes::imgui::process(*state.stateImgui); });
+	recordPass("ware::rendererVK::process()#record composite", GraphPass::CompositePass, [&] { return passes::composite::process(*state.stateComposite); });
+
+	graph::bindImage(state.graph, GraphResource::SwapchainImage, swapchainImageResources.image);
+	transient::bindImages(*state.stateTransient, state.graph);
+	graph::build(state.graph);
+
+	TracyPlot("render graph barriers", static_cast<int64_t>(state.graph.barrierCount));
+
+	// everything uploaded up to now becomes usable with this submit
+	auto acquire = ware::uploadVK::takeAcquire(state.upload);
 
 	{
 		ZoneScopedN("ware::rendererVK::process()#record");
@@ -86,7 +446,40 @@ void process([[maybe_unused]] State &state) {
 			.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
 		});
 
-		cmd.executeCommands({ cmdSimple, cmdImgui });
+		profiler::beginFrame(profilerState, cmd);
+
+		if ( ! acquire.bufferMemoryBarriers.empty() || ! acquire.imageMemoryBarriers.empty()) {
+			cmd.pipelineBarrier2({
+				.bufferMemoryBarrierCount = static_cast<uint32_t>(acquire.bufferMemoryBarriers.size()),
+				.pBufferMemoryBarriers = acquire.bufferMemoryBarriers.data(),
+				.imageMemoryBarrierCount = static_cast<uint32_t>(acquire.imageMemoryBarriers.size()),
+				.pImageMemoryBarriers = acquire.imageMemoryBarriers.data(),
+			});
+		}
+
+		{
+			ZoneScopedN("ware::rendererVK::process()#join recordings");
+
+			// records whatever no worker has picked up yet, rethrows whatever a recording threw
+			passRecordings.wait();
+		}
+
+		profiler::beginScope(profilerState, cmd, ProfilerScope::Frame);
+
+		// each secondary gets its own executeCommands, so that its GPU time can be bracketed
+		graph::execute(state.graph, cmd, [&] (graph::PassId pass) {
+			const auto scope = graphPassScopes[pass];
+
+			profiler::beginScope(profilerState, cmd, scope);
+			profiler::beginPipelineStatistics(profilerState, cmd, scope);
+			cmd.executeCommands({ passCommandBuffers[pass] });
+			profiler::endPipelineStatistics(profilerState, cmd, scope);
+			profiler::endScope(profilerState, cmd, scope);
+		});
+
+		profiler::endScope(profilerState, cmd, ProfilerScope::Frame);
+
+		profiler::recordCpuTime(profilerState, ProfilerScope::Frame, std::chrono::steady_clock::now() - processTimePoint);
 
 		cmd.end();
 	}
@@ -94,27 +487,54 @@ void process([[maybe_unused]] State &state) {
 	{
 		ZoneScopedN("ware::rendererVK::process()#submit");
 
-		vk::SemaphoreSubmitInfo waitSemaphoreInfo{
-			.semaphore = swapchainFrameResources.acquireSemaphore.get(),
-			.stageMask = vk::PipelineStageFlagBits2::eFragmentShader,
-		};
+		// headless offscreen images are neither acquired nor presented
+		std::vector<vk::SemaphoreSubmitInfo> waitSemaphoreInfos{};
+		if ( ! swapchain.headless) {
+			waitSemaphoreInfos.push_back(vk::SemaphoreSubmitInfo{
+				.semaphore = swapchainFrameResources.acquireSemaphore.get(),
+				.stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+			});
+		}
+		waitSemaphoreInfos.push_back(vk::SemaphoreSubmitInfo{
+			.semaphore = state.computeTimeline.get(),
+			.value = context.frameValue,
+			.stageMask = std::accumulate(computeWorks.begin(), computeWorks.end(), vk::PipelineStageFlags2{}, [] (auto stageMask, const auto &computeWork) {
+				return stageMask | computeWork.consumerStageMask;
+			}),
+		});
+		if (acquire.uploadValue > 0) {
+			waitSemaphoreInfos.push_back(vk::SemaphoreSubmitInfo{
+				.semaphore = state.upload.uploadTimeline.get(),
+				.value = acquire.uploadValue,
+				.stageMask = acquire.stageMask,
+			});
+		}
 		vk::CommandBufferSubmitInfo commandBufferInfo{
 			.commandBuffer = cmd,
 		};
-		vk::SemaphoreSubmitInfo signalSemaphoreInfo{
-			.semaphore = swapchainImageResources.presentSemaphore.get(),
-			.stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+		std::vector signalSemaphoreInfos{
+			ware::contextVK::frameSignalInfo(context),
+		};
+		if ( ! swapchain.headless) {
+			signalSemaphoreInfos.push_back(vk::SemaphoreSubmitInfo{
+				.semaphore = swapchainImageResources.presentSemaphore.get(),
+				.stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput,
+			});
+		}
+		vk::SubmitInfo2 graphicSubmitInfo{
+			.waitSemaphoreInfoCount = static_cast<uint32_t>(waitSemaphoreInfos.size()),
+			.pWaitSemaphoreInfos = waitSemaphoreInfos.data(),
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &commandBufferInfo,
+			.signalSemaphoreInfoCount = static_cast<uint32_t>(signalSemaphoreInfos.size()),
+			.pSignalSemaphoreInfos = signalSemaphoreInfos.data(),
 		};
-		context.graphicQueue.submit2({
-			{
-				.waitSemaphoreInfoCount = 1,
-				.pWaitSemaphoreInfos = &waitSemaphoreInfo,
-				.commandBufferInfoCount = 1,
-				.pCommandBufferInfos = &commandBufferInfo,
-				.signalSemaphoreInfoCount = 1,
-				.pSignalSemaphoreInfos = &signalSemaphoreInfo,
-			}
-		}, swapchainFrameResources.renderingFence.get());
+
+		if (sharedComputeQueue) {
+			context.graphicQueue.submit2({ computeSubmitInfo, graphicSubmitInfo });
+		} else {
+			context.graphicQueue.submit2({ graphicSubmitInfo });
+		}
 	}
 }
 
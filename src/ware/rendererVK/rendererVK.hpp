@@ -1,7 +1,22 @@
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <util/jobSystem.hpp>
+
+#include "graph.hpp"
+#include "passes/composite.hpp"
 #include "passes/imgui.hpp"
+#include "passes/plasma.hpp"
 #include "passes/simple.hpp"
+#include "profiler.hpp"
+#include "shaderWatch.hpp"
+#include "shaders.hpp"
+#include "transient.hpp"
 
 namespace ware::rendererVK {
 
@@ -10,18 +25,50 @@ struct FrameResources {
 	vk::CommandBuffer renderingCommandBuffer;
 };
 
+// rebuilds the pipeline of a pass on a worker when one of its shader files changes, refresh() swaps it in
+struct PipelineReload {
+	std::string passName;
+	std::span<const std::string_view> shaderFiles;
+	// called on the main thread, the returned function compiles the pipeline on a worker
+	std::function<std::move_only_function<vk::UniquePipeline()>()> rebuild;
+	std::function<void(vk::UniquePipeline &&)> replace;
+	bool running;
+	// a shader file changed again while the rebuild was running
+	bool stale;
+	vk::UniquePipeline pipeline;
+	// declared last, so that a running rebuild is joined before the rest goes away
+	util::JobScope job;
+};
+
 struct State {
 	ware::windowGLFW::State &window;
 	ware::contextVK::State &context;
+	ware::uploadVK::State &upload;
 	ware::swapchainVK::State &swapchain;
+	// records the passes of a frame side by side, each pass only touches its own per-frame command pool
+	util::JobSystem &jobs;
 
 	std::vector<FrameResources> frameResources;
+	// frame N signals computeTimeline with value N once its compute work is done
+	vk::UniqueSemaphore computeTimeline;
+	graph::State graph;
+
+	// held by pointer, passes keep references to them and need a stable address during setup, the passes are set up by jobs
+	std::unique_ptr<profiler::State> stateProfiler;
+	std::unique_ptr<transient::State> stateTransient;
+	std::unique_ptr<passes::plasma::State> statePlasma;
+	std::unique_ptr<passes::imgui::State> stateImgui;
+	std::unique_ptr<passes::simple::State> stateSimple;
+	std::unique_ptr<passes::composite::State> stateComposite;
+
+	shaderWatch::State stateShaderWatch;
+	// after the passes, the rebuilds reference them
+	std::vector<std::unique_ptr<PipelineReload>> pipelineReloads;
 
-	passes::imgui::State stateImgui;
-	passes::simple::State stateSimple;
+	~State();
 };
 
-State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::contextImgui::State &imgui, ware::swapchainVK::State &swapchain);
+State setup(ware::windowGLFW::State &window, ware::contextVK::State &context, ware::uploadVK::State &upload, ware::contextImgui::State &imgui, ware::swapchainVK::State &swapchain, util::JobSystem &jobs);
 
 void refresh(State &state);
 
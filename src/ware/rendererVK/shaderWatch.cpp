@@ -0,0 +1,97 @@
+#include "shaderWatch.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace ware::rendererVK::shaderWatch {
+
+std::vector<std::string> poll([[maybe_unused]] State &state) {
+	std::vector<std::string> fileNames{};
+
+#ifdef __linux__
+	if ( ! state.inotify) {
+		return fileNames;
+	}
+
+	ZoneScopedN("ware::rendererVK::shaderWatch::poll()");
+
+	alignas(inotify_event) std::array<char, 4096> buffer;
+
+	// the descriptor is non-blocking, read() fails with EAGAIN once the queue is drained
+	ssize_t size = 0;
+	while ((size = read(state.inotify.get(), buffer.data(), buffer.size())) > 0) {
+		for (ssize_t offset = 0; offset < size;) {
+			const auto *event = reinterpret_cast<const inotify_event *>(buffer.data() + offset);
+			offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+			if (event->len == 0) {
+				continue;
+			}
+
+			// the name is padded with null bytes up to len
+			std::string fileName{event->name};
+
+			if (fileName.ends_with(".spv") && std::find(fileNames.begin(), fileNames.end(), fileName) == fileNames.end()) {
+				fileNames.push_back(std::move(fileName));
+			}
+		}
+	}
+#endif
+
+	return fileNames;
+}
+
+State setup(const std::filesystem::path &directory) {
+#ifdef __linux__
+	int descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (descriptor < 0) {
+		spdlog::warn("ware::rendererVK::shaderWatch::setup() => inotify is not available ({}), shaders are not reloaded", std::strerror(errno));
+
+		return State{
+			.directory = directory,
+			.inotify = {},
+		};
+	}
+
+	util::UniqueResource<int> inotify{std::move(descriptor), [] (int closedDescriptor) {
+		close(closedDescriptor);
+	}};
+
+	// glslc writes the files in place, a build copying them over renames them into the directory
+	if (inotify_add_watch(inotify.get(), directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		spdlog::warn("ware::rendererVK::shaderWatch::setup() => unable to watch \"{}\" ({}), shaders are not reloaded", directory.string(), std::strerror(errno));
+
+		return State{
+			.directory = directory,
+			.inotify = {},
+		};
+	}
+
+	spdlog::info("ware::rendererVK::shaderWatch::setup() => reloading shaders written into \"{}\"", directory.string());
+
+	return State{
+		.directory = directory,
+		.inotify = std::move(inotify),
+	};
+#else
+	spdlog::info("ware::rendererVK::shaderWatch::setup() => shader reloading needs inotify, not available on this platform");
+
+	return State{
+		.directory = directory,
+		.inotify = {},
+	};
+#endif
+}
+
+} // ware::rendererVK::shaderWatch
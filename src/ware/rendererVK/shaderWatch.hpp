@@ -0,0 +1,22 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <util/uniqueResource.hpp>
+
+namespace ware::rendererVK::shaderWatch {
+
+struct State {
+	std::filesystem::path directory;
+	// empty where inotify is not available, nothing is ever reported then
+	util::UniqueResource<int> inotify;
+};
+
+// names of the .spv files written into the directory since the last poll, each once, never blocks
+[[nodiscard]] std::vector<std::string> poll(State &state);
+
+State setup(const std::filesystem::path &directory);
+
+} // ware::rendererVK::shaderWatch
@@ -0,0 +1,82 @@
+#include "shaders.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <embeddedShaders.hpp>
+#include <util/fs.hpp>
+#include <util/map.hpp>
+
+namespace ware::rendererVK::shaders {
+
+std::span<const uint32_t> findEmbedded(std::string_view fileName) {
+	const auto file = std::find_if(embeddedShaders::files.begin(), embeddedShaders::files.end(), [&] (const auto &file) {
+		return file.name == fileName;
+	});
+
+	if (file == embeddedShaders::files.end()) {
+		return {};
+	}
+
+	return file->code;
+}
+
+[[nodiscard]] std::vector<uint32_t> readOverride(const std::filesystem::path &filePath) {
+	auto contentsO = util::fsReadBytes(filePath);
+
+	if ( ! contentsO) {
+		return {};
+	}
+
+	if (contentsO->size() == 0) {
+		throw std::runtime_error{fmt::format("Shader file \"{}\" is empty", filePath.string())};
+	}
+
+	if (contentsO->size() % sizeof(uint32_t) != 0) {
+		throw std::runtime_error{fmt::format("Shader file \"{}\" is corrupted (size: {})", filePath.string(), contentsO->size())};
+	}
+
+	// copied into words instead of reinterpreting the byte storage
+	std::vector<uint32_t> code(contentsO->size() / sizeof(uint32_t));
+	std::memcpy(code.data(), contentsO->data(), contentsO->size());
+
+	return code;
+}
+
+Code load(std::string_view fileName, Source source) {
+	Code code{
+		.overrideWords = {},
+		.words = {},
+	};
+
+	if (source == Source::eOverride) {
+		code.overrideWords = readOverride(overrideDirectory / fileName);
+	}
+
+	code.words = code.overrideWords.empty() ? findEmbedded(fileName) : std::span<const uint32_t>{code.overrideWords};
+
+	if (code.words.empty()) {
+		throw std::runtime_error{fmt::format("Unknown shader \"{}\"", fileName)};
+	}
+
+	return code;
+}
+
+std::vector<Code> load(std::span<const std::string_view> fileNames, Source source) {
+	return util::map(fileNames, [&] (const auto &fileName) {
+		return load(fileName, source);
+	});
+}
+
+vk::UniqueShaderModule createModule(ware::contextVK::State &context, const Code &code) {
+	return context.device->createShaderModuleUnique({
+		.codeSize = code.words.size_bytes(),
+		.pCode = code.words.data(),
+	});
+}
+
+} // ware::rendererVK::shaders
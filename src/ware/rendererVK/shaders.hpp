@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "../contextVK/contextVK.hpp"
+
+namespace ware::rendererVK::shaders {
+
+// relative to the working directory, recompiled shaders dropped in there replace the embedded ones on hot reload
+const std::filesystem::path overrideDirectory{"shaders"};
+
+enum class Source {
+	eEmbedded,
+	// the override directory when it has the file, the embedded code otherwise
+	eOverride,
+};
+
+struct Code {
+	// only filled when read from the override directory
+	std::vector<uint32_t> overrideWords;
+	// into the executable or overrideWords, moving the Code keeps it valid
+	std::span<const uint32_t> words;
+};
+
+// the SPIR-V compiled into the executable, empty when there is no shader of that name
+[[nodiscard]] std::span<const uint32_t> findEmbedded(std::string_view fileName);
+
+[[nodiscard]] Code load(std::string_view fileName, Source source);
+[[nodiscard]] std::vector<Code> load(std::span<const std::string_view> fileNames, Source source);
+
+[[nodiscard]] vk::UniqueShaderModule createModule(ware::contextVK::State &context, const Code &code);
+
+} // ware::rendererVK::shaders
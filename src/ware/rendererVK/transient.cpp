@@ -0,0 +1,429 @@
+#include "transient.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+#include <util/map.hpp>
+
+namespace ware::rendererVK::transient {
+
+// a target that is only ever rendered to never needs its contents in memory
+const vk::ImageUsageFlags attachmentUsage = vk::ImageUsageFlagBits::eColorAttachment
+	| vk::ImageUsageFlagBits::eDepthStencilAttachment
+	| vk::ImageUsageFlagBits::eInputAttachment;
+
+// targets with disjoint lifetimes share a slot, the slot is as large as its largest target
+struct Slot {
+	vk::DeviceSize offset;
+	vk::DeviceSize size;
+	vk::DeviceSize alignment;
+	std::vector<uint32_t> targets;
+};
+
+// slots sharing a memory type end up in one allocation
+struct Heap {
+	uint32_t memoryTypeBits;
+	vk::DeviceSize size;
+	vk::DeviceSize alignment;
+	std::vector<Slot> slots;
+};
+
+struct Placement {
+	uint32_t heap;
+	vk::DeviceSize offset;
+	// target that used the memory before this one within the frame
+	std::optional<uint32_t> aliasedTarget;
+};
+
+struct Layout {
+	std::vector<Heap> heaps;
+	std::vector<std::optional<Placement>> placements;
+};
+
+[[nodiscard]] bool overlaps(const graph::Lifetime &a, const graph::Lifetime &b) {
+	return a.first <= b.last && b.first <= a.last;
+}
+
+[[nodiscard]] vk::ImageCreateInfo createImageCreateInfo(const State &state, const Target &target, bool lazy) {
+	const auto &description = state.swapchain.description;
+
+	return vk::ImageCreateInfo{
+		.imageType = vk::ImageType::e2D,
+		.format = target.format,
+		.extent = {
+			.width = static_cast<uint32_t>(std::max(1, description.width)),
+			.height = static_cast<uint32_t>(std::max(1, description.height)),
+			.depth = 1,
+		},
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.usage = lazy ? target.usage | vk::ImageUsageFlagBits::eTransientAttachment : target.usage,
+		.sharingMode = vk::SharingMode::eExclusive,
+		.initialLayout = vk::ImageLayout::eUndefined,
+	};
+}
+
+// greedy interval packing, the largest targets pick their slots first
+[[nodiscard]] Layout placeTargets(const std::vector<std::optional<graph::Lifetime>> &lifetimes, const std::vector<std::optional<vk::MemoryRequirements>> &memoryRequirements) {
+	std::vector<uint32_t> targets(memoryRequirements.size());
+	std::iota(targets.begin(), targets.end(), 0);
+	std::erase_if(targets, [&] (const auto target) {
+		return ! memoryRequirements[target];
+	});
+	std::stable_sort(targets.begin(), targets.end(), [&] (const auto a, const auto b) {
+		return memoryRequirements[a]->size > memoryRequirements[b]->size;
+	});
+
+	std::vector<Heap> heaps{};
+	for (const auto target : targets) {
+		const auto &requirements = *memoryRequirements[target];
+
+		auto heap = std::find_if(heaps.begin(), heaps.end(), [&] (const auto &candidate) {
+			return (candidate.memoryTypeBits & requirements.memoryTypeBits) != 0;
+		});
+		if (heap == heaps.end()) {
+			heap = heaps.insert(heaps.end(), Heap{
+				.memoryTypeBits = requirements.memoryTypeBits,
+				.size = 0,
+				.alignment = 1,
+				.slots = {},
+			});
+		}
+		heap->memoryTypeBits &= requirements.memoryTypeBits;
+
+		auto slot = std::find_if(heap->slots.begin(), heap->slots.end(), [&] (const auto &candidate) {
+			return std::none_of(candidate.targets.begin(), candidate.targets.end(), [&] (const auto slotTarget) {
+				return overlaps(*lifetimes[slotTarget], *lifetimes[target]);
+			});
+		});
+		if (slot == heap->slots.end()) {
+			slot = heap->slots.insert(heap->slots.end(), Slot{
+				.offset = 0,
+				.size = 0,
+				.alignment = 1,
+				.targets = {},
+			});
+		}
+		slot->size = std::max(slot->size, requirements.size);
+		slot->alignment = std::max(slot->alignment, requirements.alignment);
+		slot->targets.push_back(target);
+	}
+
+	std::vector<std::optional<Placement>> placements(memoryRequirements.size());
+	for (uint32_t heapIndex = 0; heapIndex < heaps.size(); heapIndex++) {
+		auto &heap = heaps[heapIndex];
+
+		for (auto &slot : heap.slots) {
+			slot.offset = (heap.size + slot.alignment - 1) / slot.alignment * slot.alignment;
+			heap.size = slot.offset + slot.size;
+			heap.alignment = std::max(heap.alignment, slot.alignment);
+
+			// within a slot each target takes over the memory from the one used right before it
+			std::sort(slot.targets.begin(), slot.targets.end(), [&] (const auto a, const auto b) {
+				return lifetimes[a]->first < lifetimes[b]->first;
+			});
+
+			for (size_t i = 0; i < slot.targets.size(); i++) {
+				placements[slot.targets[i]] = Placement{
+					.heap = heapIndex,
+					.offset = slot.offset,
+					.aliasedTarget = i > 0 ? std::optional<uint32_t>{slot.targets[i - 1]} : std::nullopt,
+				};
+			}
+		}
+	}
+
+	return Layout{
+		.heaps = std::move(heaps),
+		.placements = std::move(placements),
+	};
+}
+
+[[nodiscard]] vk::UniqueImageView createImageView(ware::contextVK::State &context, const Target &target, vk::Image image) {
+	return context.device->createImageViewUnique({
+		.image = image,
+		.viewType = vk::ImageViewType::e2D,
+		.format = target.format,
+		.subresourceRange = {
+			.aspectMask = target.aspectMask,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+	});
+}
+
+[[nodiscard]] bool hasLazilyAllocatedMemoryType(const ware::contextVK::State &context, uint32_t memoryTypeBits) {
+	const auto &memoryProperties = context.physicalDeviceMemoryProperties2.memoryProperties;
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+		if ((memoryTypeBits & (uint32_t{1} << i)) != 0 && (memoryProperties.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// attachment only targets go into lazily allocated memory when the device has a memory type that fits them
+[[nodiscard]] std::vector<bool> findLazyTargets(State &state, const std::vector<std::optional<graph::Lifetime>> &lifetimes) {
+	auto &context = state.context;
+
+	return util::mapIndexed(state.targets, [&] (const auto &target, size_t index) {
+		if ( ! state.lazilyAllocatedSupported || ! lifetimes[index] || (target.usage & ~attachmentUsage) != vk::ImageUsageFlags{}) {
+			return false;
+		}
+
+		auto probeImage = context.device->createImageUnique(createImageCreateInfo(state, target, true));
+
+		return hasLazilyAllocatedMemoryType(context, context.device->getImageMemoryRequirements(probeImage.get()).memoryTypeBits);
+	});
+}
+
+// the aliased images of a frame, unbound
+[[nodiscard]] std::vector<vk::UniqueImage> createAliasedImages(State &state, const std::vector<std::optional<graph::Lifetime>> &lifetimes, const std::vector<bool> &lazyTargets) {
+	auto &context = state.context;
+
+	return util::mapIndexed(state.targets, [&] (const auto &target, size_t index) {
+		if ( ! lifetimes[index] || lazyTargets[index]) {
+			return vk::UniqueImage{};
+		}
+
+		return context.device->createImageUnique(createImageCreateInfo(state, target, false));
+	});
+}
+
+void allocate(State &state, graph::State &graph) {
+	ZoneScopedN("ware::rendererVK::transient::allocate()");
+
+	auto &context = state.context;
+
+	const auto lifetimes = util::map(state.resources, [&] (const auto resource) {
+		return graph::findLifetime(graph, resource);
+	});
+
+	const auto lazyTargets = findLazyTargets(state, lifetimes);
+
+	std::vector<std::vector<vk::UniqueImage>> aliasedImages = util::mapRange(state.swapchain.framesInFlight, [&] ([[maybe_unused]] const auto &index) {
+		return createAliasedImages(state, lifetimes, lazyTargets);
+	});
+
+	// images created from the same create info have the same requirements, the first frame stands for all of them
+	const auto memoryRequirements = util::map(aliasedImages.front(), [&] (const auto &image) {
+		return image ? std::optional<vk::MemoryRequirements>{context.device->getImageMemoryRequirements(image.get())} : std::nullopt;
+	});
+
+	const auto layout = placeTargets(lifetimes, memoryRequirements);
+
+	for (uint32_t target = 0; target < state.targets.size(); target++) {
+		const auto &placement = layout.placements[target];
+
+		graph::aliasImage(graph, state.resources[target], placement && placement->aliasedTarget ? std::optional<graph::ResourceId>{state.resources[*placement->aliasedTarget]} : std::nullopt);
+	}
+
+	auto frameResources = util::mapRange(aliasedImages.size(), [&] (size_t frame) {
+		auto &frameAliasedImages = aliasedImages[frame];
+
+		std::vector memories = util::map(layout.heaps, [&] (const auto &heap) {
+			vk::MemoryRequirements heapMemoryRequirements{
+				.size = heap.size,
+				.alignment = heap.alignment,
+				.memoryTypeBits = heap.memoryTypeBits,
+			};
+			vma::AllocationCreateInfo allocationCreateInfo{
+				.flags = vma::AllocationCreateFlagBits::eCanAlias,
+				.usage = vma::MemoryUsage::eUnknown,
+				.preferredFlags = vk::MemoryPropertyFlagBits::eDeviceLocal,
+			};
+
+			return ware::contextVK::allocateMemory(context, heapMemoryRequirements, allocationCreateInfo);
+		});
+
+		std::vector targetResources = util::mapIndexed(state.targets, [&] (const auto &target, size_t index) {
+			if ( ! lifetimes[index]) {
+				return TargetResources{};
+			}
+
+			if (lazyTargets[index]) {
+				auto imageCreateInfo = createImageCreateInfo(state, target, true);
+				vma::AllocationCreateInfo allocationCreateInfo{
+					.usage = vma::MemoryUsage::eGpuLazilyAllocated,
+				};
+
+				auto lazyImage = ware::contextVK::createImage(context, imageCreateInfo, allocationCreateInfo);
+				const auto image = lazyImage->image;
+
+				if ( ! image) {
+					throw std::runtime_error{fmt::format("Unable to create lazily allocated transient target \"{}\"", target.name)};
+				}
+
+				return TargetResources{
+					.lazyImage = std::move(lazyImage),
+					.aliasedImage = {},
+					.image = image,
+					.imageView = createImageView(context, target, image),
+				};
+			}
+
+			const auto &placement = *layout.placements[index];
+			auto aliasedImage = std::move(frameAliasedImages[index]);
+
+			ware::contextVK::bindImageMemory(memories[placement.heap], placement.offset, aliasedImage.get());
+
+			const auto image = aliasedImage.get();
+
+			return TargetResources{
+				.lazyImage = {},
+				.aliasedImage = std::move(aliasedImage),
+				.image = image,
+				.imageView = createImageView(context, target, image),
+			};
+		});
+
+		return FrameResources{
+			.memories = std::move(memories),
+			.targetResources = std::move(targetResources),
+		};
+	});
+
+	Statistics statistics{
+		.targetCount = static_cast<uint32_t>(state.targets.size()),
+		.aliasedCount = 0,
+		.lazyCount = 0,
+		.requestedSize = 0,
+		.allocatedSize = 0,
+		.lazySize = 0,
+		.savedSize = 0,
+	};
+	for (uint32_t target = 0; target < state.targets.size(); target++) {
+		if (memoryRequirements[target]) {
+			statistics.aliasedCount++;
+			statistics.requestedSize += memoryRequirements[target]->size;
+		} else if (const auto &lazyImage = frameResources.front().targetResources[target].lazyImage) {
+			statistics.lazyCount++;
+			statistics.lazySize += lazyImage.resource->first.size;
+		}
+	}
+	statistics.allocatedSize = std::accumulate(layout.heaps.begin(), layout.heaps.end(), vk::DeviceSize{0}, [] (auto size, const auto &heap) {
+		return size + heap.size;
+	});
+	statistics.savedSize = statistics.requestedSize - std::min(statistics.requestedSize, statistics.allocatedSize);
+	statistics.requestedSize += statistics.lazySize;
+
+	spdlog::info("ware::rendererVK::transient::allocate() => {} target(s): {} aliased into {} KiB, {} lazily allocated ({} KiB), {} KiB of {} KiB saved per frame", statistics.targetCount, statistics.aliasedCount, statistics.allocatedSize / 1024, statistics.lazyCount, statistics.lazySize / 1024, statistics.savedSize / 1024, statistics.requestedSize / 1024);
+
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(state.frameResources));
+
+	state.frameResources = std::move(frameResources);
+	state.statistics = statistics;
+}
+
+graph::ResourceId request(State &state, graph::State &graph, Target &&target) {
+	const auto resource = graph::addImage(graph, graph::Image{
+		.name = target.name,
+		.image = vk::Image{},
+		.subresourceRange = {
+			.aspectMask = target.aspectMask,
+			.baseMipLevel = 0,
+			.levelCount = 1,
+			.baseArrayLayer = 0,
+			.layerCount = 1,
+		},
+		// contents never survive a frame, the memory may have belonged to another target
+		.initialAccess = {
+			.stageMask = vk::PipelineStageFlagBits2::eNone,
+			.accessMask = vk::AccessFlags2{},
+			.layout = vk::ImageLayout::eUndefined,
+		},
+		.finalAccess = {
+			.stageMask = vk::PipelineStageFlagBits2::eNone,
+			.accessMask = vk::AccessFlags2{},
+			.layout = vk::ImageLayout::eUndefined,
+		},
+		.output = false,
+		.transient = true,
+		.aliasedResource = std::nullopt,
+	});
+
+	state.targets.push_back(std::move(target));
+	state.resources.push_back(resource);
+
+	return resource;
+}
+
+void bindImages(State &state, graph::State &graph) {
+	const auto &targetResources = state.frameResources[state.swapchain.frameIndex].targetResources;
+
+	for (size_t target = 0; target < state.targets.size(); target++) {
+		graph::bindImage(graph, state.resources[target], targetResources[target].image);
+	}
+}
+
+[[nodiscard]] size_t findTargetIndex(const State &state, graph::ResourceId resource) {
+	const auto target = std::find(state.resources.begin(), state.resources.end(), resource);
+
+	if (target == state.resources.end()) {
+		throw std::runtime_error{fmt::format("Render graph resource {} is not a transient target", resource)};
+	}
+
+	return static_cast<size_t>(std::distance(state.resources.begin(), target));
+}
+
+const Target & findTarget(const State &state, graph::ResourceId resource) {
+	return state.targets[findTargetIndex(state, resource)];
+}
+
+vk::ImageView imageView(const State &state, graph::ResourceId resource) {
+	return state.frameResources[state.swapchain.frameIndex].targetResources[findTargetIndex(state, resource)].imageView.get();
+}
+
+const Statistics & queryStatistics(const State &state) {
+	return state.statistics;
+}
+
+State::~State() {
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(frameResources));
+}
+
+State setup(ware::contextVK::State &context, ware::swapchainVK::State &swapchain) {
+	const bool lazilyAllocatedSupported = hasLazilyAllocatedMemoryType(context, ~uint32_t{0});
+
+	if ( ! lazilyAllocatedSupported) {
+		spdlog::debug("ware::rendererVK::transient::setup() => no lazily allocated memory type, attachment only targets are aliased as well");
+	}
+
+	return State{
+		.context = context,
+		.swapchain = swapchain,
+		.lazilyAllocatedSupported = lazilyAllocatedSupported,
+		.targets = {},
+		.resources = {},
+		.frameResources = {},
+		.statistics = {
+			.targetCount = 0,
+			.aliasedCount = 0,
+			.lazyCount = 0,
+			.requestedSize = 0,
+			.allocatedSize = 0,
+			.lazySize = 0,
+			.savedSize = 0,
+		},
+	};
+}
+
+void refresh(State &state, graph::State &graph) {
+	ZoneScopedN("ware::rendererVK::transient::refresh()");
+
+	if (state.swapchain.description.swapchainResized) {
+		allocate(state, graph);
+	}
+}
+
+} // ware::rendererVK::transient
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "../contextVK/contextVK.hpp"
+#include "../swapchainVK/swapchainVK.hpp"
+#include "graph.hpp"
+
+namespace ware::rendererVK::transient {
+
+// an intermediate render target with the extent of the swapchain, only valid during the frame
+struct Target {
+	std::string name;
+	vk::Format format;
+	vk::ImageUsageFlags usage;
+	vk::ImageAspectFlags aspectMask;
+};
+
+struct TargetResources {
+	// owns the image when it is lazily allocated, declared first so that the view goes before the image
+	ware::contextVK::UniqueImage lazyImage;
+	// bound into the aliased memory otherwise
+	vk::UniqueImage aliasedImage;
+	vk::Image image;
+	vk::UniqueImageView imageView;
+};
+
+// one set of targets per frame in flight, the targets of a frame alias each other
+struct FrameResources {
+	std::vector<ware::contextVK::UniqueMemory> memories;
+	std::vector<TargetResources> targetResources;
+};
+
+// sizes are per frame in flight
+struct Statistics {
+	uint32_t targetCount;
+	uint32_t aliasedCount;
+	uint32_t lazyCount;
+	// sum of the sizes of all targets as if each had its own memory
+	vk::DeviceSize requestedSize;
+	// memory the aliased targets actually share
+	vk::DeviceSize allocatedSize;
+	// lazily allocated targets only get memory committed on demand, on tiled GPUs usually none
+	vk::DeviceSize lazySize;
+	vk::DeviceSize savedSize;
+};
+
+struct State {
+	ware::contextVK::State &context;
+	ware::swapchainVK::State &swapchain;
+
+	bool lazilyAllocatedSupported;
+	std::vector<Target> targets;
+	std::vector<graph::ResourceId> resources;
+	std::vector<FrameResources> frameResources;
+	Statistics statistics;
+
+	~State();
+};
+
+// declares the target as a transient image of the graph
+graph::ResourceId request(State &state, graph::State &graph, Target &&target);
+
+// places the targets by their lifetimes in graph order, call after graph::compile()
+void allocate(State &state, graph::State &graph);
+
+// binds the targets of the current frame to the graph
+void bindImages(State &state, graph::State &graph);
+
+[[nodiscard]] const Target & findTarget(const State &state, graph::ResourceId resource);
+[[nodiscard]] vk::ImageView imageView(const State &state, graph::ResourceId resource);
+
+[[nodiscard]] const Statistics & queryStatistics(const State &state);
+
+State setup(ware::contextVK::State &context, ware::swapchainVK::State &swapchain);
+
+void refresh(State &state, graph::State &graph);
+
+} // ware::rendererVK::transient
@@ -2,7 +2,6 @@
 
 #include <algorithm>
 #include <array>
-#include <limits>
 #include <tuple>
 #include <vector>
 
@@ -15,7 +14,7 @@
 
 namespace ware::swapchainVK {
 
-[[nodiscard]] std::tuple<vk::SurfaceFormatKHR, vk::PresentModeKHR, vk::UniqueSwapchainKHR, std::vector<ImageResources>, std::vector<FrameResources>> createSwapchain(const ware::config::State &config, const ware::windowGLFW::State &window, const ware::contextVK::State &context) {
+[[nodiscard]] std::tuple<vk::SurfaceFormatKHR, vk::PresentModeKHR, vk::UniqueSwapchainKHR, std::vector<ImageResources>> createSwapchain(const ware::config::State &config, const ware::windowGLFW::State &window, const ware::contextVK::State &context, vk::SwapchainKHR oldSwapchain) {
 	const auto surfaceFormats = context.physicalDevice.getSurfaceFormatsKHR(context.surface.get());
 	if (surfaceFormats.empty()) {
 		throw std::runtime_error{"Vulkan surface formats not available"};
@@ -87,7 +86,7 @@ namespace ware::swapchainVK {
 		.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
 		.presentMode = presentMode,
 		.clipped = VK_TRUE,
-		.oldSwapchain = vk::SwapchainKHR{}
+		.oldSwapchain = oldSwapchain,
 	});
 
 	auto images = context.device->getSwapchainImagesKHR(swapchain.get());
@@ -109,60 +108,162 @@ namespace ware::swapchainVK {
 		});
 
 		return ImageResources{
+			.offscreenImage = {},
 			.image = image,
 			.imageView = std::move(imageView),
 			.presentSemaphore = context.device->createSemaphoreUnique({}),
 		};
 	});
 
-	std::vector<FrameResources> frameResources = util::mapRange(images.size(), [&] ([[maybe_unused]] size_t index) {
-		// auto renderingCommandPool = context.device->createCommandPoolUnique({
-		// 	.flags = vk::CommandPoolCreateFlagBits::eTransient,
-		// 	.queueFamilyIndex = context.graphicQueueFamily,
-		// });
+	return { surfaceFormat, presentMode, std::move(swapchain), std::move(imageResources) };
+}
+
+[[nodiscard]] std::tuple<vk::SurfaceFormatKHR, vk::PresentModeKHR, vk::UniqueSwapchainKHR, std::vector<ImageResources>> createOffscreenImages(const ware::config::State &config, const ware::windowGLFW::State &window, ware::contextVK::State &context, uint32_t imageCount) {
+	vk::SurfaceFormatKHR surfaceFormat{
+		.format = config.vk.surfaceFormat == vk::Format::eUndefined ? vk::Format::eB8G8R8A8Unorm : config.vk.surfaceFormat,
+		.colorSpace = config.vk.surfaceColorSpace,
+	};
+
+	vk::Extent3D imageExtent{
+		.width = static_cast<uint32_t>(std::max(1, window.description->width)),
+		.height = static_cast<uint32_t>(std::max(1, window.description->height)),
+		.depth = 1,
+	};
+
+	spdlog::debug("ware::swapchainVK::createOffscreenImages() => created offscreen images (image count: {}, format: {}, extent: {}x{})", imageCount, vk::to_string(surfaceFormat.format), imageExtent.width, imageExtent.height);
+
+	std::vector<ImageResources> imageResources = util::mapRange(imageCount, [&] ([[maybe_unused]] size_t index) {
+		vk::ImageCreateInfo imageCreateInfo{
+			.imageType = vk::ImageType::e2D,
+			.format = surfaceFormat.format,
+			.extent = imageExtent,
+			.mipLevels = 1,
+			.arrayLayers = 1,
+			.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eTransferSrc,
+			.sharingMode = vk::SharingMode::eExclusive,
+			.initialLayout = vk::ImageLayout::eUndefined,
+		};
+		vma::AllocationCreateInfo allocationCreateInfo{
+			.usage = vma::MemoryUsage::eAutoPreferDevice,
+		};
+
+		auto offscreenImage = ware::contextVK::createImage(context, imageCreateInfo, allocationCreateInfo);
+
+		vk::UniqueImageView imageView = context.device->createImageViewUnique({
+			.image = offscreenImage->image,
+			.viewType = vk::ImageViewType::e2D,
+			.format = surfaceFormat.format,
+			.subresourceRange = {
+				.aspectMask = vk::ImageAspectFlagBits::eColor,
+				.baseMipLevel = 0,
+				.levelCount = 1,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+		});
+
+		const auto image = offscreenImage->image;
+
+		return ImageResources{
+			.offscreenImage = std::move(offscreenImage),
+			.image = image,
+			.imageView = std::move(imageView),
+			.presentSemaphore = {},
+		};
+	});
+
+	return { surfaceFormat, config.vk.swapchainPresentMode, vk::UniqueSwapchainKHR{}, std::move(imageResources) };
+}
 
-		// std::vector<vk::CommandBuffer> commandBuffers = context.device->allocateCommandBuffers({
-		// 	.commandPool = renderingCommandPool.get(),
-		// 	.level = vk::CommandBufferLevel::ePrimary,
-		// 	.commandBufferCount = 1,
-		// });
+[[nodiscard]] std::vector<FrameResources> createFrameResources(const ware::config::State &config, const ware::contextVK::State &context) {
+	// decoupled from the swapchain image count, more images only give the presentation engine slack, more frames in flight add CPU run-ahead
+	const uint32_t framesInFlight = config.vk.framesInFlight > 0 ? static_cast<uint32_t>(config.vk.framesInFlight) : 2;
 
+	spdlog::debug("ware::swapchainVK::createFrameResources() => frames in flight: {}", framesInFlight);
+
+	return util::mapRange(framesInFlight, [&] ([[maybe_unused]] size_t index) {
 		return FrameResources{
-			.renderingFence = context.device->createFenceUnique({
-				.flags = vk::FenceCreateFlagBits::eSignaled,
-			}),
+			.frameValue = 0,
+			.startTimePoint = {},
+			.latencyPending = false,
 			.acquireSemaphore = context.device->createSemaphoreUnique({}),
-			// .renderingCommandPool = std::move(renderingCommandPool),
-			// .renderingCommandBuffer = commandBuffers[0],
 		};
 	});
-
-	return { surfaceFormat, presentMode, std::move(swapchain), std::move(imageResources), std::move(frameResources) };
 }
 
 void recreateSwapchain(State &state) {
+	ZoneScopedN("ware::swapchainVK::recreateSwapchain()");
+
 	const auto &config = state.config;
 	const auto &window = state.window;
 	auto &context = state.context;
 
-	ware::contextVK::requestWaitIdle(context);
+	const auto startTimePoint = std::chrono::steady_clock::now();
 
-	state.frameResources.clear();
-	state.imageResources.clear();
-	state.swapchain.reset();
+	auto [surfaceFormat, presentMode, swapchain, imageResources] = state.headless
+		? createOffscreenImages(config, window, context, state.framesInFlight)
+		: createSwapchain(config, window, context, state.swapchain.get());
 
-	auto [surfaceFormat, presentMode, swapchain, imageResources, frameResources] = createSwapchain(config, window, context);
+	// images of the old swapchain may still be rendered to or presented by frames in flight; the presentation engine gives no
+	// completion signal, so the old swapchain outlives a full cycle of frame slots after the current frame
+	state.retiredSwapchains.push_back(RetiredSwapchain{
+		.frameValue = context.frameValue + state.framesInFlight,
+		.swapchain = std::move(state.swapchain),
+		.imageResources = std::move(state.imageResources),
+	});
 
 	state.surfaceFormat = surfaceFormat;
 	state.presentMode = presentMode;
 	state.swapchain = std::move(swapchain);
 	state.imageResources = std::move(imageResources);
 	state.imageIndex = 0;
-	state.frameResources = std::move(frameResources);
-	state.frameIndex = 0;
+
+	const std::chrono::duration<double, std::milli> stall = std::chrono::steady_clock::now() - startTimePoint;
+
+	auto &statistics = state.recreateStatistics;
+	statistics.count++;
+	statistics.last = stall;
+	statistics.total += stall;
+	statistics.max = std::max(statistics.max, stall);
+
+	spdlog::debug("ware::swapchainVK::recreateSwapchain() => recreated swapchain in {:.3f}ms (retired swapchains: {})", stall.count(), state.retiredSwapchains.size());
+	TracyPlot("swapchain recreate stall [ms]", stall.count());
+}
+
+void destroyRetiredSwapchains(State &state) {
+	auto &context = state.context;
+
+	std::erase_if(state.retiredSwapchains, [&] (const auto &retiredSwapchain) {
+		return ware::contextVK::isFrameRetired(context, retiredSwapchain.frameValue);
+	});
+}
+
+void measureLatency(State &state, std::chrono::steady_clock::time_point now) {
+	auto &context = state.context;
+
+	for (auto &frameResources : state.frameResources) {
+		if ( ! frameResources.latencyPending || ! ware::contextVK::isFrameRetired(context, frameResources.frameValue)) {
+			continue;
+		}
+
+		// from the start of the frame on the CPU until its GPU work is seen completed, the present is not part of it,
+		// retirement is only checked once per frame, so this rounds up to whole frames
+		const std::chrono::duration<double, std::milli> latency = now - frameResources.startTimePoint;
+		state.latency = state.latency.count() > 0.0 ? state.latency * 0.9 + latency * 0.1 : latency;
+
+		frameResources.latencyPending = false;
+	}
+
+	TracyPlot("CPU to GPU completion latency [ms]", state.latency.count());
 }
 
 void acquireNextImage(State &state) {
+	// one offscreen image per frame slot, the wait for the slot also covers its image
+	if (state.headless) {
+		state.imageIndex = state.frameIndex;
+		return;
+	}
+
 	const auto &context = state.context;
 	const auto &swapchain = state.swapchain.get();
 	const auto &frameResources = state.frameResources[state.frameIndex];
@@ -255,6 +356,10 @@ void acquireNextImage(State &state) {
 // }
 
 void presentImage(State &state) {
+	if (state.headless) {
+		return;
+	}
+
 	const auto &context = state.context;
 	const auto &swapchain = state.swapchain.get();
 	const auto &imageResources = state.imageResources[state.imageIndex];
@@ -279,23 +384,45 @@ void presentImage(State &state) {
 }
 
 State::~State() {
-	ware::contextVK::requestWaitIdle(context);
+	if (recreateStatistics.count > 0) {
+		spdlog::info("ware::swapchainVK::~State() => swapchain recreated {} time(s), stall per recreate: avg {:.3f}ms, max {:.3f}ms", recreateStatistics.count, recreateStatistics.total.count() / recreateStatistics.count, recreateStatistics.max.count());
+	}
+
+	ware::contextVK::deferDestroy(context, context.frameValue, std::move(frameResources), std::move(imageResources), std::move(swapchain), std::move(retiredSwapchains));
 }
 
 State setup(ware::config::State &config, ware::windowGLFW::State &window, ware::contextVK::State &context) {
-	auto [surfaceFormat, presentMode, swapchain, imageResources, frameResources] = createSwapchain(config, window, context);
+	const bool headless = config.window.headless;
+
+	auto frameResources = createFrameResources(config, context);
+
+	auto [surfaceFormat, presentMode, swapchain, imageResources] = headless
+		? createOffscreenImages(config, window, context, static_cast<uint32_t>(frameResources.size()))
+		: createSwapchain(config, window, context, vk::SwapchainKHR{});
 
 	return State{
 		.config = config,
 		.window = window,
 		.context = context,
+		.headless = headless,
+		// offscreen images stay readable for captures and readbacks
+		.finalLayout = headless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR,
 		.surfaceFormat = surfaceFormat,
 		.presentMode = presentMode,
 		.swapchain = std::move(swapchain),
 		.imageResources = std::move(imageResources),
 		.imageIndex = 0,
+		.retiredSwapchains = {},
+		.recreateStatistics = {
+			.count = 0,
+			.last = {},
+			.total = {},
+			.max = {},
+		},
+		.framesInFlight = static_cast<uint32_t>(frameResources.size()),
 		.frameResources = std::move(frameResources),
 		.frameIndex = 0,
+		.latency = {},
 		.description = {
 			.width = window.description->width,
 			.height = window.description->height,
@@ -309,8 +436,10 @@ State setup(ware::config::State &config, ware::windowGLFW::State &window, ware::
 void refresh(State &state) {
 	ZoneScopedN("ware::swapchainVK::refresh()");
 
+	const auto startTimePoint = std::chrono::steady_clock::now();
+
 	const auto &window = state.window;
-	const auto &context = state.context;
+	auto &context = state.context;
 
 	if (window.description->changed && (state.description.width != window.description->width || state.description.height != window.description->height || state.description.mode != window.description->mode)) {
 		recreateSwapchain(state);
@@ -325,14 +454,18 @@ void refresh(State &state) {
 	}
 
 	{
-		const auto &frameResources = state.frameResources[state.frameIndex];
+		auto &frameResources = state.frameResources[state.frameIndex];
 
-		vk::Result waitResult;
-		while ((waitResult = context.device->waitForFences({ frameResources.renderingFence.get() }, true, std::numeric_limits<uint64_t>::max())) != vk::Result::eSuccess) {
-			spdlog::debug("ware::swapchainVK::refresh() => retrying wait for rendering fence (result: {}, frame index: {})", vk::to_string(waitResult), state.frameIndex);
-		}
+		// the previous frame that used this slot has to retire before its semaphores and command buffers are reused
+		ware::contextVK::waitForFrame(context, frameResources.frameValue);
+
+		measureLatency(state, std::chrono::steady_clock::now());
+
+		destroyRetiredSwapchains(state);
 
-		context.device->resetFences({ frameResources.renderingFence.get() });
+		frameResources.frameValue = context.frameValue;
+		frameResources.startTimePoint = startTimePoint;
+		frameResources.latencyPending = true;
 	}
 
 	acquireNextImage(state);
@@ -1,23 +1,42 @@
 #pragma once
 
+#include <chrono>
+
 #include "../config/config.hpp"
 #include "../contextVK/contextVK.hpp"
 
 namespace ware::swapchainVK {
 
 struct ImageResources {
+	// owns the image in headless mode, declared first so that the view goes before the image; empty for swapchain images
+	ware::contextVK::UniqueImage offscreenImage;
 	vk::Image image;
 	vk::UniqueImageView imageView;
 	vk::UniqueSemaphore presentSemaphore;
 };
 
 struct FrameResources {
-	vk::UniqueFence renderingFence;
+	uint64_t frameValue;
+	std::chrono::steady_clock::time_point startTimePoint;
+	bool latencyPending;
 	vk::UniqueSemaphore acquireSemaphore;
 	// vk::UniqueCommandPool renderingCommandPool;
 	// vk::CommandBuffer renderingCommandBuffer;
 };
 
+struct RetiredSwapchain {
+	uint64_t frameValue;
+	vk::UniqueSwapchainKHR swapchain;
+	std::vector<ImageResources> imageResources;
+};
+
+struct RecreateStatistics {
+	uint32_t count;
+	std::chrono::duration<double, std::milli> last;
+	std::chrono::duration<double, std::milli> total;
+	std::chrono::duration<double, std::milli> max;
+};
+
 struct Description {
 	int32_t width;
 	int32_t height;
@@ -30,13 +49,22 @@ struct State {
 	ware::config::State &config;
 	ware::windowGLFW::State &window;
 	ware::contextVK::State &context;
+	// headless rendering cycles through offscreen images in place of a swapchain and never presents
+	bool headless;
+	// layout the last pass leaves the image in
+	vk::ImageLayout finalLayout;
 	vk::SurfaceFormatKHR surfaceFormat;
 	vk::PresentModeKHR presentMode;
 	vk::UniqueSwapchainKHR swapchain;
 	std::vector<ImageResources> imageResources;
 	uint32_t imageIndex;
+	std::vector<RetiredSwapchain> retiredSwapchains;
+	RecreateStatistics recreateStatistics;
+	uint32_t framesInFlight;
 	std::vector<FrameResources> frameResources;
 	uint32_t frameIndex;
+	// smoothed time from frame start until the frame's timeline value retired, rounded up to whole frames
+	std::chrono::duration<double, std::milli> latency;
 	Description description;
 
 	~State();
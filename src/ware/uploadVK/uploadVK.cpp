@@ -0,0 +1,437 @@
+#include "uploadVK.hpp"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <utility>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+#include <tracy/Tracy.hpp>
+
+namespace ware::uploadVK {
+
+vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+[[nodiscard]] ware::contextVK::UniqueBuffer createStagingBuffer(ware::contextVK::State &context, vk::DeviceSize size) {
+	vk::BufferCreateInfo stagingBufferCreateInfo{
+		.size = size,
+		.usage = vk::BufferUsageFlagBits::eTransferSrc,
+	};
+	vma::AllocationCreateInfo stagingAllocationCreateInfo{
+		.flags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
+		.usage = vma::MemoryUsage::eAutoPreferHost,
+		.requiredFlags = vk::MemoryPropertyFlagBits::eHostVisible,
+	};
+
+	return ware::contextVK::createBuffer(context, stagingBufferCreateInfo, stagingAllocationCreateInfo);
+}
+
+[[nodiscard]] Batch createBatch(ware::contextVK::State &context) {
+	auto commandPool = context.device->createCommandPoolUnique({
+		.flags = vk::CommandPoolCreateFlagBits::eTransient,
+		.queueFamilyIndex = context.transferQueueFamily,
+	});
+
+	std::vector<vk::CommandBuffer> commandBuffers = context.device->allocateCommandBuffers({
+		.commandPool = commandPool.get(),
+		.level = vk::CommandBufferLevel::ePrimary,
+		.commandBufferCount = 1,
+	});
+
+	return Batch{
+		.commandPool = std::move(commandPool),
+		.commandBuffer = commandBuffers[0],
+		.uploadValue = 0,
+		.stagingEnd = 0,
+	};
+}
+
+bool isUploadComplete(State &state, uint64_t uploadValue) {
+	if (uploadValue <= state.completedValue) {
+		return true;
+	}
+
+	state.completedValue = state.context.device->getSemaphoreCounterValue(state.uploadTimeline.get());
+
+	return uploadValue <= state.completedValue;
+}
+
+void waitForUpload(State &state, uint64_t uploadValue) {
+	if (isUploadComplete(state, uploadValue)) {
+		return;
+	}
+
+	ZoneScopedN("ware::uploadVK::waitForUpload()");
+
+	const auto uploadTimeline = state.uploadTimeline.get();
+
+	vk::Result waitResult;
+	while ((waitResult = state.context.device->waitSemaphores({ .semaphoreCount = 1, .pSemaphores = &uploadTimeline, .pValues = &uploadValue }, std::numeric_limits<uint64_t>::max())) != vk::Result::eSuccess) {
+		spdlog::debug("ware::uploadVK::waitForUpload() => retrying wait for upload timeline (result: {}, upload value: {})", vk::to_string(waitResult), uploadValue);
+	}
+
+	state.completedValue = std::max(state.completedValue, uploadValue);
+}
+
+void reclaimStaging(State &state) {
+	while ( ! state.submittedBatches.empty() && isUploadComplete(state, state.submittedBatches.front().uploadValue)) {
+		state.stagingTail = state.submittedBatches.front().stagingEnd;
+		state.idleBatches.push_back(std::move(state.submittedBatches.front()));
+		state.submittedBatches.pop_front();
+	}
+}
+
+// returns the offset into the staging buffer, blocks on the oldest batch if the ring is full
+vk::DeviceSize allocateStaging(State &state, vk::DeviceSize size) {
+	if (size > state.stagingSize) {
+		throw std::runtime_error{fmt::format("Upload of {} bytes exceeds the staging ring (size: {})", size, state.stagingSize)};
+	}
+
+	const auto placement = [&] {
+		if ( ! state.recording && state.submittedBatches.empty()) {
+			// nothing in flight, restart at the beginning of the ring
+			state.stagingHead = state.stagingTail = alignUp(state.stagingHead, state.stagingSize);
+		}
+
+		auto offset = alignUp(state.stagingHead, state.stagingAlignment);
+		if (offset % state.stagingSize + size > state.stagingSize) {
+			offset = alignUp(offset, state.stagingSize);
+		}
+
+		return offset;
+	};
+
+	auto offset = placement();
+	while (offset + size - state.stagingTail > state.stagingSize) {
+		if (state.submittedBatches.empty()) {
+			// only the batch being recorded holds staging memory
+			submit(state);
+		}
+
+		waitForUpload(state, state.submittedBatches.front().uploadValue);
+		reclaimStaging(state);
+
+		offset = placement();
+	}
+
+	state.stagingHead = offset + size;
+
+	return offset % state.stagingSize;
+}
+
+vk::DeviceSize stageData(State &state, std::span<const std::byte> data) {
+	const auto stagingOffset = allocateStaging(state, data.size());
+
+	std::copy(data.begin(), data.end(), reinterpret_cast<std::byte *>(state.stagingBuffer->mappedData) + stagingOffset);
+
+	ware::contextVK::flushMappedData(state.stagingBuffer, stagingOffset, data.size());
+
+	return stagingOffset;
+}
+
+vk::CommandBuffer beginBatch(State &state) {
+	if (state.recording) {
+		return state.recordingBatch.commandBuffer;
+	}
+
+	auto &context = state.context;
+
+	if (state.idleBatches.empty()) {
+		state.recordingBatch = createBatch(context);
+	} else {
+		state.recordingBatch = std::move(state.idleBatches.back());
+		state.idleBatches.pop_back();
+
+		context.device->resetCommandPool(state.recordingBatch.commandPool.get());
+	}
+
+	state.recordingBatch.uploadValue = state.submittedValue + 1;
+	state.recordingBatch.commandBuffer.begin({
+		.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit,
+	});
+	state.recording = true;
+
+	return state.recordingBatch.commandBuffer;
+}
+
+uint64_t uploadBuffer(State &state, std::span<const std::byte> data, const BufferUpload &upload) {
+	ZoneScopedN("ware::uploadVK::uploadBuffer()");
+
+	std::scoped_lock lock{state.mutex};
+
+	const auto &context = state.context;
+
+	const auto stagingOffset = stageData(state, data);
+
+	auto cmd = beginBatch(state);
+
+	std::array regions{
+		vk::BufferCopy2{
+			.srcOffset = stagingOffset,
+			.dstOffset = upload.offset,
+			.size = data.size(),
+		},
+	};
+
+	cmd.copyBuffer2({
+		.srcBuffer = state.stagingBuffer->buffer,
+		.dstBuffer = upload.buffer,
+		.regionCount = static_cast<uint32_t>(regions.size()),
+		.pRegions = regions.data(),
+	});
+
+	// within one queue family the semaphore wait alone makes the copy visible
+	if (context.transferQueueFamily != context.graphicQueueFamily) {
+		std::array releaseBufferMemoryBarriers{
+			vk::BufferMemoryBarrier2{
+				.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+				.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+				.dstStageMask = vk::PipelineStageFlagBits2::eNone,
+				.dstAccessMask = vk::AccessFlagBits2::eNone,
+				.srcQueueFamilyIndex = context.transferQueueFamily,
+				.dstQueueFamilyIndex = context.graphicQueueFamily,
+				.buffer = upload.buffer,
+				.offset = upload.offset,
+				.size = data.size(),
+			},
+		};
+		cmd.pipelineBarrier2({
+			.bufferMemoryBarrierCount = static_cast<uint32_t>(releaseBufferMemoryBarriers.size()),
+			.pBufferMemoryBarriers = releaseBufferMemoryBarriers.data(),
+		});
+
+		state.acquire.bufferMemoryBarriers.push_back(vk::BufferMemoryBarrier2{
+			.srcStageMask = vk::PipelineStageFlagBits2::eNone,
+			.srcAccessMask = vk::AccessFlagBits2::eNone,
+			.dstStageMask = upload.dstStageMask,
+			.dstAccessMask = upload.dstAccessMask,
+			.srcQueueFamilyIndex = context.transferQueueFamily,
+			.dstQueueFamilyIndex = context.graphicQueueFamily,
+			.buffer = upload.buffer,
+			.offset = upload.offset,
+			.size = data.size(),
+		});
+	}
+
+	state.acquire.stageMask |= upload.dstStageMask;
+
+	return state.recordingBatch.uploadValue;
+}
+
+uint64_t uploadImage(State &state, std::span<const std::byte> data, const ImageUpload &upload) {
+	ZoneScopedN("ware::uploadVK::uploadImage()");
+
+	std::scoped_lock lock{state.mutex};
+
+	const auto &context = state.context;
+
+	const auto stagingOffset = stageData(state, data);
+
+	auto cmd = beginBatch(state);
+
+	vk::ImageSubresourceRange subresourceRange{
+		.aspectMask = upload.aspectMask,
+		.baseMipLevel = 0,
+		.levelCount = 1,
+		.baseArrayLayer = 0,
+		.layerCount = 1,
+	};
+
+	std::array preImageMemoryBarriers{
+		vk::ImageMemoryBarrier2{
+			.srcStageMask = vk::PipelineStageFlagBits2::eNone,
+			.srcAccessMask = vk::AccessFlagBits2::eNone,
+			.dstStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.oldLayout = vk::ImageLayout::eUndefined,
+			.newLayout = vk::ImageLayout::eTransferDstOptimal,
+			.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+			.image = upload.image,
+			.subresourceRange = subresourceRange,
+		},
+	};
+	cmd.pipelineBarrier2({
+		.imageMemoryBarrierCount = static_cast<uint32_t>(preImageMemoryBarriers.size()),
+		.pImageMemoryBarriers = preImageMemoryBarriers.data(),
+	});
+
+	std::array regions{
+		vk::BufferImageCopy2{
+			.bufferOffset = stagingOffset,
+			.bufferRowLength = 0, // tightly packed
+			.bufferImageHeight = 0, // tightly packed
+			.imageSubresource = {
+				.aspectMask = upload.aspectMask,
+				.mipLevel = 0,
+				.baseArrayLayer = 0,
+				.layerCount = 1,
+			},
+			.imageOffset = {},
+			.imageExtent = upload.extent,
+		},
+	};
+
+	cmd.copyBufferToImage2({
+		.srcBuffer = state.stagingBuffer->buffer,
+		.dstImage = upload.image,
+		.dstImageLayout = vk::ImageLayout::eTransferDstOptimal,
+		.regionCount = static_cast<uint32_t>(regions.size()),
+		.pRegions = regions.data(),
+	});
+
+	const bool transferOwnership = context.transferQueueFamily != context.graphicQueueFamily;
+
+	// the layout transition to finalLayout is part of the release, so the acquire has to repeat it
+	std::array postImageMemoryBarriers{
+		vk::ImageMemoryBarrier2{
+			.srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+			.srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+			.dstStageMask = vk::PipelineStageFlagBits2::eNone,
+			.dstAccessMask = vk::AccessFlagBits2::eNone,
+			.oldLayout = vk::ImageLayout::eTransferDstOptimal,
+			.newLayout = upload.finalLayout,
+			.srcQueueFamilyIndex = transferOwnership ? context.transferQueueFamily : VK_QUEUE_FAMILY_IGNORED,
+			.dstQueueFamilyIndex = transferOwnership ? context.graphicQueueFamily : VK_QUEUE_FAMILY_IGNORED,
+			.image = upload.image,
+			.subresourceRange = subresourceRange,
+		},
+	};
+	cmd.pipelineBarrier2({
+		.imageMemoryBarrierCount = static_cast<uint32_t>(postImageMemoryBarriers.size()),
+		.pImageMemoryBarriers = postImageMemoryBarriers.data(),
+	});
+
+	if (transferOwnership) {
+		state.acquire.imageMemoryBarriers.push_back(vk::ImageMemoryBarrier2{
+			.srcStageMask = vk::PipelineStageFlagBits2::eNone,
+			.srcAccessMask = vk::AccessFlagBits2::eNone,
+			.dstStageMask = upload.dstStageMask,
+			.dstAccessMask = upload.dstAccessMask,
+			.oldLayout = vk::ImageLayout::eTransferDstOptimal,
+			.newLayout = upload.finalLayout,
+			.srcQueueFamilyIndex = context.transferQueueFamily,
+			.dstQueueFamilyIndex = context.graphicQueueFamily,
+			.image = upload.image,
+			.subresourceRange = subresourceRange,
+		});
+	}
+
+	state.acquire.stageMask |= upload.dstStageMask;
+
+	return state.recordingBatch.uploadValue;
+}
+
+void submit(State &state) {
+	if ( ! state.recording) {
+		return;
+	}
+
+	ZoneScopedN("ware::uploadVK::submit()");
+
+	const auto &context = state.context;
+	auto &batch = state.recordingBatch;
+
+	batch.commandBuffer.end();
+	batch.stagingEnd = state.stagingHead;
+
+	vk::CommandBufferSubmitInfo commandBufferInfo{
+		.commandBuffer = batch.commandBuffer,
+	};
+	vk::SemaphoreSubmitInfo signalSemaphoreInfo{
+		.semaphore = state.uploadTimeline.get(),
+		.value = batch.uploadValue,
+		.stageMask = vk::PipelineStageFlagBits2::eAllCommands,
+	};
+	context.transferQueue.submit2({
+		{
+			.commandBufferInfoCount = 1,
+			.pCommandBufferInfos = &commandBufferInfo,
+			.signalSemaphoreInfoCount = 1,
+			.pSignalSemaphoreInfos = &signalSemaphoreInfo,
+		}
+	});
+
+	state.submittedValue = batch.uploadValue;
+	state.acquire.uploadValue = batch.uploadValue;
+	state.submittedBatches.push_back(std::move(batch));
+	state.recording = false;
+}
+
+Acquire takeAcquire(State &state) {
+	std::scoped_lock lock{state.mutex};
+
+	submit(state);
+
+	return std::exchange(state.acquire, Acquire{
+		.uploadValue = 0,
+		.stageMask = vk::PipelineStageFlagBits2::eNone,
+		.bufferMemoryBarriers = {},
+		.imageMemoryBarriers = {},
+	});
+}
+
+State::~State() {
+	if (recording) {
+		recordingBatch.commandBuffer.end();
+	}
+
+	waitForUpload(*this, submittedValue);
+}
+
+State setup(ware::config::State &config, ware::contextVK::State &context) {
+	const vk::DeviceSize stagingSize = config.vk.uploadStagingSize;
+
+	auto stagingBuffer = createStagingBuffer(context, stagingSize);
+
+	auto uploadTimeline = ware::contextVK::createTimelineSemaphore(context.device.get());
+
+	// 4 bytes and a multiple of the texel size are required for image copies, 16 covers every uncompressed format
+	const vk::DeviceSize stagingAlignment = std::max<vk::DeviceSize>(16, context.physicalDeviceProperties2.properties.limits.optimalBufferCopyOffsetAlignment);
+
+	spdlog::debug("ware::uploadVK::setup() => staging ring created (size: {}, transfer queue family: {}, graphic queue family: {})", stagingSize, context.transferQueueFamily, context.graphicQueueFamily);
+
+	return State{
+		.context = context,
+		.mutex = {},
+		.stagingBuffer = std::move(stagingBuffer),
+		.stagingSize = stagingSize,
+		.stagingAlignment = stagingAlignment,
+		.stagingHead = 0,
+		.stagingTail = 0,
+		.uploadTimeline = std::move(uploadTimeline),
+		.submittedValue = 0,
+		.completedValue = 0,
+		.recording = false,
+		.recordingBatch = {},
+		.submittedBatches = {},
+		.idleBatches = {},
+		.acquire = {
+			.uploadValue = 0,
+			.stageMask = vk::PipelineStageFlagBits2::eNone,
+			.bufferMemoryBarriers = {},
+			.imageMemoryBarriers = {},
+		},
+	};
+}
+
+void refresh(State &state) {
+	ZoneScopedN("ware::uploadVK::refresh()");
+
+	std::scoped_lock lock{state.mutex};
+
+	reclaimStaging(state);
+}
+
+void process(State &state) {
+	ZoneScopedN("ware::uploadVK::process()");
+
+	std::scoped_lock lock{state.mutex};
+
+	submit(state);
+}
+
+} // ware::uploadVK
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "../config/config.hpp"
+#include "../contextVK/contextVK.hpp"
+
+namespace ware::uploadVK {
+
+struct Batch {
+	vk::UniqueCommandPool commandPool;
+	vk::CommandBuffer commandBuffer;
+	uint64_t uploadValue;
+	vk::DeviceSize stagingEnd;
+};
+
+// barriers the graphic queue has to record, after waiting for uploadValue, before it can use the uploaded resources
+struct Acquire {
+	uint64_t uploadValue;
+	vk::PipelineStageFlags2 stageMask;
+	std::vector<vk::BufferMemoryBarrier2> bufferMemoryBarriers;
+	std::vector<vk::ImageMemoryBarrier2> imageMemoryBarriers;
+};
+
+struct State {
+	ware::contextVK::State &context;
+	// pass setups run as jobs and upload side by side
+	std::mutex mutex;
+	ware::contextVK::UniqueBuffer stagingBuffer;
+	vk::DeviceSize stagingSize;
+	vk::DeviceSize stagingAlignment;
+	// head and tail grow monotonically, the ring offset is their value modulo stagingSize
+	vk::DeviceSize stagingHead;
+	vk::DeviceSize stagingTail;
+	vk::UniqueSemaphore uploadTimeline;
+	uint64_t submittedValue;
+	uint64_t completedValue;
+	bool recording;
+	Batch recordingBatch;
+	std::deque<Batch> submittedBatches;
+	std::vector<Batch> idleBatches;
+	Acquire acquire;
+
+	~State();
+};
+
+struct BufferUpload {
+	vk::Buffer buffer;
+	vk::DeviceSize offset;
+	vk::PipelineStageFlags2 dstStageMask;
+	vk::AccessFlags2 dstAccessMask;
+};
+
+struct ImageUpload {
+	vk::Image image;
+	vk::Extent3D extent;
+	vk::ImageAspectFlags aspectMask;
+	vk::ImageLayout finalLayout;
+	vk::PipelineStageFlags2 dstStageMask;
+	vk::AccessFlags2 dstAccessMask;
+};
+
+// both return the upload timeline value the copy is complete at, callable from any thread
+uint64_t uploadBuffer(State &state, std::span<const std::byte> data, const BufferUpload &upload);
+uint64_t uploadImage(State &state, std::span<const std::byte> data, const ImageUpload &upload);
+
+bool isUploadComplete(State &state, uint64_t uploadValue);
+
+// submits the recorded batch to the transfer queue
+void submit(State &state);
+
+// submits the recorded batch and hands the acquisition of everything uploaded so far over to the graphic queue
+[[nodiscard]] Acquire takeAcquire(State &state);
+
+State setup(ware::config::State &config, ware::contextVK::State &context);
+
+void refresh(State &state);
+
+void process(State &state);
+
+} // ware::uploadVK
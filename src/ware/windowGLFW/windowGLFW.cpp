@@ -290,6 +290,11 @@ void unregisterOnChar(CallbackHandle::Type handle) {
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
+	// headless rendering never presents, on the null platform the window only carries size and input for the rest of the modules
+	if (config.window.headless) {
+		glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	}
+
 	GLFWmonitor *monitor = nullptr;
 	int index = config.window.monitor;
 
@@ -301,7 +306,7 @@ void unregisterOnChar(CallbackHandle::Type handle) {
 		}
 		case WindowMode::Windowed: {
 			glfwWindowHint(GLFW_DECORATED, GL_TRUE);
-			glfwWindowHint(GLFW_RESIZABLE, GL_TRUE);
+			glfwWindowHint(GLFW_RESIZABLE, config.window.resizable ? GL_TRUE : GL_FALSE);
 			break;
 		}
 		case WindowMode::Fullscreen: {
@@ -456,9 +461,35 @@ State setup(ware::config::State &config, [[maybe_unused]] ware::contextGLFW::Sta
 		.previousDescription = std::move(previousDescription),
 		.window = std::move(window),
 		.refreshTimePoint = glfwGetTime(),
+		.resizeChurn = {
+			.interval = config.benchmark.resizeChurnInterval,
+			.width = config.window.width,
+			.height = config.window.height,
+			.counter = 0,
+		},
 	};
 }
 
+void churnSize(State &state) {
+	auto &resizeChurn = state.resizeChurn;
+
+	if (resizeChurn.interval == 0 || state.description->mode == WindowMode::Fullscreen) {
+		return;
+	}
+
+	resizeChurn.counter++;
+
+	if (resizeChurn.counter % resizeChurn.interval != 0) {
+		return;
+	}
+
+	// alternate between the configured size and three quarters of it
+	const bool shrink = (resizeChurn.counter / resizeChurn.interval) % 2 == 1;
+	state.description->width = shrink ? resizeChurn.width * 3 / 4 : resizeChurn.width;
+	state.description->height = shrink ? resizeChurn.height * 3 / 4 : resizeChurn.height;
+	state.description->changed = true;
+}
+
 void refresh(State &state) {
 	ZoneScopedN("ware::windowGLFW::refresh()");
 
@@ -469,6 +500,8 @@ void refresh(State &state) {
 
 	auto *window = state.window.get();
 
+	churnSize(state);
+
 	{
 		double dt = (glfwGetTime() - state.refreshTimePoint) * 1000.0;
 		state.description->title = fmt::format("{:.3f}ms {:.2f}fps", dt, dt > 0.0 ? 1000.0 / dt : 0.0);
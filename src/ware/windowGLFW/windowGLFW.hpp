@@ -32,6 +32,13 @@ struct Description {
 	bool changed;
 };
 
+struct ResizeChurn {
+	uint32_t interval;
+	int32_t width;
+	int32_t height;
+	uint64_t counter;
+};
+
 struct State {
 	std::unique_ptr<Callbacks> callbacks;
 	std::unique_ptr<Description> description;
@@ -39,6 +46,7 @@ struct State {
 	std::unique_ptr<GLFWwindow, decltype(&glfwDestroyWindow)> window;
 
 	double refreshTimePoint;
+	ResizeChurn resizeChurn;
 	bool shouldClose = false;
 
 	~State();